@@ -0,0 +1,55 @@
+#ifndef BETTERSCROBBLER_APIREQUEST_H
+#define BETTERSCROBBLER_APIREQUEST_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Signed Last.fm API request over a small sorted flat array of parameters.
+ * Keys and values are views, so the strings they refer to must outlive the request.
+ * Signing and form encoding happen in a single pass into a caller-owned buffer,
+ * which keeps its capacity between requests.
+ */
+class ApiRequest {
+public:
+    static constexpr size_t MAX_PARAMS = 12;
+
+    explicit ApiRequest(std::string_view method);
+
+    /**
+     * @brief Add or replace a parameter, keeping the array sorted by key.
+     * @return false if the request is already full; the parameter is not added.
+     */
+    [[nodiscard]] bool set(std::string_view key, std::string_view value);
+    [[nodiscard]] bool set(std::string_view key, int64_t value);
+
+    /**
+     * @brief Write "key=value&..." into out, followed by api_sig and format=json.
+     * Parameters are fed to MD5 in sorted order while they are encoded,
+     * then the shared secret is appended to the digest input.
+     */
+    void encodeSigned(std::string &out, std::string_view apiSecret) const;
+
+    [[nodiscard]] size_t size() const { return count; }
+
+    static void appendFormEncoded(std::string &out, std::string_view input);
+
+private:
+    struct Param {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    // One per parameter, so a number never fails to fit where a string would
+    static constexpr size_t MAX_NUMBERS = MAX_PARAMS;
+    static constexpr size_t NUMBER_LENGTH = 24;
+
+    std::array<Param, MAX_PARAMS> params{};
+    size_t count = 0;
+    char numbers[MAX_NUMBERS][NUMBER_LENGTH]{};
+    size_t numberCount = 0;
+};
+
+#endif //BETTERSCROBBLER_APIREQUEST_H
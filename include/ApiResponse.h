@@ -0,0 +1,87 @@
+#ifndef BETTERSCROBBLER_APIRESPONSE_H
+#define BETTERSCROBBLER_APIRESPONSE_H
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../lib/json.hpp"
+
+/**
+ * @brief Pulls scalar fields out of a JSON document with a SAX pass, without building a DOM.
+ * Paths are dotted keys, with "[]" standing for any array element,
+ * e.g. "results.trackmatches.track[].name".
+ */
+class JsonFieldExtractor {
+public:
+    /**
+     * @param field Index into the path list that matched
+     * @param element Index of the element in the innermost enclosing array, 0 outside arrays
+     * @param value String values verbatim, numbers and booleans formatted as text
+     */
+    using Callback = std::function<void(size_t field, size_t element, std::string_view value)>;
+
+    explicit JsonFieldExtractor(std::vector<std::string_view> paths) : paths(std::move(paths)) {}
+
+    /**
+     * @return false if the input is not valid JSON.
+     */
+    bool extract(std::string_view json, const Callback &callback) const;
+
+private:
+    std::vector<std::string_view> paths;
+};
+
+/**
+ * @brief A Last.fm API response. One SAX pass on construction pulls out every field the app reads:
+ * the error fields, the auth token and session key, and track.search matches.
+ * The full DOM is only built if a caller asks for something else, and then only once.
+ */
+class ApiResponse {
+public:
+    struct TrackMatch {
+        std::string name;
+        std::string artist;
+        int listeners = 0;
+    };
+
+    ApiResponse() = default;
+    explicit ApiResponse(std::string body);
+
+    [[nodiscard]] bool ok() const { return validJson && errorCode == 0; }
+    [[nodiscard]] bool empty() const { return body.empty(); }
+    [[nodiscard]] bool isJson() const { return validJson; }
+    [[nodiscard]] bool hasError() const { return errorCode != 0; }
+    [[nodiscard]] int getErrorCode() const { return errorCode; }
+    [[nodiscard]] const std::string &getErrorMessage() const { return errorMessage; }
+    [[nodiscard]] const std::string &getBody() const { return body; }
+
+    /**
+     * @brief Parsed DOM, built on first use. Null if the body is not valid JSON.
+     */
+    const nlohmann::json &document() const;
+
+    /**
+     * @brief results.trackmatches.track[].{name,artist,listeners} from a track.search response.
+     */
+    [[nodiscard]] const std::vector<TrackMatch> &trackMatches() const { return matches; }
+
+    /**
+     * @brief A single scalar field, e.g. "session.key". Empty if missing.
+     * "token" and "session.key" come from the constructor's pass; other paths fall back to document().
+     */
+    [[nodiscard]] std::string field(std::string_view path) const;
+
+private:
+    std::string body;
+    bool validJson = false;
+    int errorCode = 0;
+    std::string errorMessage;
+    std::string token;
+    std::string sessionKey;
+    std::vector<TrackMatch> matches;
+    mutable std::optional<nlohmann::json> dom;
+};
+
+#endif //BETTERSCROBBLER_APIRESPONSE_H
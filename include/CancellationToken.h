@@ -0,0 +1,50 @@
+#ifndef BETTERSCROBBLER_CANCELLATIONTOKEN_H
+#define BETTERSCROBBLER_CANCELLATIONTOKEN_H
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief Shared flag that asks in-flight work to give up. Copies observe the same flag.
+ * A default-constructed token can never be cancelled and costs no allocation.
+ */
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    static CancellationToken create() {
+        CancellationToken token;
+        token.state = std::make_shared<State>();
+        return token;
+    }
+
+    /**
+     * @brief New token that is cancelled on its own or whenever parent is.
+     */
+    static CancellationToken createChild(const CancellationToken &parent) {
+        CancellationToken token = create();
+        token.state->parent = parent.state;
+        return token;
+    }
+
+    void cancel() const {
+        if (state) state->cancelled.store(true, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool isCancelled() const {
+        for (const State *link = state.get(); link; link = link->parent.get()) {
+            if (link->cancelled.load(std::memory_order_acquire)) return true;
+        }
+        return false;
+    }
+
+private:
+    struct State {
+        std::atomic<bool> cancelled{false};
+        std::shared_ptr<State> parent;
+    };
+
+    std::shared_ptr<State> state;
+};
+
+#endif //BETTERSCROBBLER_CANCELLATIONTOKEN_H
@@ -0,0 +1,83 @@
+#ifndef BETTERSCROBBLER_CIRCUITBREAKER_H
+#define BETTERSCROBBLER_CIRCUITBREAKER_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "Clock.h"
+
+/**
+ * @brief Remembers that a host is down so callers fail fast instead of each paying the full retry ladder.
+ * CLOSED lets everything through. FAILURE_THRESHOLD transient failures in a row, or a Retry-After from the server,
+ * open the breaker; while OPEN every request is refused. Once the open period ends one probe is let through
+ * (HALF_OPEN): success closes the breaker, failure opens it again for twice as long, up to MAX_OPEN_MS.
+ */
+class CircuitBreaker {
+public:
+    enum class State {
+        CLOSED,
+        OPEN,
+        HALF_OPEN
+    };
+
+    /**
+     * @brief Process-wide breaker for the host part of url.
+     */
+    static CircuitBreaker &forUrl(const std::string &url);
+
+    explicit CircuitBreaker(std::string host, Clock &clock = Clock::getInstance());
+    CircuitBreaker(const CircuitBreaker &) = delete;
+    CircuitBreaker &operator=(const CircuitBreaker &) = delete;
+
+    /**
+     * @return false while open. In half-open, true for the single probe only.
+     */
+    bool allowRequest();
+
+    /**
+     * @return true if requests would be refused right now; unlike allowRequest() this claims no probe.
+     */
+    [[nodiscard]] bool isOpen() const;
+
+    void onSuccess();
+
+    /**
+     * @param retryAfterMs Server-requested pause, or -1. A pause opens the breaker at once for that long.
+     */
+    void onFailure(int64_t retryAfterMs = -1);
+
+    /**
+     * @brief The request was let through but ended without saying anything about the host, e.g. it was cancelled.
+     */
+    void onAbandoned();
+
+    [[nodiscard]] State getState() const;
+
+    /**
+     * @return Milliseconds until a probe will be allowed, 0 if requests go through now.
+     */
+    [[nodiscard]] int64_t msUntilRetry() const;
+
+    [[nodiscard]] uint64_t getRejectedCount() const;
+
+    static std::string hostOf(const std::string &url);
+
+    static constexpr int FAILURE_THRESHOLD = 5;
+    static constexpr int64_t BASE_OPEN_MS = 30000;
+    static constexpr int64_t MAX_OPEN_MS = 10 * 60 * 1000;
+
+private:
+    void open(int64_t durationMs);
+
+    std::string host;
+    Clock &clock;
+    mutable std::mutex mutex;
+    State state = State::CLOSED;
+    int consecutiveFailures = 0;
+    int64_t openUntilMs = 0;
+    int64_t nextOpenMs = BASE_OPEN_MS;
+    bool probeInFlight = false;
+    uint64_t rejectedCount = 0;
+};
+
+#endif //BETTERSCROBBLER_CIRCUITBREAKER_H
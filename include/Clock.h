@@ -0,0 +1,106 @@
+#ifndef BETTERSCROBBLER_CLOCK_H
+#define BETTERSCROBBLER_CLOCK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Time source for the whole process. Interval math uses the monotonic side, which never jumps
+ * on NTP or DST changes; wall time is only for timestamps sent to Last.fm.
+ */
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    /**
+     * @brief Monotonic milliseconds from an arbitrary epoch.
+     */
+    [[nodiscard]] virtual int64_t nowMs() const = 0;
+
+    /**
+     * @brief Unix time in seconds.
+     */
+    [[nodiscard]] virtual int64_t wallTimeSeconds() const = 0;
+
+    /**
+     * @brief Monotonic time in seconds, for the playback-position math that works in doubles.
+     */
+    [[nodiscard]] double nowSeconds() const { return static_cast<double>(nowMs()) / 1000.0; }
+
+    /**
+     * @brief Block the calling thread for ms of this clock's time.
+     */
+    virtual void sleepMs(int64_t ms) const = 0;
+
+    /**
+     * @brief Wait on condition for up to ms of this clock's time, returning early on a notify like wait_for.
+     * lock must hold the condition's mutex, and holds it again on return.
+     */
+    virtual void waitFor(std::condition_variable &condition, std::unique_lock<std::mutex> &lock, int64_t ms) const = 0;
+
+    /**
+     * @brief Clock backed by std::chrono::steady_clock and system_clock.
+     */
+    static Clock &system();
+
+    /**
+     * @brief The clock everything reads: system() unless a simulation installed another one.
+     */
+    static Clock &getInstance() {
+        Clock *installed = current.load(std::memory_order_acquire);
+        return installed ? *installed : system();
+    }
+
+    /**
+     * @brief Replace the process clock; nullptr restores system(). Install before anything starts timing.
+     */
+    static void install(Clock *clock) { current.store(clock, std::memory_order_release); }
+
+private:
+    static std::atomic<Clock *> current;
+};
+
+/**
+ * @brief Clock that only moves when told to. Wall time follows monotonic time unless jumped explicitly.
+ */
+class FakeClock : public Clock {
+public:
+    explicit FakeClock(int64_t startMs = 0, int64_t wallStartSeconds = 1700000000)
+            : monotonicMs(startMs), wallOffsetMs(wallStartSeconds * 1000 - startMs) {}
+
+    [[nodiscard]] int64_t nowMs() const override { return monotonicMs.load(); }
+
+    [[nodiscard]] int64_t wallTimeSeconds() const override { return (monotonicMs.load() + wallOffsetMs.load()) / 1000; }
+
+    /**
+     * @brief Returns at once, moving time forward instead, so backoff and pacing cost no real time.
+     */
+    void sleepMs(int64_t ms) const override { monotonicMs += ms > 0 ? ms : 0; }
+
+    /**
+     * @brief Moves time forward like sleepMs, with lock released meanwhile, so a waiter never stalls on a clock
+     * that nothing else advances.
+     */
+    void waitFor(std::condition_variable &, std::unique_lock<std::mutex> &lock, int64_t ms) const override {
+        lock.unlock();
+        sleepMs(ms);
+        std::this_thread::yield();
+        lock.lock();
+    }
+
+    void advance(int64_t ms) { monotonicMs += ms; }
+
+    /**
+     * @brief Set wall time without touching monotonic time, like an NTP step.
+     */
+    void setWallTime(int64_t seconds) { wallOffsetMs = seconds * 1000 - monotonicMs.load(); }
+
+private:
+    mutable std::atomic<int64_t> monotonicMs;
+    std::atomic<int64_t> wallOffsetMs;
+};
+
+#endif //BETTERSCROBBLER_CLOCK_H
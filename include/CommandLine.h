@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
 #include "Config.h"
 #include "Logger.h"
 
@@ -28,6 +30,10 @@ public:
                 logger.setDebugEnabled(true);
             } else if (arg.substr(0, 6) == "--log=") {
                 config.setLogPath(arg.substr(6));
+            } else if (arg.substr(0, 9) == "--settle=") {
+                config.setMetadataSettleMs(std::max(0L, std::strtol(arg.c_str() + 9, nullptr, 10)));
+            } else if (arg.substr(0, 11) == "--prefetch=") {
+                config.setPrefetchAhead(static_cast<int>(std::max(0L, std::strtol(arg.c_str() + 11, nullptr, 10))));
             } else if (arg == "--no-scrobble") {
                 config.setScrobblingEnabled(false);
             } else if (arg == "--help") {
@@ -52,6 +58,8 @@ private:
                   << "  --debug      Show debug message in the console\n"
                   << "  --log=PATH   Specify custom log file path\n"
                   << "  --no-scrobble Disable scrobbling entirely\n"
+                  << "  --settle=MS  Wait MS for new track metadata to hold before acting on it (default 750)\n"
+                  << "  --prefetch=N Warm lyrics for the next N tracks of the Apple Music playlist, 0 to disable (default 3)\n"
                   << "  --help       Show this help message\n";
     }
 };
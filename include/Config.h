@@ -2,6 +2,8 @@
 #define BETTERSCROBBLER_CONFIG_H
 
 #include <string>
+#include <cstdint>
+#include <cstdlib>
 
 class Config {
 public:
@@ -18,6 +20,27 @@ public:
 
     void setLogPath(const std::string &path) { logPath = path; }
 
+    /**
+     * @brief File holding scrobbles that could not be submitted yet, kept across restarts.
+     */
+    [[nodiscard]] const std::string &getScrobbleQueuePath() const { return scrobbleQueuePath; }
+
+    void setScrobbleQueuePath(const std::string &path) { scrobbleQueuePath = path; }
+
+    /**
+     * @brief How long new track metadata must hold before it counts as a track change.
+     */
+    [[nodiscard]] int64_t getMetadataSettleMs() const { return metadataSettleMs; }
+
+    void setMetadataSettleMs(int64_t ms) { metadataSettleMs = ms; }
+
+    /**
+     * @brief How many upcoming tracks to warm lyrics and resolution for; 0 turns prefetching off.
+     */
+    [[nodiscard]] int getPrefetchAhead() const { return prefetchAhead; }
+
+    void setPrefetchAhead(int count) { prefetchAhead = count; }
+
     [[nodiscard]] bool isShowLyrics() const { return showLyrics; }
 
     void setShowLyrics(bool enabled) { showLyrics = enabled; }
@@ -55,6 +78,8 @@ private:
     Config() {
         appName = "Scrobbler";
         logPath = "/tmp/scrobbler.log";
+        const char *home = std::getenv("HOME");
+        scrobbleQueuePath = std::string(home ? home : "/tmp") + "/.scrobbler_queue.json";
         keychainService = "com.scrobbler.credentials";
         keychainApiKeyAccount = "API_KEY";
         keychainSecretAccount = "SHARED_SECRET";
@@ -71,6 +96,9 @@ private:
     bool preferSyncedLyrics = true;
     bool quietMode = false;
     std::string logPath;
+    std::string scrobbleQueuePath;
+    int64_t metadataSettleMs = 750;
+    int prefetchAhead = 3;
     std::string appName;
     std::string keychainService;
     std::string keychainApiKeyAccount;
@@ -0,0 +1,29 @@
+#ifndef BETTERSCROBBLER_CREDENTIALSTORE_H
+#define BETTERSCROBBLER_CREDENTIALSTORE_H
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief Where secrets live between runs. Reads may be slow (IPC, a process spawn, disk),
+ * so Credentials only goes here on a cache miss.
+ */
+class CredentialStore {
+public:
+    virtual ~CredentialStore() = default;
+
+    /**
+     * @return The stored value, or empty if the account has none.
+     */
+    virtual std::string load(const std::string &account) = 0;
+
+    virtual bool save(const std::string &account, const std::string &value) = 0;
+};
+
+/**
+ * @brief The Keychain on macOS, an unencrypted owner-only file under the user's config directory elsewhere.
+ * Defined by whichever CredentialStore*.{mm,cpp} matches the target platform.
+ */
+std::unique_ptr<CredentialStore> createPlatformCredentialStore(const std::string &service);
+
+#endif //BETTERSCROBBLER_CREDENTIALSTORE_H
@@ -1,33 +1,45 @@
 #ifndef BETTERSCROBBLER_CREDENTIALS_H
 #define BETTERSCROBBLER_CREDENTIALS_H
 
+#include <atomic>
 #include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
 #include "Config.h"
+#include "CredentialStore.h"
 #include "Logger.h"
-#include "LastFmScrobbler.h"
 
 class Credentials {
 public:
+    /**
+     * @brief Immutable snapshot; updates publish a modified copy so readers never see a half-written value.
+     * The views point into a page of its own that is locked against swapping and zeroed when the last holder
+     * lets go, so a replaced or rejected secret does not linger in memory.
+     */
+    struct Secrets {
+        std::string_view apiKey;
+        std::string_view apiSecret;
+        std::string_view sessionKey;
+    };
+
     static Credentials &getInstance() {
         static Credentials instance;
         return instance;
     }
 
     bool checkAndPrompt() {
-        apiKey = getApiKey();
-        if (apiKey.empty()) {
+        if (getApiKey().empty()) {
             LOG_ERROR("Missing API Key");
             return false;
         }
 
-        apiSecret = getApiSecret();
-        if (apiSecret.empty()) {
+        if (getApiSecret().empty()) {
             LOG_ERROR("Missing API Secret");
             return false;
         }
 
-        sessionKey = loadSessionKey();
-        if (sessionKey.empty()) {
+        if (loadSessionKey().empty()) {
             LOG_INFO("No session key found. Starting authentication flow...");
             if (!authenticate()) {
                 return false;
@@ -37,12 +49,10 @@ public:
         return true;
     }
 
-    [[nodiscard]] const std::string &getStoredApiKey() const { return apiKey; }
-
-    [[nodiscard]] const std::string &getStoredApiSecret() const { return apiSecret; }
-
-    [[nodiscard]] const std::string &getSessionKey() const { return sessionKey; }
-
+    /**
+     * @brief Served from memory after the first call; the store is only read on a miss.
+     * Returns a copy, so per-request code holds apiSecrets() instead.
+     */
     static std::string getApiKey();
 
     static std::string getAuthToken();
@@ -57,6 +67,36 @@ public:
 
     static std::string getApiSecret();
 
+    /**
+     * @brief Whether a session key can be used, without copying it. The store is only read on a miss.
+     */
+    static bool hasSessionKey();
+
+    /**
+     * @brief Last.fm rejected the session key (error 9): drop it from the cache and the store, and report no
+     * session until saveSessionKey(), so nothing keeps retrying with it. The next launch authenticates again.
+     */
+    static void invalidateSessionKey();
+
+    /**
+     * @brief snapshot() with the API key and secret loaded, prompting for whichever is missing.
+     * After the first call this is a pointer copy.
+     */
+    static std::shared_ptr<const Secrets> apiSecrets();
+
+    /**
+     * @brief The secrets loaded so far, without copying them. Fields not yet loaded through their getter are empty,
+     * and so is the session key once rejected. Hold the pointer for as long as the strings are in use.
+     */
+    static std::shared_ptr<const Secrets> snapshot();
+
+    [[nodiscard]] static bool isSessionRejected() { return sessionRejected.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Replace the platform store, e.g. with one that never touches the Keychain. Clears the cache.
+     */
+    static void setStore(std::unique_ptr<CredentialStore> store);
+
 private:
     Credentials() = default;
 
@@ -64,16 +104,28 @@ private:
 
     Credentials &operator=(const Credentials &) = delete;
 
-    static std::string getFromKeyChain(const std::string &service, const std::string &account);
+    static std::string cached(std::string_view Secrets::*field, const std::string &account);
+
+    static void publish(std::string_view Secrets::*field, std::string_view value);
 
-    static void saveToKeyChain(const std::string &service, const std::string &account, const std::string &value);
+    /**
+     * @brief Copy values into a fresh locked page; the deleter zeroes, unlocks and unmaps it.
+     */
+    static std::shared_ptr<const Secrets> lockedCopy(const Secrets &values);
+
+    static std::string loadFromStore(const std::string &account);
+
+    static void saveToStore(const std::string &account, const std::string &value);
 
     bool authenticate();
 
-    std::string apiKey;
-    std::string apiSecret;
-    std::string sessionKey;
     std::string lastError;
+
+    static std::mutex cacheMutex;
+    static std::shared_ptr<const Secrets> cache;
+    static std::mutex storeMutex;
+    static std::unique_ptr<CredentialStore> store;
+    static std::atomic<bool> sessionRejected;
 };
 
 #endif //BETTERSCROBBLER_CREDENTIALS_H
@@ -0,0 +1,42 @@
+#ifndef BETTERSCROBBLER_CURSESTARGET_H
+#define BETTERSCROBBLER_CURSESTARGET_H
+
+#include <ncurses.h>
+#include "RenderTarget.h"
+
+/**
+ * @brief RenderTarget backed by the ncurses screen. Owns the curses session: constructing it takes over
+ * the terminal and sets up the UI's color pairs, destroying it restores the terminal. One at a time.
+ */
+class CursesTarget : public RenderTarget {
+public:
+    CursesTarget();
+
+    ~CursesTarget() override;
+
+    CursesTarget(const CursesTarget &) = delete;
+
+    CursesTarget &operator=(const CursesTarget &) = delete;
+
+    std::unique_ptr<Surface> createWindow(int rows, int cols, int y, int x) override;
+    std::unique_ptr<Surface> createPad(int rows, int cols) override;
+
+    [[nodiscard]] int getRows() const override { return getmaxy(stdscr); }
+    [[nodiscard]] int getCols() const override { return getmaxx(stdscr); }
+
+    /**
+     * @brief Input does not go through getch, so ncurses never hears about SIGWINCH; ask the tty instead.
+     */
+    void syncSize() override;
+
+    void clear() override;
+
+    void flush() override;
+
+    void markStaged() { staged = true; }
+
+private:
+    bool staged = false;
+};
+
+#endif //BETTERSCROBBLER_CURSESTARGET_H
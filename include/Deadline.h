@@ -0,0 +1,41 @@
+#ifndef BETTERSCROBBLER_DEADLINE_H
+#define BETTERSCROBBLER_DEADLINE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include "Clock.h"
+
+/**
+ * @brief Point on the monotonic clock by which a piece of work must be done, retries included.
+ * A default-constructed deadline never expires.
+ */
+class Deadline {
+public:
+    Deadline() = default;
+
+    static Deadline after(int64_t budgetMs) {
+        Deadline deadline;
+        deadline.atMs = Clock::getInstance().nowMs() + std::max<int64_t>(budgetMs, 0);
+        return deadline;
+    }
+
+    [[nodiscard]] bool isSet() const { return atMs != NEVER; }
+
+    /**
+     * @return Milliseconds left, 0 once expired, or INT64_MAX if the deadline is not set.
+     */
+    [[nodiscard]] int64_t remainingMs() const {
+        if (!isSet()) return NEVER;
+        return std::max<int64_t>(atMs - Clock::getInstance().nowMs(), 0);
+    }
+
+    [[nodiscard]] bool isExpired() const { return isSet() && remainingMs() == 0; }
+
+private:
+    static constexpr int64_t NEVER = std::numeric_limits<int64_t>::max();
+
+    int64_t atMs = NEVER;
+};
+
+#endif //BETTERSCROBBLER_DEADLINE_H
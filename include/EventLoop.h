@@ -0,0 +1,144 @@
+#ifndef BETTERSCROBBLER_EVENTLOOP_H
+#define BETTERSCROBBLER_EVENTLOOP_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Clock.h"
+#include "TimerWheel.h"
+
+/**
+ * @brief Single-threaded reactor that owns all periodic work.
+ * Timers live in a TimerWheel read from a pluggable Clock; the platform backend (epoll + timerfd on
+ * Linux, a GCD adapter on macOS) only ever waits for the wheel's earliest deadline, an fd, a signal
+ * or a cross-thread post(). Everything except post() must be called on the loop's thread.
+ */
+class EventLoop {
+public:
+    using Task = std::function<void()>;
+    using TimerId = uint64_t;
+
+    /**
+     * @brief OS wait primitive. Calls EventLoop::runDue() when armed time passes or after wake().
+     */
+    class Backend {
+    public:
+        virtual ~Backend() = default;
+
+        /**
+         * @brief Replace the pending deadline with one delayMs from now. Negative disarms.
+         */
+        virtual void arm(int64_t delayMs) = 0;
+
+        /**
+         * @brief Ask for runDue() soon. Safe to call from any thread.
+         */
+        virtual void wake() = 0;
+
+        virtual bool watchReadable(int fd, Task task) = 0;
+        virtual void unwatch(int fd) = 0;
+        virtual bool watchSignal(int signal, Task task) = 0;
+
+        virtual void run() = 0;
+        virtual void stop() = 0;
+    };
+
+    /**
+     * @brief Main-thread loop on the system clock and the platform backend.
+     */
+    static EventLoop &getInstance() {
+        static EventLoop instance(Clock::getInstance());
+        return instance;
+    }
+
+    /**
+     * @param platformBackend false for a loop driven by hand through runDue(), e.g. on a fake clock.
+     */
+    explicit EventLoop(Clock &clock, bool platformBackend = true);
+    ~EventLoop();
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    /**
+     * @brief Register a timer that stays idle until schedule() and survives firing until destroyTimer().
+     */
+    TimerId createTimer(Task task);
+
+    /**
+     * @brief (Re)arm a timer delayMs from now, replacing any pending deadline.
+     * @param intervalMs Repeat period after the first firing, 0 for one-shot.
+     * @param leewayMs Deadline may be rounded up to a multiple of this so timers with the same leeway fire together.
+     */
+    void schedule(TimerId id, int64_t delayMs, int64_t intervalMs = 0, int64_t leewayMs = 0);
+    void cancel(TimerId id);
+    void destroyTimer(TimerId id);
+
+    /**
+     * @brief One-shot timer that removes itself after firing.
+     */
+    TimerId runAfter(int64_t delayMs, Task task);
+
+    /**
+     * @brief Run task on the loop's thread. Safe to call from any thread.
+     */
+    void post(Task task);
+
+    bool watchReadable(int fd, Task task);
+    void unwatch(int fd);
+    bool watchSignal(int signal, Task task);
+
+    void run();
+    void stop();
+
+    /**
+     * @brief Fire every timer due at the clock's current time and run posted tasks. Called by the backend.
+     */
+    void runDue();
+
+    /**
+     * @return Deadline of the earliest pending timer in clock milliseconds, -1 if none.
+     */
+    [[nodiscard]] int64_t nextDeadline() const { return wheel.nextDeadline(); }
+
+    [[nodiscard]] Clock &getClock() const { return clock; }
+    [[nodiscard]] uint64_t getWakeups() const { return wakeups; }
+    [[nodiscard]] uint64_t getTimersFired() const { return timersFired; }
+
+private:
+    struct Timer : TimerWheel::Node {
+        TimerId id = 0;
+        Task task;
+        int64_t intervalMs = 0;
+        int64_t leewayMs = 0;
+        bool autoDestroy = false;
+    };
+
+    void insertTimer(Timer &timer, int64_t delayMs);
+    void rearm();
+
+    Clock &clock;
+    std::unique_ptr<Backend> backend;
+    TimerWheel wheel;
+    std::unordered_map<TimerId, std::unique_ptr<Timer>> timers;
+    std::vector<TimerWheel::Node *> expired;
+    TimerId nextTimerId = 1;
+    bool dispatching = false;
+    int64_t armedDeadline = -1;
+
+    std::mutex postMutex;
+    std::vector<Task> posted;
+
+    uint64_t wakeups = 0;
+    uint64_t timersFired = 0;
+};
+
+/**
+ * @brief Defined by the platform backend's translation unit.
+ */
+std::unique_ptr<EventLoop::Backend> createPlatformBackend(EventLoop &loop);
+
+#endif //BETTERSCROBBLER_EVENTLOOP_H
@@ -0,0 +1,58 @@
+#ifndef BETTERSCROBBLER_HEADERVIEW_H
+#define BETTERSCROBBLER_HEADERVIEW_H
+
+#include <string>
+#include <cstdint>
+#include "RenderTarget.h"
+
+/**
+ * @brief Now Playing header that remembers what is on screen and repaints only the rows or
+ * progress bar cells that changed. A frame with nothing new does no terminal I/O.
+ */
+class HeaderView {
+public:
+    struct State {
+        int width = 0;
+        const char *label = "Now Playing";
+        std::string songInfo;
+        int songColumns = 0;
+        std::string timeInfo;
+        int progressWidth = 0;
+        int progressPos = -1;
+    };
+
+    /**
+     * @brief Visible header state for this frame. The song line is laid out again only when
+     * the artist, title or width changes.
+     */
+    State compute(const char *label, const std::string &artist, const std::string &title,
+                  double elapsed, double duration, int width);
+
+    /**
+     * @return true if anything was painted and staged on the surface.
+     */
+    bool draw(Surface &surface, const State &next);
+
+    void invalidate() { valid = false; }
+
+    [[nodiscard]] uint64_t getCellsPainted() const { return cellsPainted; }
+
+private:
+    void drawFrame(Surface &surface, const State &next);
+    void layoutSongInfo(const std::string &artist, const std::string &title, int width);
+    void drawCenteredRow(Surface &surface, int row, const std::string &text, int columns, Surface::Style style);
+    void drawProgressCells(Surface &surface, const State &next, int from, int to);
+
+    std::string songArtist;
+    std::string songTitle;
+    int songWidth = -1;
+    std::string songInfo;
+    int songColumns = 0;
+
+    std::string cells;
+    State painted;
+    bool valid = false;
+    uint64_t cellsPainted = 0;
+};
+
+#endif //BETTERSCROBBLER_HEADERVIEW_H
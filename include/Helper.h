@@ -2,8 +2,13 @@
 #define BETTERSCROBBLER_HELPER_H
 
 #include <string>
+#include <vector>
 #include <Foundation/Foundation.h>
 #include <CoreFoundation/CoreFoundation.h>
+#include <cstdint>
+#include "CancellationToken.h"
+#include "RateLimiter.h"
+#include "Prefetcher.h"
 
 
 class Helper {
@@ -25,10 +30,41 @@ public:
     updateElapsedTime(CFDictionaryRef info, double &reportedElapsed, double playbackRate, double &elapsedValue,
                       double &lastElapsed, double &lastFetchTime, double &lastReportedElapsed);
 
+    /**
+     * @brief Resolve platform metadata, e.g. a video title and uploader, to a Last.fm artist and title.
+     * Blocks on the network; safe to call from any thread.
+     */
     static bool
     extractMusicInfo(const std::string &artist, const std::string &title, const std::string &album,
                      std::string &outArtist,
-                     std::string &outTitle);
+                     std::string &outTitle,
+                     const CancellationToken &cancel = {});
+
+    /**
+     * @brief Resolve a track expected to play soon at the lowest rate-limit priority and keep the result
+     * for extractMusicInfo. Safe to call from any thread.
+     */
+    static bool
+    prefetchMusicInfo(const std::string &artist, const std::string &title, const std::string &album,
+                      std::string &outArtist,
+                      std::string &outTitle,
+                      const CancellationToken &cancel = {});
+
+    /**
+     * @return Prefetched resolutions later used by extractMusicInfo.
+     */
+    static uint64_t getPrefetchedResolutionHits();
+
+    /**
+     * @return Prefetched resolutions evicted before any track needed them.
+     */
+    static uint64_t getPrefetchedResolutionWasted();
+
+    /**
+     * @brief The count tracks after currentTitle in Apple Music's current playlist, empty unless Music is
+     * running and playing currentTitle. Runs osascript, so keep it off the event loop.
+     */
+    static std::vector<Prefetcher::Hint> getAppleMusicUpNext(const std::string &currentTitle, int count);
 
     static std::string cleanArtistName(const std::string &artist);
 
@@ -0,0 +1,58 @@
+#ifndef BETTERSCROBBLER_KEYDECODER_H
+#define BETTERSCROBBLER_KEYDECODER_H
+
+#include <cstddef>
+#include <functional>
+
+struct KeyEvent {
+    enum class Type {
+        CHARACTER,
+        UP,
+        DOWN,
+        LEFT,
+        RIGHT,
+        PAGE_UP,
+        PAGE_DOWN,
+        HOME,
+        END,
+        ESCAPE,
+        RESIZE
+    };
+
+    Type type = Type::CHARACTER;
+    char character = 0;
+};
+
+/**
+ * @brief Turns raw terminal bytes into key events, including CSI (ESC [) and SS3 (ESC O)
+ * sequences for arrows, Home/End and PgUp/PgDn. A sequence split across reads is held until
+ * the rest arrives, or until flush() decides it was a bare Escape key.
+ */
+class KeyDecoder {
+public:
+    using Callback = std::function<void(const KeyEvent &)>;
+
+    static constexpr int ESCAPE_TIMEOUT_MS = 25;
+
+    void feed(const char *data, size_t length, const Callback &callback);
+
+    /**
+     * @brief Resolve a held sequence once no more bytes arrived within ESCAPE_TIMEOUT_MS.
+     */
+    void flush(const Callback &callback);
+
+    [[nodiscard]] bool hasPending() const { return pendingLength > 0; }
+
+private:
+    static constexpr size_t MAX_SEQUENCE = 16;
+
+    /**
+     * @return Bytes consumed from pending, or 0 if the sequence is still incomplete.
+     */
+    size_t decodeEscape(const Callback &callback);
+
+    char pending[MAX_SEQUENCE] = {};
+    size_t pendingLength = 0;
+};
+
+#endif //BETTERSCROBBLER_KEYDECODER_H
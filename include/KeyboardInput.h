@@ -0,0 +1,40 @@
+#ifndef BETTERSCROBBLER_KEYBOARDINPUT_H
+#define BETTERSCROBBLER_KEYBOARDINPUT_H
+
+#include <functional>
+#include "EventLoop.h"
+#include "KeyDecoder.h"
+
+/**
+ * @brief The single reader of stdin. Wakes only when bytes arrive or the terminal is resized,
+ * decodes them into KeyEvents and passes them to the handler on the main EventLoop.
+ */
+class KeyboardInput {
+public:
+    using Handler = std::function<void(const KeyEvent &)>;
+
+    static KeyboardInput &getInstance() {
+        static KeyboardInput instance;
+        return instance;
+    }
+
+    void start(Handler handler);
+
+    void stop();
+
+private:
+    KeyboardInput() = default;
+    ~KeyboardInput();
+
+    KeyboardInput(const KeyboardInput &) = delete;
+    KeyboardInput &operator=(const KeyboardInput &) = delete;
+
+    void onReadable();
+
+    KeyDecoder decoder;
+    Handler handler;
+    EventLoop::TimerId escapeTimer = 0;
+    bool watching = false;
+};
+
+#endif //BETTERSCROBBLER_KEYBOARDINPUT_H
@@ -5,6 +5,13 @@
 #include <map>
 #include <list>
 #include <curl/curl.h>
+#include "ApiResponse.h"
+#include "CancellationToken.h"
+#include "Credentials.h"
+#include "RateLimiter.h"
+#include "ScrobbleQueue.h"
+#include "NowPlayingPolicy.h"
+#include "WorkQueue.h"
 
 class LastFmScrobbler {
 public:
@@ -19,32 +26,56 @@ public:
 
     LastFmScrobbler(const LastFmScrobbler &) = delete;
 
+    /**
+     * @brief Blocks for the request; updateNowPlaying() runs it on the scrobbler's worker.
+     */
     bool sendNowPlaying(const std::string &artist,
                         const std::string &track,
                         const std::string &album = "",
                         double duration = 0.0);
 
-    static void sendNowPlayingUpdate(const std::string &artist,
-                              const std::string &title,
-                              bool isMusic,
-                              const std::string &album,
-                              double &lastNowPlayingSent,
-                              double playbackRate);
+    /**
+     * @brief Called on every playback poll; sends track.updateNowPlaying only when NowPlayingPolicy asks for it.
+     */
+    void updateNowPlaying(const NowPlayingPolicy::Observation &observation);
 
+    [[nodiscard]] const NowPlayingPolicy &getNowPlayingPolicy() const { return nowPlayingPolicy; }
+
+    /**
+     * @brief Queue a scrobble durably and submit it on the scrobbler's worker, oldest queued first.
+     * @return true once the scrobble is handed over, false if scrobbling is off or there is no session.
+     */
     bool scrobble(const std::string &artist,
                   const std::string &track,
                   const std::string &album = "",
                   double duration = 0.0,
                   int timeStamp = 0);
 
-    static bool shouldScrobble(double elapsed,
-                        double duration,
-                        double playbackRate,
-                        bool isMusic);
+    /**
+     * @return true if scrobble() has taken the play of artist - track that began at timeStamp, whether it was
+     * submitted yet or is still queued.
+     */
+    [[nodiscard]] bool hasScrobbled(const std::string &artist, const std::string &track, int64_t timeStamp) const {
+        return timeStamp == lastScrobbled.timeStamp && track == lastScrobbled.track &&
+               artist == lastScrobbled.artist;
+    }
+
+    /**
+     * @brief Submit queued scrobbles on the worker, unless Last.fm's circuit is open. Reschedules itself while any remain.
+     */
+    void flushQueue();
+
+    void scheduleQueueFlush(int64_t delayMs);
 
-    std::string search(const std::string &artist, const std::string &track);
+    /**
+     * @brief Safe to call from any thread: uses its own handle rather than the shared one.
+     */
+    ApiResponse search(const std::string &artist, const std::string &track, const CancellationToken &cancel = {},
+                       RateLimiter::Priority priority = RateLimiter::Priority::RESOLUTION);
 
-    std::list<std::string> bestMatch(const std::string &artist, const std::string &track);
+    std::list<std::string> bestMatch(const std::string &artist, const std::string &track,
+                                     const CancellationToken &cancel = {},
+                                     RateLimiter::Priority priority = RateLimiter::Priority::RESOLUTION);
 
 private:
     LastFmScrobbler();
@@ -53,8 +84,27 @@ private:
 
     LastFmScrobbler &operator=(const LastFmScrobbler &) = delete;
 
+    /**
+     * @brief Builds and signs the request with UrlUtils::encodeScrobble(), so nothing is copied per scrobble.
+     */
+    ScrobbleQueue::Result submitScrobble(const ScrobbleQueue::Entry &entry, const Credentials::Secrets &secrets);
+
+    /**
+     * @brief Runs on the worker: submit the queue oldest first and ask the loop for a retry if any remain.
+     */
+    void drainQueue();
+
+    static constexpr int64_t QUEUE_RETRY_MS = 60000;
+
+    // curl and requestBody belong to the worker once it runs
     CURL *curl;
     std::string lastError;
+    std::string requestBody;
+    uint64_t queueFlushTimer = 0;
+    NowPlayingPolicy nowPlayingPolicy;
+    ScrobbleQueue::Entry lastScrobbled;
+    CancellationToken shutdown = CancellationToken::create();
+    WorkQueue worker;
 
 };
 
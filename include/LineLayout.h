@@ -0,0 +1,60 @@
+#ifndef BETTERSCROBBLER_LINELAYOUT_H
+#define BETTERSCROBBLER_LINELAYOUT_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "LyricTimeline.h"
+
+/**
+ * @brief Truncated form of every line in a timeline, cached per column budget.
+ * Lines are cut on grapheme cluster boundaries using the widths the timeline already measured. Layouts for the
+ * last MAX_WIDTHS budgets are kept, so resizing back to a recent width reuses its layout; all of them are
+ * dropped when the lyrics change. A layout is keyed on the timeline's generation, which changes with its contents.
+ */
+class LineLayout {
+public:
+    static constexpr std::string_view ELLIPSIS = "...";
+    static constexpr size_t MAX_WIDTHS = 4;
+
+    /**
+     * @brief Select the layout for maxColumns, computing it only if it is not cached for these lyrics.
+     */
+    void build(const LyricTimeline &lyrics, int maxColumns);
+    void clear();
+
+    [[nodiscard]] bool matches(const LyricTimeline &lyrics, int maxColumns) const {
+        return isSource(lyrics) && !widths.empty() && widths.back().columns == maxColumns;
+    }
+
+    /**
+     * @brief Text to draw for a line; follow it with ELLIPSIS when isTruncated() is true.
+     */
+    [[nodiscard]] std::string_view textAt(size_t index) const;
+    [[nodiscard]] bool isTruncated(size_t index) const { return widths.back().fitted[index] != NOT_TRUNCATED; }
+
+    /**
+     * @return Layouts computed rather than found in the cache.
+     */
+    [[nodiscard]] uint64_t getComputedCount() const { return computed; }
+
+private:
+    static constexpr uint32_t NOT_TRUNCATED = UINT32_MAX;
+
+    struct Width {
+        int columns = 0;
+        std::vector<uint32_t> fitted;
+    };
+
+    [[nodiscard]] bool isSource(const LyricTimeline &lyrics) const {
+        return source == &lyrics && generation == lyrics.getGeneration();
+    }
+
+    const LyricTimeline *source = nullptr;
+    uint64_t generation = 0;
+    // Most recently used last; the back is the selected layout
+    std::vector<Width> widths;
+    uint64_t computed = 0;
+};
+
+#endif //BETTERSCROBBLER_LINELAYOUT_H
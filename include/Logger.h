@@ -5,6 +5,8 @@
 #include <fstream>
 #include <iostream>
 #include <ctime>
+#include <functional>
+#include <mutex>
 #include "Config.h"
 
 class Logger {
@@ -25,6 +27,12 @@ public:
 
     bool isDebugEnabled() const { return showDebug; }
 
+    /**
+     * @brief Redirect console output (not the daemon log file) to sink, e.g. while a full-screen UI owns the terminal.
+     * Pass nullptr to restore stdout/stderr.
+     */
+    void setConsoleSink(std::function<void(const std::string &)> sink) { consoleSink = std::move(sink); }
+
     void init(bool isDaemon) {
         if (isDaemon) {
             setupDaemonLogging();
@@ -54,30 +62,42 @@ public:
 
         std::time_t now = std::time(nullptr);
         char timeStr[20];
-        std::cout << "\r\033[K";
-        std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+        std::tm local = {};
+        localtime_r(&now, &local);
+        std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &local);
 
         std::string logMessage = std::string(timeStr) + " [" + levelStr + "] " + message + "\n";
 
+        // Lookups on worker threads log too
+        std::lock_guard<std::mutex> lock(logMutex);
+
         if (Config::getInstance().isDaemonMode() && logFile.is_open()) {
             logFile << logMessage;
             logFile.flush();
         }
 
         if (!Config::getInstance().isDaemonMode()) {
+            std::ostream *out = nullptr;
             if (level == Level::ERROR && !Config::getInstance().isQuietMode()) {
-                std::cerr << logMessage;
+                out = &std::cerr;
             }
             else if (level != Level::ERROR) {
                 if (level == Level::DEBUG) {
                     if (showDebug && !Config::getInstance().isQuietMode()) {
-                        std::cout << logMessage;
+                        out = &std::cout;
                     }
                 }
                 else if ((level == Level::INFO || level == Level::WARNING) && !Config::getInstance().isQuietMode()) {
-                    std::cout << logMessage;
+                    out = &std::cout;
                 }
             }
+
+            if (out && consoleSink) {
+                logMessage.pop_back();
+                consoleSink(logMessage);
+            } else if (out) {
+                *out << "\r\033[K" << logMessage;
+            }
         }
     }
 
@@ -110,6 +130,8 @@ private:
 
     std::ofstream logFile;
     bool showDebug = false;
+    std::function<void(const std::string &)> consoleSink;
+    std::mutex logMutex;
 };
 
 #define LOG_WARNING(msg) Logger::getInstance().warning(msg)
@@ -0,0 +1,53 @@
+#ifndef BETTERSCROBBLER_LRCPARSER_H
+#define BETTERSCROBBLER_LRCPARSER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Parsed LRC / enhanced LRC lyrics.
+ * All text views point into one buffer owned by the document, so they stay valid
+ * for the document's lifetime, including across moves.
+ */
+class LrcDocument {
+public:
+    struct Word {
+        int32_t offsetMs;       // Relative to the start of its line
+        std::string_view text;
+    };
+
+    struct Line {
+        int32_t timeMs;         // Absolute, with [offset:] applied
+        std::string_view text;  // Word timing tags removed
+        uint32_t firstWord;
+        uint32_t wordCount;
+    };
+
+    /**
+     * @brief Parse in a single linear pass.
+     * Lines with several leading timestamps are expanded into one line per timestamp,
+     * [offset:] is applied to every line, and the result is sorted by time.
+     * Unrecognized tags and lines without a timestamp are skipped.
+     */
+    static LrcDocument parse(std::string_view lyrics);
+
+    [[nodiscard]] const std::vector<Line> &getLines() const { return lines; }
+    [[nodiscard]] const std::vector<Word> &getWords() const { return words; }
+    [[nodiscard]] int32_t getOffsetMs() const { return offsetMs; }
+    [[nodiscard]] bool empty() const { return lines.empty(); }
+
+    [[nodiscard]] const Word *wordsBegin(const Line &line) const { return words.data() + line.firstWord; }
+    [[nodiscard]] const Word *wordsEnd(const Line &line) const { return wordsBegin(line) + line.wordCount; }
+
+private:
+    std::unique_ptr<char[]> buffer;
+    size_t bufferSize = 0;
+    std::vector<Line> lines;
+    std::vector<Word> words;
+    int32_t offsetMs = 0;
+};
+
+#endif //BETTERSCROBBLER_LRCPARSER_H
@@ -0,0 +1,45 @@
+#ifndef BETTERSCROBBLER_LYRICCURSOR_H
+#define BETTERSCROBBLER_LYRICCURSOR_H
+
+#include <cstdint>
+#include "LyricTimeline.h"
+
+/**
+ * @brief Tracks the current line of a synced timeline as playback advances.
+ * Normal playback steps forward one line at a time; a backward jump, a jump further than
+ * SEEK_THRESHOLD_MS, a rate change or a different timeline triggers a binary search instead.
+ */
+class LyricCursor {
+public:
+    static constexpr int32_t SEEK_THRESHOLD_MS = 5000;
+    static constexpr int32_t JITTER_TOLERANCE_MS = 250;
+
+    /**
+     * @brief Forget the timeline and position, and zero the reposition count, e.g. for a new track.
+     */
+    void reset();
+
+    /**
+     * @return Index of the last line starting at or before timeMs, or -1 if there is none.
+     */
+    int update(const LyricTimeline &timeline, int32_t timeMs, double playbackRate);
+
+    /**
+     * @return Media milliseconds from timeMs until the next line starts, or -1 after the last line.
+     */
+    [[nodiscard]] int32_t msUntilNextLine(const LyricTimeline &timeline, int32_t timeMs) const;
+
+    [[nodiscard]] int getIndex() const { return index; }
+    [[nodiscard]] uint64_t getRepositionCount() const { return repositions; }
+
+private:
+    void reposition(const LyricTimeline &timeline, int32_t timeMs);
+
+    uint64_t generation = 0;
+    int index = -1;
+    int32_t lastTimeMs = 0;
+    double lastRate = 0.0;
+    uint64_t repositions = 0;
+};
+
+#endif //BETTERSCROBBLER_LYRICCURSOR_H
@@ -0,0 +1,88 @@
+#ifndef BETTERSCROBBLER_LYRICTIMELINE_H
+#define BETTERSCROBBLER_LYRICTIMELINE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class LrcDocument;
+
+/**
+ * @brief Lyric lines stored as parallel arrays: timestamps, offsets and lengths into one
+ * text arena, and display widths computed once at build time.
+ * Enhanced LRC word timings follow the same layout, indexed per line by its first word.
+ * Plain lyrics use the same layout with every timestamp set to 0 and no words.
+ */
+class LyricTimeline {
+public:
+    static LyricTimeline fromPlain(std::string_view lyrics);
+
+    /**
+     * @brief Build from parsed LRC, with a blank lead-in line at 0ms so the
+     * display has something to show before the first lyric. Word timings come along.
+     */
+    static LyricTimeline fromSynced(const LrcDocument &document);
+
+    void reserve(size_t lineCount, size_t textBytes);
+    void append(int32_t timeMs, std::string_view text);
+
+    /**
+     * @brief Add a timed word to the line appended last, as a byte range of that line's text.
+     * @param offsetMs Relative to the line's own timestamp.
+     */
+    void appendWord(int32_t offsetMs, size_t byteOffset, size_t length);
+    void clear();
+
+    [[nodiscard]] size_t size() const { return timesMs.size(); }
+    [[nodiscard]] bool empty() const { return timesMs.empty(); }
+
+    [[nodiscard]] int32_t timeAt(size_t index) const { return timesMs[index]; }
+    [[nodiscard]] std::string_view textAt(size_t index) const {
+        return {arena.data() + offsets[index], lengths[index]};
+    }
+    [[nodiscard]] int widthAt(size_t index) const { return widths[index]; }
+    [[nodiscard]] const std::vector<int32_t> &getTimes() const { return timesMs; }
+
+    /**
+     * @brief Changes whenever lines are appended or cleared, and is never reused by another timeline,
+     * so a cache keyed on it cannot mistake new lyrics at the same address for the old ones.
+     */
+    [[nodiscard]] uint64_t getGeneration() const { return generation; }
+
+    [[nodiscard]] size_t wordCountAt(size_t index) const {
+        size_t end = index + 1 < firstWords.size() ? firstWords[index + 1] : wordTimesMs.size();
+        return end - firstWords[index];
+    }
+    /**
+     * @brief Absolute start of a word, so lines repeated under several timestamps each get their own.
+     */
+    [[nodiscard]] int32_t wordTimeAt(size_t index, size_t word) const {
+        return timesMs[index] + wordTimesMs[firstWords[index] + word];
+    }
+    [[nodiscard]] std::string_view wordTextAt(size_t index, size_t word) const {
+        size_t slot = firstWords[index] + word;
+        return {arena.data() + wordOffsets[slot], wordLengths[slot]};
+    }
+
+    /**
+     * @brief Heap bytes held by this timeline, counting reserved capacity.
+     */
+    [[nodiscard]] size_t memoryUsage() const;
+
+private:
+    static uint64_t nextGeneration();
+
+    uint64_t generation = 0;
+    std::vector<int32_t> timesMs;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<uint16_t> widths;
+    std::vector<uint32_t> firstWords;
+    std::vector<int32_t> wordTimesMs;
+    std::vector<uint32_t> wordOffsets;
+    std::vector<uint32_t> wordLengths;
+    std::string arena;
+};
+
+#endif //BETTERSCROBBLER_LYRICTIMELINE_H
@@ -2,8 +2,22 @@
 #define SCROBBLER_LYRICSMANAGER_H
 
 #include <string>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <deque>
+#include <atomic>
 #include <curl/curl.h>
-#include <ncurses.h>
+#include "LyricTimeline.h"
+#include "LyricCursor.h"
+#include "HeaderView.h"
+#include "LyricsView.h"
+#include "RenderTarget.h"
+#include "KeyDecoder.h"
+#include "SingleFlight.h"
+#include "RateLimiter.h"
+#include "WorkQueue.h"
+#include "PlaybackSchedule.h"
 
 class LyricsManager {
 public:
@@ -12,10 +26,26 @@ public:
         return instance;
     }
 
-    void fetchLyrics(const std::string& artist,
+    /**
+     * @brief Download lyrics for trackId on the fetch pool and attach them to that track's state on the
+     * event loop when they arrive, whichever track is current by then.
+     * Ignored while a fetch for the same track is still pending and not cancelled.
+     */
+    void fetchLyrics(const std::string &trackId,
+                     const std::string& artist,
                      const std::string& title,
                      const std::string& album,
-                     double duration);
+                     double duration,
+                     const CancellationToken &cancel = {});
+
+    /**
+     * @brief Download lyrics for a track expected to play soon at the lowest priority and keep them
+     * until fetchLyrics asks for that track. Blocks, so call it from a worker thread.
+     */
+    void prefetchLyrics(const std::string &artist,
+                        const std::string &title,
+                        const std::string &album,
+                        const CancellationToken &cancel = {});
 
     void parseSyncedLyrics(const std::string& lyrics);
 
@@ -25,25 +55,104 @@ public:
 
     void displayPlainLyrics(double playbackRateValue, double elapsedValue);
 
+    /**
+     * @brief Keep the header and status row live for a track that has no lyrics.
+     */
+    void displayWithoutLyrics(double playbackRateValue, double elapsedValue);
+
     void clearLyricsArea();
 
     void forceRefreshLyrics();
 
+    /**
+     * @brief Apply a key to the lyrics view and request a frame if anything changed.
+     * @return false if the view is not on screen and the key should go elsewhere.
+     */
+    bool handleKey(const KeyEvent &event);
+
+    /**
+     * @brief Called when input changes the view between scheduled frames.
+     */
+    void setFrameRequestHandler(std::function<void()> handler) { frameRequestHandler = std::move(handler); }
+
+    /**
+     * @brief Seconds until the display next needs to change: the next lyric line or header clock tick.
+     * Capped at MAX_FRAME_INTERVAL so status lines posted while paused still show up.
+     */
+    double nextFrameDelay(double playbackRateValue, double elapsedValue) const;
+
+    /**
+     * @return Lyrics fetches answered by joining an identical request already in flight.
+     */
+    [[nodiscard]] uint64_t getCoalescedLyricsRequests() const { return lyricsFlights.getCoalesced(); }
+
+    /**
+     * @return Milliseconds from the last title change to its lyrics being attached, -1 before the first.
+     */
+    [[nodiscard]] int64_t getLastLyricsLatencyMs() const { return lastLyricsLatencyMs; }
+
+    /**
+     * @return Prefetched lyrics later attached to a track.
+     */
+    [[nodiscard]] uint64_t getPrefetchedLyricsHits() const { return prefetchHits.load(); }
+
+    /**
+     * @return Prefetched lyrics evicted before any track needed them.
+     */
+    [[nodiscard]] uint64_t getPrefetchedLyricsWasted() const { return prefetchWasted.load(); }
+
+    static constexpr double MIN_FRAME_INTERVAL = PlaybackSchedule::MIN_FRAME_INTERVAL;
+    static constexpr double MAX_FRAME_INTERVAL = PlaybackSchedule::MAX_FRAME_INTERVAL;
+
 private:
-    LyricsManager() = default;
-    ~LyricsManager() = default;
+    LyricsManager();
+    ~LyricsManager();
 
-    enum KeyAction {
-        NO_ACTION,
-        QUIT,
-        SCROLL
+    struct FetchedLyrics {
+        LyricTimeline plain;
+        LyricTimeline synced;
     };
 
-    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp);
+    /**
+     * @brief Download and parse lyrics from lrclib, paced by RateLimiter::lyrics() and bounded by LYRICS_BUDGET_MS.
+     * Null if the request failed, was cancelled or found nothing.
+     */
+    static std::shared_ptr<const FetchedLyrics> requestLyrics(const std::string &url, RateLimiter::Priority priority,
+                                                              const CancellationToken &cancel);
+
+    static constexpr int64_t LYRICS_BUDGET_MS = 8000;
+    static constexpr size_t MAX_WARM_LYRICS = 8;
+    static constexpr size_t FETCH_THREADS = 2;
+
+    /**
+     * @brief lrclib lookup for a track, without the duration; also the key of prefetched lyrics.
+     */
+    static std::string lyricsUrl(const std::string &artist, const std::string &title, const std::string &album);
+
+    /**
+     * @brief lyricsFlights key: a fetch for the current track never joins a prefetch waiting at the lowest priority.
+     */
+    static std::string flightKey(RateLimiter::Priority priority, const std::string &url);
+
+    /**
+     * @return Prefetched lyrics for url, removed from the warm set, or null if there are none.
+     */
+    std::shared_ptr<const FetchedLyrics> takeWarmLyrics(const std::string &url);
+
+    /**
+     * @brief Runs on the event loop. Lyrics for a track that has left the cache are dropped.
+     */
+    void attachLyrics(const std::string &trackId, uint64_t fetchId, const std::shared_ptr<const FetchedLyrics> &fetched);
+
+    enum ViewState {
+        PLAYING,
+        PAUSED
+    };
 
-    WINDOW *lyricsWin = nullptr;
-    WINDOW *headerWin = nullptr;
-    WINDOW *contentWin = nullptr;
+    std::unique_ptr<RenderTarget> renderTarget;
+    std::unique_ptr<Surface> headerSurface;
+    std::unique_ptr<Surface> contentSurface;
+    std::unique_ptr<Surface> statusSurface;
     bool manualScrollMode = false;
     bool ncursesInitialized = false;
     int autoScrollPosition = 0;
@@ -51,15 +160,36 @@ private:
     int maxVisibleLines = 0;
     int totalLines = 0;
     bool forceRedraw = false;
+    LyricCursor lyricCursor;
+    HeaderView headerView;
+    LyricsView lyricsView;
+    bool hintDirty = true;
+    ViewState viewState = PLAYING;
+    std::mutex statusMutex;
+    std::string statusText;
+    bool statusDirty = false;
+    std::function<void()> frameRequestHandler;
+    SingleFlight<std::string, std::shared_ptr<const FetchedLyrics>> lyricsFlights;
+    std::string pendingTrackId;
+    CancellationToken pendingCancel;
+    uint64_t pendingFetchId = 0;
+    int64_t lastLyricsLatencyMs = -1;
+    std::mutex warmMutex;
+    std::deque<std::pair<std::string, std::shared_ptr<const FetchedLyrics>>> warmLyrics;
+    std::atomic<uint64_t> prefetchHits{0};
+    std::atomic<uint64_t> prefetchWasted{0};
+    // Last, so it is stopped before anything its tasks use is destroyed
+    WorkQueue fetcher{FETCH_THREADS};
 
     void initNcurses();
     void endNcurses();
+    void handleResize();
+    void displayFrame(const LyricTimeline *lyrics, LyricsView::Mode mode, double playbackRateValue, double elapsedValue);
     void drawHeader(const std::string& artist, const std::string& title, double elapsed, double duration);
-    void drawSyncedLyrics(const std::vector<std::pair<int, std::string>>& lyrics, int currentIndex);
-    void drawPlainLyrics(const std::vector<std::string> &lyrics);
-    static std::string formatTime(double seconds);
-    static std::string truncateText(const std::string& text, int maxWidth);
-    KeyAction checkKeypress();
+    void postStatus(const std::string &message);
+    void drawStatus();
+    void drawSyncedLyrics(const LyricTimeline &lyrics, int currentIndex);
+    void drawPlainLyrics(const LyricTimeline &lyrics);
 
 };
 #endif //SCROBBLER_LYRICSMANAGER_H
@@ -0,0 +1,73 @@
+#ifndef BETTERSCROBBLER_LYRICSVIEW_H
+#define BETTERSCROBBLER_LYRICSVIEW_H
+
+#include <memory>
+#include <string>
+#include "RenderTarget.h"
+#include "LyricTimeline.h"
+#include "LineLayout.h"
+
+/**
+ * @brief Lyrics body rendered once per track into an off-screen pad surface.
+ * Scrolling moves the pad viewport and a line change re-styles only the lines whose state changed,
+ * so a frame costs the same no matter how many lines are visible.
+ */
+class LyricsView {
+public:
+    enum class Mode {
+        Synced,
+        Plain
+    };
+
+    /**
+     * @brief Draw into frame, creating the off-screen body from target.
+     */
+    void attach(RenderTarget &target, Surface &frame);
+    void detach();
+    void invalidate();
+
+    /**
+     * @brief Drop the loaded body so the next present() shows an empty frame.
+     */
+    void clearBody();
+
+    /**
+     * @brief Render every line into the pad. No-op if this body, at its current generation, is already loaded
+     * at the current width.
+     */
+    void load(const LyricTimeline &lyrics, Mode mode);
+
+    void setCurrent(int index);
+    void setHint(const std::string &hint);
+
+    /**
+     * @brief Stage the frame and the body from line top onwards. The caller flushes the target.
+     */
+    void present(int top);
+
+    [[nodiscard]] int getVisibleRows() const;
+    [[nodiscard]] int getWidth() const;
+
+private:
+    void drawLine(int index);
+    void drawBorderRows();
+
+    RenderTarget *target = nullptr;
+    Surface *frame = nullptr;
+    std::unique_ptr<Surface> pad;
+    LineLayout layout;
+    const LyricTimeline *lyrics = nullptr;
+    size_t loadedSize = 0;
+    uint64_t loadedGeneration = 0;
+    int loadedWidth = 0;
+    Mode mode = Mode::Synced;
+    int current = -1;
+    int paintedTop = -1;
+    int arrows = -1;
+    std::string hint;
+    bool frameDirty = true;
+    bool bordersDirty = true;
+    bool padDirty = false;
+};
+
+#endif //BETTERSCROBBLER_LYRICSVIEW_H
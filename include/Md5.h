@@ -0,0 +1,34 @@
+#ifndef BETTERSCROBBLER_MD5_H
+#define BETTERSCROBBLER_MD5_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Portable streaming MD5 (RFC 1321), used for Last.fm request signatures.
+ * Works entirely on the stack so signing never allocates.
+ */
+class Md5 {
+public:
+    static constexpr size_t DIGEST_LENGTH = 16;
+    static constexpr size_t HEX_LENGTH = DIGEST_LENGTH * 2;
+
+    Md5() { reset(); }
+
+    void reset();
+    void update(const void *data, size_t length);
+    void update(std::string_view data) { update(data.data(), data.size()); }
+    void finalize(uint8_t digest[DIGEST_LENGTH]);
+    void finalizeHex(char hex[HEX_LENGTH]);
+
+private:
+    void transform(const uint8_t block[64]);
+
+    uint32_t state[4]{};
+    uint64_t bitCount = 0;
+    uint8_t buffer[64]{};
+    size_t bufferLength = 0;
+};
+
+#endif //BETTERSCROBBLER_MD5_H
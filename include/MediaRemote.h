@@ -2,12 +2,31 @@
 #define SCROBBLER_MEDIAREMOTE_H
 
 #include <string>
+#include <vector>
 #include <mutex>
+#include <functional>
+#include <CoreFoundation/CoreFoundation.h>
 #include "LastFmScrobbler.h"
+#include "MetadataDebouncer.h"
+#include "Prefetcher.h"
 
 class MediaRemote {
 public:
-    MediaRemote();
+    /**
+     * @brief Delivers one Now Playing dictionary to the callback, or nullptr when nothing is playing.
+     */
+    using InfoSource = std::function<void(const std::function<void(CFDictionaryRef)> &)>;
+
+    /**
+     * @brief The tracks expected after currentTitle, soonest first, at most count of them. Blocks.
+     */
+    using UpNextSource = std::function<std::vector<Prefetcher::Hint>(const std::string &currentTitle, int count)>;
+
+    /**
+     * @param source Replaces MediaRemote.framework, e.g. with a scripted playback sequence.
+     * @param upNext Supplies the prefetch hints. Defaults to Apple Music's Up Next, or to none when source is set.
+     */
+    explicit MediaRemote(InfoSource source = nullptr, UpNextSource upNext = nullptr);
 
     ~MediaRemote();
 
@@ -17,6 +36,16 @@ public:
      */
     void registerForNowPlayingNotifications();
 
+    /**
+     * @brief Fetch and process Now Playing info once, as the playback poll does.
+     */
+    void poll();
+
+    /**
+     * @brief Counters for metadata transitions that were held back as transients.
+     */
+    [[nodiscard]] const MetadataDebouncer &getMetadataDebouncer() const;
+
 private:
     class Impl;
 
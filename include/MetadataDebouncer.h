@@ -0,0 +1,81 @@
+#ifndef BETTERSCROBBLER_METADATADEBOUNCER_H
+#define BETTERSCROBBLER_METADATADEBOUNCER_H
+
+#include <cstdint>
+#include <string>
+#include "Clock.h"
+
+/**
+ * @brief Stands between raw Now Playing dictionaries and TrackManager so that only real track changes get through.
+ * Players briefly report empty or half-updated metadata while switching tracks; a dictionary without a title
+ * is ignored, and a new artist/title/album is only committed once it has held for the settle window.
+ * Anything that flips back or changes again before then is dropped as a transient.
+ */
+class MetadataDebouncer {
+public:
+    struct Metadata {
+        std::string artist;
+        std::string title;
+        std::string album;
+
+        bool operator==(const Metadata &other) const {
+            return title == other.title && artist == other.artist && album == other.album;
+        }
+
+        bool operator!=(const Metadata &other) const { return !(*this == other); }
+    };
+
+    enum class Verdict {
+        /**
+         * @brief Nothing new: act on getCommitted().
+         */
+        UNCHANGED,
+        /**
+         * @brief Something new is settling; call again after msUntilSettled().
+         */
+        SETTLING,
+        /**
+         * @brief getCommitted() now holds a new track.
+         */
+        CHANGED
+    };
+
+    explicit MetadataDebouncer(int64_t settleMs, Clock &clock = Clock::getInstance())
+            : settleMs(settleMs), clock(clock) {}
+
+    Verdict observe(const Metadata &incoming);
+
+    [[nodiscard]] const Metadata &getCommitted() const { return committed; }
+
+    [[nodiscard]] int64_t msUntilSettled() const;
+
+    void setSettleMs(int64_t ms) { settleMs = ms; }
+
+    /**
+     * @return Candidates dropped because they changed or flipped back before settling.
+     */
+    [[nodiscard]] uint64_t getSuppressedCount() const { return suppressedCount; }
+
+    /**
+     * @return Dictionaries ignored because they had no title.
+     */
+    [[nodiscard]] uint64_t getFlushedCount() const { return flushedCount; }
+
+    [[nodiscard]] uint64_t getCommitCount() const { return commitCount; }
+
+private:
+    Verdict commit(const Metadata &metadata);
+
+    int64_t settleMs;
+    Clock &clock;
+    Metadata committed;
+    bool hasCommitted = false;
+    Metadata candidate;
+    bool settling = false;
+    int64_t candidateSinceMs = 0;
+    uint64_t suppressedCount = 0;
+    uint64_t flushedCount = 0;
+    uint64_t commitCount = 0;
+};
+
+#endif //BETTERSCROBBLER_METADATADEBOUNCER_H
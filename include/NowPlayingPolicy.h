@@ -0,0 +1,80 @@
+#ifndef BETTERSCROBBLER_NOWPLAYINGPOLICY_H
+#define BETTERSCROBBLER_NOWPLAYINGPOLICY_H
+
+#include <cstdint>
+#include <string>
+#include "Clock.h"
+
+/**
+ * @brief Decides when track.updateNowPlaying is worth sending. Fed every playback poll, it sends at once when
+ * the track changes, restarts or resumes, and otherwise only when Last.fm's now-playing status is about to
+ * lapse, which the server times by the duration sent with the last update.
+ */
+class NowPlayingPolicy {
+public:
+    enum class Decision {
+        SKIP,
+        TRACK_CHANGED,
+        RESTARTED,
+        RESUMED,
+        REFRESH
+    };
+
+    struct Observation {
+        std::string artist;
+        std::string title;
+        std::string album;
+        bool isMusic = false;
+        double playbackRate = 0.0;
+        double elapsed = 0.0;
+        double duration = 0.0;
+        /**
+         * @brief The play has been scrobbled or queued for scrobbling, so it is over as far as Last.fm is concerned.
+         */
+        bool scrobbleSettled = false;
+    };
+
+    explicit NowPlayingPolicy(Clock &clock = Clock::getInstance()) : clock(clock) {}
+
+    /**
+     * @brief Anything but SKIP means send now; the policy assumes the caller does and times the next refresh from it.
+     */
+    Decision observe(const Observation &observation);
+
+    /**
+     * @brief The update that observe() asked for did not go through; try again after FAILURE_RETRY_S.
+     */
+    void onSendFailed();
+
+    [[nodiscard]] uint64_t getSentCount() const { return sentCount; }
+    [[nodiscard]] uint64_t getSkippedCount() const { return skippedCount; }
+
+    static const char *describe(Decision decision);
+
+    /**
+     * @brief Lifetime assumed for an update sent without a duration.
+     */
+    static constexpr double UNKNOWN_DURATION_TTL_S = 300.0;
+    static constexpr double EXPIRY_MARGIN_S = 10.0;
+    static constexpr double FAILURE_RETRY_S = 30.0;
+    /**
+     * @brief Jumping back this far is taken as the track starting over rather than a small seek.
+     */
+    static constexpr double RESTART_JUMP_S = 10.0;
+
+private:
+    /**
+     * @brief Whether the track will still be playing when the status sent last lapses, e.g. after a long pause.
+     */
+    [[nodiscard]] bool outlivesStatus(const Observation &observation, double now) const;
+
+    Clock &clock;
+    std::string sentKey;
+    double expiresAt = 0.0;
+    double lastElapsed = 0.0;
+    bool wasPlaying = false;
+    uint64_t sentCount = 0;
+    uint64_t skippedCount = 0;
+};
+
+#endif //BETTERSCROBBLER_NOWPLAYINGPOLICY_H
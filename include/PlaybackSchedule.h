@@ -0,0 +1,29 @@
+#ifndef BETTERSCROBBLER_PLAYBACKSCHEDULE_H
+#define BETTERSCROBBLER_PLAYBACKSCHEDULE_H
+
+#include <cstdint>
+#include "EventLoop.h"
+
+/**
+ * @brief How MediaRemote arms the playback poll and the lyrics frame timer. Idle frames ride the poll's
+ * whole-period grid, so a paused player wakes the process once per period instead of once per timer.
+ */
+class PlaybackSchedule {
+public:
+    static constexpr int64_t PLAYBACK_POLL_MS = 1000;
+    static constexpr double MIN_FRAME_INTERVAL = 0.01;
+    static constexpr double MAX_FRAME_INTERVAL = 1.0;
+
+    /**
+     * @brief Poll now and then every PLAYBACK_POLL_MS, on whole multiples of the period.
+     */
+    static void armPoll(EventLoop &loop, EventLoop::TimerId poll);
+
+    /**
+     * @brief Arm the one-shot frame timer delaySeconds from now. A delay of MAX_FRAME_INTERVAL or more is an
+     * idle frame, which only has to land within that interval, so it fires with the first poll after now.
+     */
+    static void armFrame(EventLoop &loop, EventLoop::TimerId frame, double delaySeconds);
+};
+
+#endif //BETTERSCROBBLER_PLAYBACKSCHEDULE_H
@@ -0,0 +1,102 @@
+#ifndef BETTERSCROBBLER_PREFETCHER_H
+#define BETTERSCROBBLER_PREFETCHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "CancellationToken.h"
+#include "EventLoop.h"
+#include "WorkQueue.h"
+
+/**
+ * @brief Warms lyrics, and resolution for incomplete metadata, for the tracks the now-playing source says
+ * play next, so a track has its lyrics the moment it starts. Works on at most MAX_IN_FLIGHT tracks at once,
+ * on its own pool and at the lowest rate-limit priority. Call everything but the counters on the event loop.
+ */
+class Prefetcher {
+public:
+    /**
+     * @brief The app's prefetcher, warming through Helper and LyricsManager.
+     */
+    static Prefetcher &getInstance();
+
+    struct Hint {
+        std::string artist;
+        std::string title;
+        std::string album;
+    };
+
+    /**
+     * @return Id of the hinted track, or empty to skip it, e.g. because it is already cached.
+     */
+    using Identify = std::function<std::string(const Hint &hint)>;
+
+    /**
+     * @brief Warm one track. Runs on a pool thread and should return early once cancel is set.
+     */
+    using Warm = std::function<void(const Hint &hint, const CancellationToken &cancel)>;
+
+    /**
+     * @param loop Where finished jobs are reported; must outlive the prefetcher.
+     */
+    Prefetcher(EventLoop &loop, Identify identify, Warm warm);
+    ~Prefetcher();
+    Prefetcher(const Prefetcher &) = delete;
+    Prefetcher &operator=(const Prefetcher &) = delete;
+
+    /**
+     * @brief Replace the upcoming tracks, soonest first. Only the first Config::getPrefetchAhead() are warmed;
+     * work for tracks no longer listed is cancelled.
+     */
+    void hintUpcoming(const std::vector<Hint> &upcoming);
+
+    [[nodiscard]] uint64_t getStartedCount() const { return started.load(); }
+
+    [[nodiscard]] uint64_t getCancelledCount() const { return cancelled.load(); }
+
+    /**
+     * @return Prefetched lyrics and resolutions later used by a track that played.
+     */
+    [[nodiscard]] uint64_t getHitCount() const;
+
+    /**
+     * @return Prefetched results evicted unused, plus prefetches cancelled while running.
+     */
+    [[nodiscard]] uint64_t getWastedCount() const;
+
+    /**
+     * @return Hits over hits plus wasted, 0 before either.
+     */
+    [[nodiscard]] double getHitRate() const;
+
+    static constexpr size_t MAX_IN_FLIGHT = 2;
+
+private:
+    struct Job {
+        uint64_t id = 0;
+        std::string trackId;
+        Hint hint;
+        CancellationToken cancel;
+        bool running = false;
+        bool done = false;
+    };
+
+    void pump();
+
+    void finish(uint64_t id);
+
+    EventLoop &loop;
+    Identify identify;
+    Warm warm;
+    std::vector<Job> jobs;
+    size_t inFlight = 0;
+    uint64_t nextJobId = 0;
+    std::atomic<uint64_t> started{0};
+    std::atomic<uint64_t> cancelled{0};
+    // Last, so it is stopped before anything its tasks use is destroyed
+    WorkQueue workers{MAX_IN_FLIGHT};
+};
+
+#endif //BETTERSCROBBLER_PREFETCHER_H
@@ -0,0 +1,93 @@
+#ifndef BETTERSCROBBLER_RATELIMITER_H
+#define BETTERSCROBBLER_RATELIMITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "CancellationToken.h"
+#include "Clock.h"
+#include "Deadline.h"
+
+/**
+ * @brief Thread-safe token bucket shared by every request to one service.
+ * Waiters are served strictly by priority, FIFO within a class. The refill rate halves on every
+ * rate-limit error and creeps back to the configured rate as requests succeed.
+ */
+class RateLimiter {
+public:
+    /**
+     * @brief Declared from most to least urgent. LYRICS_PREFETCH also carries resolution for upcoming tracks.
+     */
+    enum class Priority {
+        SCROBBLE,
+        NOW_PLAYING,
+        RESOLUTION,
+        LYRICS_PREFETCH
+    };
+
+    /**
+     * @brief Last.fm allows roughly five calls per second per API key.
+     */
+    static RateLimiter &lastFm() {
+        static RateLimiter instance(5.0, 5.0);
+        return instance;
+    }
+
+    static RateLimiter &lyrics() {
+        static RateLimiter instance(4.0, 4.0);
+        return instance;
+    }
+
+    RateLimiter(double ratePerSecond, double burst, Clock &clock = Clock::getInstance());
+    RateLimiter(const RateLimiter &) = delete;
+    RateLimiter &operator=(const RateLimiter &) = delete;
+
+    /**
+     * @brief Block until a token is granted to this caller.
+     * @return false if cancel fired or the deadline passed first; no token is consumed then.
+     */
+    bool acquire(Priority priority, const CancellationToken &cancel = {}, const Deadline &deadline = {});
+
+    /**
+     * @brief The service answered with a rate-limit error: halve the rate and drain the bucket.
+     */
+    void onRateLimited();
+
+    void onSuccess();
+
+    [[nodiscard]] double getRate() const;
+    [[nodiscard]] uint64_t getRateLimitedCount() const;
+    [[nodiscard]] uint64_t getQueuedCount() const;
+
+private:
+    static constexpr int PRIORITY_COUNT = 4;
+    static constexpr double MIN_RATE = 0.2;
+
+    struct Waiter {
+        bool granted = false;
+    };
+
+    void refill(int64_t now);
+
+    /**
+     * @brief Hand available tokens to queued waiters in priority order and wake them. Call with mutex held.
+     */
+    void grant();
+    int64_t msUntilToken() const;
+
+    Clock &clock;
+    mutable std::mutex mutex;
+    std::condition_variable granted;
+    std::deque<std::shared_ptr<Waiter>> queues[PRIORITY_COUNT];
+    double configuredRate;
+    double rate;
+    double burst;
+    double tokens;
+    int64_t lastRefillMs;
+    uint64_t rateLimitedCount = 0;
+    uint64_t queuedCount = 0;
+};
+
+#endif //BETTERSCROBBLER_RATELIMITER_H
@@ -0,0 +1,93 @@
+#ifndef BETTERSCROBBLER_RENDERTARGET_H
+#define BETTERSCROBBLER_RENDERTARGET_H
+
+#include <memory>
+#include <string_view>
+
+/**
+ * @brief Rectangle the lyrics UI draws into: an on-screen window or an off-screen pad.
+ * Coordinates are relative to the surface. Changes reach the screen only when staged and
+ * the owning RenderTarget is flushed.
+ */
+class Surface {
+public:
+    struct Style {
+        short colorPair = 0;
+        bool bold = false;
+    };
+
+    enum class Glyph {
+        HorizontalLine,
+        VerticalLine,
+        UpArrow,
+        DownArrow
+    };
+
+    virtual ~Surface() = default;
+
+    [[nodiscard]] virtual int getRows() const = 0;
+    [[nodiscard]] virtual int getCols() const = 0;
+    [[nodiscard]] virtual int getOriginY() const = 0;
+    [[nodiscard]] virtual int getOriginX() const = 0;
+
+    virtual void resize(int rows, int cols) = 0;
+    virtual void moveTo(int y, int x) = 0;
+
+    virtual void erase() = 0;
+    virtual void clearToEol(int y, int x) = 0;
+    virtual void drawBox(Style style) = 0;
+
+    /**
+     * @brief Draw UTF-8 text clipped at the right edge.
+     * @return Column just after the last cell written.
+     */
+    virtual int drawText(int y, int x, std::string_view text, Style style) = 0;
+
+    virtual void drawGlyph(int y, int x, Glyph glyph, Style style, int count = 1) = 0;
+
+    /**
+     * @brief Mark every cell changed so the next stage copies the whole surface.
+     */
+    virtual void touch() = 0;
+
+    /**
+     * @brief Queue this window's changed cells for the next flush.
+     */
+    virtual void stage() = 0;
+
+    /**
+     * @brief Queue the changed cells of a pad region starting at (row, col) onto a screen rectangle.
+     */
+    virtual void stageRegion(int row, int col, int screenTop, int screenLeft, int screenBottom, int screenRight) = 0;
+};
+
+/**
+ * @brief Terminal the lyrics UI renders to: ncurses for the real screen, or an in-memory VirtualScreen.
+ */
+class RenderTarget {
+public:
+    virtual ~RenderTarget() = default;
+
+    virtual std::unique_ptr<Surface> createWindow(int rows, int cols, int y, int x) = 0;
+    virtual std::unique_ptr<Surface> createPad(int rows, int cols) = 0;
+
+    [[nodiscard]] virtual int getRows() const = 0;
+    [[nodiscard]] virtual int getCols() const = 0;
+
+    /**
+     * @brief Pick up the terminal's size after it changed. Surfaces keep their geometry until resized.
+     */
+    virtual void syncSize() = 0;
+
+    /**
+     * @brief Blank the whole screen on the next flush, e.g. behind surfaces that have just moved.
+     */
+    virtual void clear() = 0;
+
+    /**
+     * @brief Write everything staged since the last flush. No-op when nothing was staged.
+     */
+    virtual void flush() = 0;
+};
+
+#endif //BETTERSCROBBLER_RENDERTARGET_H
@@ -0,0 +1,66 @@
+#ifndef BETTERSCROBBLER_SCROBBLEQUEUE_H
+#define BETTERSCROBBLER_SCROBBLEQUEUE_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Scrobbles waiting for Last.fm to come back, persisted to Config's scrobble queue path
+ * so they survive a restart. Entries are submitted oldest first, in the order they were played.
+ */
+class ScrobbleQueue {
+public:
+    struct Entry {
+        std::string artist;
+        std::string track;
+        std::string album;
+        double duration = 0.0;
+        int64_t timeStamp = 0;
+    };
+
+    enum class Result {
+        SUBMITTED,
+        REJECTED,
+        FAILED
+    };
+
+    static ScrobbleQueue &getInstance() {
+        static ScrobbleQueue instance;
+        return instance;
+    }
+
+    ScrobbleQueue(const ScrobbleQueue &) = delete;
+    ScrobbleQueue &operator=(const ScrobbleQueue &) = delete;
+
+    void push(Entry entry);
+
+    /**
+     * @brief Hand entries to submit oldest first until one FAILED. SUBMITTED and REJECTED entries are removed.
+     * Runs submit without holding the queue lock.
+     * @return Number of entries submitted.
+     */
+    size_t flush(const std::function<Result(const Entry &)> &submit);
+
+    [[nodiscard]] size_t size();
+
+    /**
+     * @brief Last.fm refuses scrobbles older than this.
+     */
+    static constexpr int64_t MAX_AGE_SECONDS = 14 * 24 * 60 * 60;
+    static constexpr size_t MAX_ENTRIES = 1000;
+
+private:
+    ScrobbleQueue() = default;
+
+    void loadLocked();
+    void saveLocked() const;
+
+    std::mutex mutex;
+    std::deque<Entry> entries;
+    bool loaded = false;
+};
+
+#endif //BETTERSCROBBLER_SCROBBLEQUEUE_H
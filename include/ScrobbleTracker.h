@@ -0,0 +1,76 @@
+#ifndef BETTERSCROBBLER_SCROBBLETRACKER_H
+#define BETTERSCROBBLER_SCROBBLETRACKER_H
+
+#include <cstdint>
+#include <functional>
+
+/**
+ * @brief Scrobble bookkeeping for one play of a track: when it began, whether it has played long enough
+ * to count, and whether that play has been handed to the scrobbler. Fed every playback poll.
+ */
+class ScrobbleTracker {
+public:
+    /**
+     * @brief Hands a finished play, begun at startedAt, to the scrobbler. Returns true if it was taken.
+     */
+    using Submit = std::function<bool(int64_t startedAt)>;
+
+    enum class Event {
+        NONE,
+        /** The play just crossed the scrobble threshold. */
+        COUNTED,
+        /** A play that counted is back at the start: submit it if still pending, then start() the next one. */
+        LOOPED
+    };
+
+    /**
+     * @brief Last.fm's rule: music that has played past half its length or for four minutes.
+     */
+    static bool meetsThreshold(double elapsed, double duration, double playbackRate, bool isMusic);
+
+    /**
+     * @brief Begin a new play at startedAt, Unix seconds.
+     */
+    void start(int64_t startedAt);
+
+    /**
+     * @param eligible false for content that must never be scrobbled, e.g. non-music or scrobbling turned off.
+     */
+    Event observe(double elapsed, double duration, double playbackRate, bool eligible);
+
+    /**
+     * @return true if the play counted but has not been handed to the scrobbler yet.
+     */
+    [[nodiscard]] bool isPending() const { return counted && !submitted; }
+
+    [[nodiscard]] bool hasCounted() const { return counted; }
+
+    [[nodiscard]] bool isSubmitted() const { return submitted; }
+
+    void markSubmitted() { submitted = true; }
+
+    /**
+     * @brief The track is being left: submit the play if it counted and has not gone out yet.
+     * @return true if submit took it.
+     */
+    bool finish(const Submit &submit);
+
+    /**
+     * @brief After LOOPED: finish() the play that just ended, then start the next one at startedAt.
+     */
+    bool restart(int64_t startedAt, const Submit &submit);
+
+    [[nodiscard]] int64_t getStartedAt() const { return startedAt; }
+
+    /**
+     * @brief A counted play whose position is back under this share of the track has started over.
+     */
+    static constexpr double LOOP_PROGRESS = 0.1;
+
+private:
+    int64_t startedAt = 0;
+    bool counted = false;
+    bool submitted = false;
+};
+
+#endif //BETTERSCROBBLER_SCROBBLETRACKER_H
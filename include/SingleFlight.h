@@ -0,0 +1,72 @@
+#ifndef BETTERSCROBBLER_SINGLEFLIGHT_H
+#define BETTERSCROBBLER_SINGLEFLIGHT_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * @brief Collapses concurrent calls with the same key into one execution whose result every caller receives.
+ * Only calls that overlap are merged; once the running call returns, the next call for the key runs afresh.
+ */
+template<typename Key, typename Value>
+class SingleFlight {
+public:
+    /**
+     * @param shared Set to true if the result came from a call another thread started.
+     */
+    Value run(const Key &key, const std::function<Value()> &work, bool *shared = nullptr) {
+        std::promise<Value> promise;
+        std::shared_future<Value> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = inFlight.find(key);
+            if (it != inFlight.end()) {
+                pending = it->second;
+                coalesced++;
+            } else {
+                inFlight.emplace(key, promise.get_future().share());
+                executions++;
+            }
+        }
+
+        if (shared) *shared = pending.valid();
+        if (pending.valid()) {
+            return pending.get();
+        }
+
+        try {
+            Value value = work();
+            finish(key);
+            promise.set_value(value);
+            return value;
+        } catch (...) {
+            finish(key);
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    [[nodiscard]] uint64_t getExecutions() const { return executions.load(); }
+
+    /**
+     * @return Calls that were answered by joining one already in flight.
+     */
+    [[nodiscard]] uint64_t getCoalesced() const { return coalesced.load(); }
+
+private:
+    void finish(const Key &key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight.erase(key);
+    }
+
+    std::mutex mutex;
+    std::unordered_map<Key, std::shared_future<Value>> inFlight;
+    std::atomic<uint64_t> executions{0};
+    std::atomic<uint64_t> coalesced{0};
+};
+
+#endif //BETTERSCROBBLER_SINGLEFLIGHT_H
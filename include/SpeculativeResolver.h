@@ -0,0 +1,158 @@
+#ifndef BETTERSCROBBLER_SPECULATIVERESOLVER_H
+#define BETTERSCROBBLER_SPECULATIVERESOLVER_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "CancellationToken.h"
+#include "WorkQueue.h"
+
+/**
+ * @brief Races several interpretations of the same input and returns the best one that holds up.
+ * Every candidate's gates and producer run concurrently on a shared, bounded pool. A candidate is good once all
+ * of its gates pass and its producer returns a value, and bad as soon as any of them fails.
+ * The answer is the first candidate in priority order that is good, and it is decided as soon as every
+ * higher-priority candidate has turned out bad. Everything else is then cancelled.
+ */
+template<typename T>
+class SpeculativeResolver {
+public:
+    /**
+     * @param pool Runs the gates and producers, in priority order. It must keep running until resolve() returns,
+     * and resolve() must not be called from one of its threads.
+     */
+    explicit SpeculativeResolver(WorkQueue &pool) : pool(pool) {}
+
+    using Gate = std::function<bool(const CancellationToken &)>;
+    using Producer = std::function<std::optional<T>(const CancellationToken &)>;
+
+    /**
+     * @brief Add a candidate below all earlier ones in priority.
+     */
+    void add(std::vector<Gate> gates, Producer producer) {
+        candidates.push_back({std::move(gates), std::move(producer)});
+    }
+
+    /**
+     * @brief Block until the outcome is known. Losing jobs already running finish on the pool after returning;
+     * those that had not started are skipped.
+     * @param cancel Cancels every candidate, which then fail as their requests are abandoned.
+     */
+    std::optional<T> resolve(const CancellationToken &cancel = {}) {
+        if (candidates.empty()) {
+            return std::nullopt;
+        }
+
+        auto state = std::make_shared<State>();
+        state->slots.resize(candidates.size());
+        for (auto &slot : state->slots) {
+            slot.token = CancellationToken::createChild(cancel);
+        }
+
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            auto &candidate = candidates[i];
+            state->slots[i].pendingGates = candidate.gates.size();
+            for (auto &gate : candidate.gates) {
+                pool.post([state, i, gate] {
+                    const CancellationToken &token = state->slots[i].token;
+                    bool passed = !token.isCancelled() && gate(token);
+                    state->finishGate(i, passed);
+                });
+            }
+            pool.post([state, i, producer = candidate.producer] {
+                const CancellationToken &token = state->slots[i].token;
+                std::optional<T> value = token.isCancelled() ? std::nullopt : producer(token);
+                state->finishProducer(i, std::move(value));
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->decided.wait(lock, [&] { return state->done; });
+        return state->answer;
+    }
+
+private:
+    struct Candidate {
+        std::vector<Gate> gates;
+        Producer producer;
+    };
+
+    enum class Status {
+        PENDING,
+        GOOD,
+        BAD
+    };
+
+    struct Slot {
+        CancellationToken token;
+        size_t pendingGates = 0;
+        bool produced = false;
+        std::optional<T> value;
+        Status status = Status::PENDING;
+    };
+
+    struct State {
+        std::mutex mutex;
+        std::condition_variable decided;
+        std::vector<Slot> slots;
+        std::optional<T> answer;
+        bool done = false;
+
+        void finishGate(size_t i, bool passed) {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot &slot = slots[i];
+            if (slot.status != Status::PENDING) return;
+            if (!passed) {
+                fail(slot);
+            } else if (--slot.pendingGates == 0 && slot.produced) {
+                slot.status = Status::GOOD;
+            }
+            settle();
+        }
+
+        void finishProducer(size_t i, std::optional<T> value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot &slot = slots[i];
+            if (slot.status != Status::PENDING) return;
+            if (!value) {
+                fail(slot);
+            } else {
+                slot.produced = true;
+                slot.value = std::move(value);
+                if (slot.pendingGates == 0) {
+                    slot.status = Status::GOOD;
+                }
+            }
+            settle();
+        }
+
+        void fail(Slot &slot) {
+            slot.status = Status::BAD;
+            slot.token.cancel();
+        }
+
+        void settle() {
+            if (done) return;
+            for (auto &slot : slots) {
+                if (slot.status == Status::PENDING) return;
+                if (slot.status == Status::GOOD) {
+                    answer = std::move(slot.value);
+                    break;
+                }
+            }
+            done = true;
+            for (auto &slot : slots) {
+                slot.token.cancel();
+            }
+            decided.notify_all();
+        }
+    };
+
+    WorkQueue &pool;
+    std::vector<Candidate> candidates;
+};
+
+#endif //BETTERSCROBBLER_SPECULATIVERESOLVER_H
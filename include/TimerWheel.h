@@ -0,0 +1,67 @@
+#ifndef BETTERSCROBBLER_TIMERWHEEL_H
+#define BETTERSCROBBLER_TIMERWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Hierarchical timing wheel with 1 ms ticks: four levels of 64 slots, covering about 4.6 hours
+ * before a timer has to be cascaded again. Insert and remove are O(1); advancing skips over empty
+ * stretches of the lowest level instead of visiting every tick.
+ * Nodes are intrusive and owned by the caller.
+ */
+class TimerWheel {
+public:
+    struct Node {
+        Node *prev = nullptr;
+        Node *next = nullptr;
+        int64_t deadline = 0;
+        int level = -1;
+
+        [[nodiscard]] bool isLinked() const { return next != nullptr; }
+    };
+
+    explicit TimerWheel(int64_t nowMs);
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    /**
+     * @brief Schedule node at deadlineMs. A deadline at or before the current tick fires on the next advance.
+     */
+    void insert(Node &node, int64_t deadlineMs);
+    void remove(Node &node);
+
+    /**
+     * @brief Move time forward to nowMs and append every node that came due, in deadline order per tick.
+     */
+    void advance(int64_t nowMs, std::vector<Node *> &expired);
+
+    /**
+     * @return Earliest deadline in the wheel, or -1 if it is empty.
+     */
+    [[nodiscard]] int64_t nextDeadline() const;
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] int64_t getCurrent() const { return current; }
+
+private:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+    static constexpr int64_t MASK = SLOTS - 1;
+    static constexpr int64_t SPAN = int64_t(1) << (LEVELS * SLOT_BITS);
+
+    void place(Node &node);
+    void link(Node &head, Node &node, int level);
+    void cascade(int level, int index);
+    void drain(Node &head, std::vector<Node *> &expired);
+
+    Node slots[LEVELS][SLOTS];
+    Node overdue;
+    size_t levelCount[LEVELS] = {};
+    int64_t current;
+    size_t count = 0;
+};
+
+#endif //BETTERSCROBBLER_TIMERWHEEL_H
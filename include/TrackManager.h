@@ -3,7 +3,12 @@
 
 #include <string>
 #include <map>
+#include <mutex>
 #include "LastFmScrobbler.h"
+#include "LyricTimeline.h"
+#include "CancellationToken.h"
+#include "ScrobbleTracker.h"
+#include "WorkQueue.h"
 
 class TrackManager {
 public:
@@ -19,15 +24,12 @@ public:
     }
 
     struct TrackState {
-        bool hasScrobbled;
-        bool hasSubmitted;
+        ScrobbleTracker scrobbleTracker;
         bool hasSyncedLyrics;
-        int beginTimeStamp;
         double lastElapsed;
         double duration;
         double lastFetchTime;
         double lastReportedElapsed;
-        double lastNowPlayingSent;
         double lastPlaybackRate;
         bool isMusic;
         std::string artist;
@@ -35,25 +37,33 @@ public:
         std::string title;
         std::string extractTitle;
         std::string album;
-        std::string plainLyrics;
-        std::string syncedLyrics;
-        std::vector<std::string> parsedPlainLyrics;
-        std::vector<std::pair<int, std::string>> parsedSyncedLyrics;
+        LyricTimeline plainLyrics;
+        LyricTimeline syncedLyrics;
         int currentLyricIndex;
 
         TrackState() :
-                hasScrobbled(false),
-                hasSubmitted(false),
-                beginTimeStamp(0),
+                hasSyncedLyrics(false),
                 lastElapsed(0.0),
                 duration(0.0),
                 lastFetchTime(0.0),
                 lastReportedElapsed(0.0),
-                lastNowPlayingSent(0.0),
                 lastPlaybackRate(0.0),
-                isMusic(false) {}
+                isMusic(false),
+                currentLyricIndex(-1) {}
+
+        [[nodiscard]] size_t lyricsMemoryUsage() const {
+            return plainLyrics.memoryUsage() + syncedLyrics.memoryUsage();
+        }
     };
 
+    ~TrackManager() {
+        trackRequests.cancel();
+    }
+
+    /**
+     * @brief Scrobble the previous track and switch to this one. Metadata that needs resolving is resolved on a
+     * worker; until then the current track is a non-music placeholder.
+     */
     void processTitleChange(const std::string &artist,
                             const std::string &title,
                             const std::string &album,
@@ -77,6 +87,11 @@ public:
 
     [[nodiscard]] const std::string &getLastAlbum() const { return lastAlbum; }
 
+    /**
+     * @return Clock::nowMs() at the last processTitleChange.
+     */
+    [[nodiscard]] int64_t getTitleChangedMs() const { return titleChangedMs; }
+
     [[nodiscard]] std::string getExtractedTitle() const {
         return currentTrack->extractTitle;
     }
@@ -103,6 +118,17 @@ public:
 
     bool isFromMusicPlatform = false;
 private:
+    /**
+     * @brief Switch to the track once it is known whether, and as what, it is music.
+     */
+    void finishTitleChange(const std::string &artist, const std::string &title, const std::string &album,
+                           bool isMusic, const std::string &resolvedArtist, const std::string &resolvedTitle);
+
+    /**
+     * @brief Hands a play of track to LastFmScrobbler, for ScrobbleTracker::finish() and restart().
+     */
+    ScrobbleTracker::Submit submitPlay(const TrackState &track);
+
     static const size_t MAX_TRACK_CACHE = 50;
     std::map<std::string, TrackState> trackCache;
     TrackState *currentTrack = nullptr;
@@ -114,6 +140,10 @@ private:
     std::string lastPlaybackState;
     std::string extractedTitle;
     std::string extractedArtist;
+    CancellationToken trackRequests = CancellationToken::create();
+    int64_t titleChangedMs = 0;
+    TrackState resolvingTrack;
+    WorkQueue resolver;
 
     std::mutex trackMutex;
 };
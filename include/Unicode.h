@@ -0,0 +1,58 @@
+#ifndef BETTERSCROBBLER_UNICODE_H
+#define BETTERSCROBBLER_UNICODE_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Self-contained UTF-8 normalization that does not depend on Foundation or ICU.
+ * Tables cover Latin, Greek, Cyrillic, kana, Hangul, the CJK compatibility ideographs
+ * and the halfwidth/fullwidth forms block, which is what shows up in track metadata.
+ */
+class Unicode {
+public:
+    enum class Form {
+        NFC,        // Canonical composition
+        NFKC,       // NFC plus folding of the halfwidth/fullwidth compatibility forms
+        NarrowNFC   // NFC with fullwidth forms folded to halfwidth (legacy normalizeString behaviour)
+    };
+
+    /**
+     * @brief Normalize input to the given form and strip ASCII control characters.
+     * Printable ASCII input is returned as-is without touching scratch.
+     * @return View of either input or scratch, valid until scratch is modified.
+     * Returns a null view (data() == nullptr) if input is not valid UTF-8.
+     */
+    static std::string_view normalize(std::string_view input, std::string &scratch, Form form = Form::NFC);
+
+    static std::string caseFold(std::string_view input);
+
+    /**
+     * @brief Terminal columns a code point occupies: 0 for combining marks, 2 for East Asian wide/fullwidth.
+     */
+    static int codePointWidth(char32_t cp);
+
+    /**
+     * @brief Terminal columns occupied by a UTF-8 string, measured per grapheme cluster.
+     * Invalid bytes count as one column each.
+     */
+    static int displayWidth(std::string_view input);
+
+    /**
+     * @brief Byte length of the longest prefix of whole grapheme clusters that fits in maxColumns.
+     * @param columns Receives the width of that prefix if non-null.
+     */
+    static size_t fitColumns(std::string_view input, int maxColumns, int *columns = nullptr);
+
+    /**
+     * @brief Byte length of the grapheme cluster at the start of input, 0 if input is empty.
+     * @param columns Receives the cluster's display width.
+     */
+    static size_t clusterLength(std::string_view input, int &columns);
+
+    static bool isPrintableAscii(std::string_view input);
+    static bool isValidUtf8(std::string_view input);
+    static void stripAsciiControls(std::string &str);
+};
+
+#endif //BETTERSCROBBLER_UNICODE_H
@@ -3,46 +3,173 @@
 
 #include <string>
 #include <map>
-#import <curl/curl.h>
-#import "Credentials.h"
+#include <cstdint>
+#include <functional>
+#include <curl/curl.h>
+#include "Credentials.h"
+#include "ApiResponse.h"
+#include "CancellationToken.h"
+#include "Deadline.h"
+#include "SingleFlight.h"
+#include "RateLimiter.h"
+#include "ScrobbleQueue.h"
 
 class UrlUtils {
 public:
-    static std::string buildApiUrl(const std::string &method,
-                                   const std::map<std::string, std::string> &params);
+    static constexpr const char *API_URL = "https://ws.audioscrobbler.com/2.0/";
 
-    static std::string sendGetRequest(const std::string &url, CURL *curl = nullptr, int maxRetries = 3);
+    /**
+     * @brief Default budget for one API call: connect, transfer, backoff and every retry.
+     */
+    static constexpr int64_t DEFAULT_BUDGET_MS = 15000;
 
-    static std::string sendPostRequest(const std::string &url,
-                                       const std::map<std::string, std::string> &params,
-                                       CURL *curl = nullptr, int maxRetries = 3);
+    static std::string buildApiUrl(const std::string &method,
+                                   const std::map<std::string, std::string> &params);
 
-    static std::string generateSignature(const std::map<std::string, std::string> &params,
-                                         Credentials &credentials);
+    /**
+     * @brief Signed track.scrobble form body for entry. Once body has grown to fit, this does not allocate.
+     * @return false, leaving body empty, if the parameters do not fit in an ApiRequest.
+     */
+    static bool encodeScrobble(const ScrobbleQueue::Entry &entry, const Credentials::Secrets &secrets,
+                               std::string &body);
+
+    /**
+     * @brief Signed track.updateNowPlaying form body, built the same way as encodeScrobble().
+     */
+    static bool encodeNowPlaying(const std::string &artist, const std::string &track, const std::string &album,
+                                 double duration, const Credentials::Secrets &secrets, std::string &body);
+
+    /**
+     * @brief Without a handle, a fresh one from createHandle() is used, which makes the call safe from any thread.
+     * A GET for a URL already in flight in the same priority class waits for that request and shares its response.
+     * Every attempt first waits for a token from RateLimiter::lastFm() in the given priority class.
+     * @param cancel Aborts the wait for a token, a transfer in progress or a retry backoff;
+     * a cancelled request returns an empty response.
+     * @param deadline Covers every attempt; no retry is started that could not finish before it.
+     */
+    static ApiResponse sendGetRequest(const std::string &url, CURL *curl = nullptr, int maxRetries = 3,
+                                      const CancellationToken &cancel = {},
+                                      RateLimiter::Priority priority = RateLimiter::Priority::RESOLUTION,
+                                      const Deadline &deadline = Deadline::after(DEFAULT_BUDGET_MS));
+
+    static ApiResponse sendPostRequest(const std::string &url,
+                                      const std::string &postFields,
+                                       CURL *curl = nullptr, int maxRetries = 3,
+                                       const CancellationToken &cancel = {},
+                                       RateLimiter::Priority priority = RateLimiter::Priority::SCROBBLE,
+                                       const Deadline &deadline = Deadline::after(DEFAULT_BUDGET_MS));
+
+    /**
+     * @brief New easy handle attached to the process-wide DNS, TLS session and connection cache,
+     * so short-lived handles on worker threads still reuse connections.
+     */
+    static CURL *createHandle();
+
+    /**
+     * @return GETs answered by joining an identical request already in flight.
+     */
+    static uint64_t getCoalescedRequests() { return getFlights.getCoalesced(); }
 
     static std::string urlEncode(const std::string &input);
 
-private:
-
-    static std::string buildUrl(const std::string &baseUrl,
-                                const std::map<std::string, std::string> &params);
-
-    static std::string md5(const std::string &input);
-
-    static std::string generateApiSignature(const std::map<std::string, std::string> &params,
-                                            const std::string &apiSecret);
+    /**
+     * @brief Stands in for curl_easy_perform. postFields is null for GET.
+     */
+    using Transport = std::function<CURLcode(const std::string &url, const std::string *postFields,
+                                             std::string &response)>;
+
+    /**
+     * @brief Route every request through transport instead of the network, e.g. a mock Last.fm. Empty restores curl.
+     */
+    static void setTransport(Transport transport);
+
+    static constexpr int64_t BASE_BACKOFF_MS = 500;
+    static constexpr int64_t MAX_BACKOFF_MS = 30000;
+
+    /**
+     * @return Milliseconds from a Retry-After value in seconds or as an HTTP-date, at most MAX_BACKOFF_MS;
+     * -1 if unparsable.
+     */
+    static int64_t parseRetryAfter(std::string value);
+
+    /**
+     * @return The next retry delay after previousMs: decorrelated jitter between BASE_BACKOFF_MS and three times
+     * previousMs, capped at MAX_BACKOFF_MS.
+     */
+    static int64_t nextBackoff(int64_t previousMs);
+
+    /**
+     * @brief What perform() learned about a response besides its body.
+     */
+    struct ResponseInfo {
+        long status = 0;
+        int64_t retryAfterMs = -1;
+    };
+
+    /**
+     * @brief Run one request on curl, or on the installed transport. Options other than URL,
+     * body, write target and timeouts must already be set on curl.
+     * @param info Filled with the HTTP status and any Retry-After header. A transport leaves status at 0.
+     * @return CURLE_OPERATION_TIMEDOUT when the deadline passes, CURLE_ABORTED_BY_CALLBACK when cancel fires.
+     */
+    static CURLcode perform(CURL *curl, const std::string &url, const std::string *postFields, std::string &response,
+                            const Deadline &deadline = {}, const CancellationToken &cancel = {},
+                            ResponseInfo *info = nullptr);
+
+    /**
+     * @return true if the last failed request on this thread failed for a reason that may go away,
+     * e.g. the service was down or its circuit open, rather than being rejected.
+     */
+    static bool lastFailureWasTransient() { return transientFailure; }
+
+    /**
+     * @return Last.fm error code of the last request on this thread, 0 if it had none.
+     */
+    static int getLastErrorCode() { return lastErrorCode; }
 
+private:
     static size_t writeCallback(void *ptr, size_t size, size_t nmemb, std::string *data);
 
-    static bool processResponse(const std::string &response);
-
-    static bool shouldRetry(const std::string &response, int attempt);
-
-    static void waitBeforeRetry(int attempt);
-
-    static std::string lastError;
-    static std::chrono::system_clock::time_point lastRequestTime;
-    static constexpr int MIN_REQUEST_INTERVAL_MS = 250;
+    static constexpr long CONNECT_TIMEOUT_MS = 5000;
+    static constexpr long STALL_TIMEOUT_S = 10;
+    static constexpr int64_t RETRY_SLICE_MS = 100;
+
+    static int progressCallback(void *clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t);
+
+    static size_t headerCallback(char *buffer, size_t size, size_t nitems, ResponseInfo *info);
+
+    /**
+     * @brief Retry loop shared by GET and POST. postFields is null for GET.
+     */
+    static ApiResponse execute(const std::string &url, const std::string *postFields, CURL *curl, int maxRetries,
+                               const CancellationToken &cancel, RateLimiter::Priority priority,
+                               const Deadline &deadline);
+
+    static bool processResponse(const ApiResponse &response, long status);
+
+    static bool isTransient(const ApiResponse &response, long status);
+
+    /**
+     * @return false if the wait would overrun the deadline or cancel fired while waiting.
+     */
+    static bool waitBeforeRetry(int64_t delayMs, const CancellationToken &cancel, const Deadline &deadline);
+
+    /**
+     * @brief A GET's response with the failure state execute() left on the thread that ran it,
+     * so callers that joined the flight see the same lastFailureWasTransient() and getLastErrorCode().
+     */
+    struct FlightOutcome {
+        ApiResponse response;
+        std::string error;
+        bool transient = false;
+        int errorCode = 0;
+    };
+
+    static thread_local std::string lastError;
+    static thread_local bool transientFailure;
+    static thread_local int lastErrorCode;
+    static SingleFlight<std::string, FlightOutcome> getFlights;
+    static Transport transport;
 };
 
 #endif //BETTERSCROBBLER_URLUTILS_H
@@ -0,0 +1,77 @@
+#ifndef BETTERSCROBBLER_VIRTUALSCREEN_H
+#define BETTERSCROBBLER_VIRTUALSCREEN_H
+
+#include <cstdint>
+#include <vector>
+#include "RenderTarget.h"
+
+/**
+ * @brief In-memory terminal for measuring the lyrics UI without a tty.
+ * Keeps the same front/back buffer split as curses and, on flush, counts the bytes a
+ * VT100-style terminal would receive: cursor moves, SGR changes and UTF-8 text.
+ */
+class VirtualScreen : public RenderTarget {
+public:
+    struct Cell {
+        uint32_t glyph = 0;   // Hash of the grapheme cluster's UTF-8 bytes
+        uint8_t bytes = 0;
+        uint8_t width = 1;    // 0 for the trailing half of a wide cluster
+        short colorPair = 0;
+        bool bold = false;
+
+        bool operator==(const Cell &other) const {
+            return glyph == other.glyph && width == other.width &&
+                   colorPair == other.colorPair && bold == other.bold;
+        }
+        bool operator!=(const Cell &other) const { return !(*this == other); }
+    };
+
+    struct Stats {
+        uint64_t flushes = 0;
+        uint64_t bytes = 0;
+        uint64_t cellsChanged = 0;
+        size_t lastFlushBytes = 0;
+    };
+
+    VirtualScreen(int rows, int cols);
+
+    std::unique_ptr<Surface> createWindow(int rows, int cols, int y, int x) override;
+    std::unique_ptr<Surface> createPad(int rows, int cols) override;
+
+    [[nodiscard]] int getRows() const override { return rows; }
+    [[nodiscard]] int getCols() const override { return cols; }
+
+    /**
+     * @brief No-op: the size only changes through resize().
+     */
+    void syncSize() override {}
+
+    void clear() override;
+
+    void flush() override;
+
+    /**
+     * @brief Simulate a terminal resize. The next flush repaints every cell.
+     */
+    void resize(int newRows, int newCols);
+
+    [[nodiscard]] const Stats &getStats() const { return stats; }
+    void resetStats() { stats = {}; }
+
+    static Cell blankCell();
+
+    /**
+     * @brief Copy cells into the back buffer at (y, x), clipped to the screen.
+     */
+    void stageCells(const Cell *cells, int count, int y, int x);
+
+private:
+    int rows;
+    int cols;
+    std::vector<Cell> front;
+    std::vector<Cell> back;
+    bool staged = false;
+    Stats stats;
+};
+
+#endif //BETTERSCROBBLER_VIRTUALSCREEN_H
@@ -0,0 +1,47 @@
+#ifndef BETTERSCROBBLER_WORKQUEUE_H
+#define BETTERSCROBBLER_WORKQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Background threads running posted tasks, for blocking work that must stay off the EventLoop.
+ * Tasks start in the order they were posted; with the default single thread they also finish in that order.
+ * Results go back to the loop through EventLoop::post().
+ */
+class WorkQueue {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkQueue(size_t threads = 1);
+    ~WorkQueue();
+    WorkQueue(const WorkQueue &) = delete;
+    WorkQueue &operator=(const WorkQueue &) = delete;
+
+    /**
+     * @brief Run task after everything posted before it. Safe to call from any thread; ignored after stop().
+     */
+    void post(Task task);
+
+    /**
+     * @brief Drop tasks that have not started and wait for those in progress.
+     */
+    void stop();
+
+    [[nodiscard]] size_t getPendingCount() const;
+
+private:
+    void run();
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::deque<Task> tasks;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+#endif //BETTERSCROBBLER_WORKQUEUE_H
@@ -0,0 +1,97 @@
+#include "include/ApiRequest.h"
+#include "include/Md5.h"
+#include <cstdio>
+
+namespace {
+    constexpr auto buildUnreservedTable() {
+        std::array<bool, 256> table{};
+        for (int c = '0'; c <= '9'; c++) table[c] = true;
+        for (int c = 'A'; c <= 'Z'; c++) table[c] = true;
+        for (int c = 'a'; c <= 'z'; c++) table[c] = true;
+        table['-'] = table['.'] = table['_'] = table['~'] = true;
+        return table;
+    }
+
+    constexpr auto kUnreserved = buildUnreservedTable();
+
+    bool isSignatureExcluded(std::string_view key) {
+        return key == "format" || key == "callback" || key == "api_sig";
+    }
+}
+
+ApiRequest::ApiRequest(std::string_view method) {
+    params[0] = {"method", method};
+    count = 1;
+}
+
+bool ApiRequest::set(std::string_view key, std::string_view value) {
+    size_t i = 0;
+    while (i < count && params[i].key < key) {
+        i++;
+    }
+    if (i < count && params[i].key == key) {
+        params[i].value = value;
+        return true;
+    }
+    if (count == MAX_PARAMS) {
+        return false;
+    }
+    for (size_t j = count; j > i; j--) {
+        params[j] = params[j - 1];
+    }
+    params[i] = {key, value};
+    count++;
+    return true;
+}
+
+bool ApiRequest::set(std::string_view key, int64_t value) {
+    if (numberCount == MAX_NUMBERS) {
+        return false;
+    }
+    char *slot = numbers[numberCount++];
+    int length = std::snprintf(slot, NUMBER_LENGTH, "%lld", static_cast<long long>(value));
+    return set(key, std::string_view(slot, static_cast<size_t>(length)));
+}
+
+void ApiRequest::appendFormEncoded(std::string &out, std::string_view input) {
+    static const char digits[] = "0123456789ABCDEF";
+    for (char ch: input) {
+        auto c = static_cast<unsigned char>(ch);
+        if (kUnreserved[c]) {
+            out.push_back(ch);
+        } else if (c == ' ') {
+            out.push_back('+');
+        } else {
+            out.push_back('%');
+            out.push_back(digits[c >> 4]);
+            out.push_back(digits[c & 0x0F]);
+        }
+    }
+}
+
+void ApiRequest::encodeSigned(std::string &out, std::string_view apiSecret) const {
+    out.clear();
+    Md5 signature;
+
+    for (size_t i = 0; i < count; i++) {
+        const Param &param = params[i];
+        if (!isSignatureExcluded(param.key)) {
+            signature.update(param.key);
+            signature.update(param.value);
+        }
+        if (i > 0) {
+            out.push_back('&');
+        }
+        appendFormEncoded(out, param.key);
+        out.push_back('=');
+        appendFormEncoded(out, param.value);
+    }
+
+    signature.update(apiSecret);
+    char hex[Md5::HEX_LENGTH];
+    signature.finalizeHex(hex);
+
+    out += "&api_sig=";
+    out.append(hex, Md5::HEX_LENGTH);
+    out += "&format=json";
+}
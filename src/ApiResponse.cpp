@@ -0,0 +1,204 @@
+#include "include/ApiResponse.h"
+#include <cstdlib>
+
+using json = nlohmann::json;
+
+namespace {
+    class FieldSax : public nlohmann::json_sax<json> {
+    public:
+        FieldSax(const std::vector<std::string_view> &paths, const JsonFieldExtractor::Callback &callback)
+                : paths(paths), callback(callback) {}
+
+        bool null() override { return scalar("null"); }
+
+        bool boolean(bool value) override { return scalar(value ? "true" : "false"); }
+
+        bool number_integer(number_integer_t value) override {
+            return scalar(std::to_string(value));
+        }
+
+        bool number_unsigned(number_unsigned_t value) override {
+            return scalar(std::to_string(value));
+        }
+
+        bool number_float(number_float_t, const string_t &text) override { return scalar(text); }
+
+        bool string(string_t &value) override { return scalar(value); }
+
+        bool binary(binary_t &) override { return true; }
+
+        bool start_object(std::size_t) override {
+            enter(false);
+            return true;
+        }
+
+        bool key(string_t &value) override {
+            currentKey = value;
+            return true;
+        }
+
+        bool end_object() override {
+            leave();
+            return true;
+        }
+
+        bool start_array(std::size_t) override {
+            enter(true);
+            return true;
+        }
+
+        bool end_array() override {
+            leave();
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) override {
+            return false;
+        }
+
+    private:
+        struct Frame {
+            bool isArray;
+            size_t pathLength;
+            size_t index;
+        };
+
+        void appendSegment() {
+            if (frames.empty()) return;
+            if (frames.back().isArray) {
+                path += "[]";
+            } else {
+                if (frames.size() > 1) path += '.';
+                path += currentKey;
+            }
+        }
+
+        void enter(bool isArray) {
+            size_t length = path.size();
+            appendSegment();
+            frames.push_back({isArray, length, 0});
+        }
+
+        void leave() {
+            path.resize(frames.back().pathLength);
+            frames.pop_back();
+            if (!frames.empty() && frames.back().isArray) {
+                frames.back().index++;
+            }
+        }
+
+        bool scalar(std::string_view value) {
+            size_t length = path.size();
+            appendSegment();
+            for (size_t i = 0; i < paths.size(); i++) {
+                if (paths[i] == path) {
+                    callback(i, elementIndex(), value);
+                    break;
+                }
+            }
+            path.resize(length);
+            if (!frames.empty() && frames.back().isArray) {
+                frames.back().index++;
+            }
+            return true;
+        }
+
+        [[nodiscard]] size_t elementIndex() const {
+            for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+                if (it->isArray) return it->index;
+            }
+            return 0;
+        }
+
+        const std::vector<std::string_view> &paths;
+        const JsonFieldExtractor::Callback &callback;
+        std::vector<Frame> frames;
+        std::string path;
+        std::string currentKey;
+    };
+}
+
+bool JsonFieldExtractor::extract(std::string_view input, const Callback &callback) const {
+    FieldSax sax(paths, callback);
+    return json::sax_parse(input.begin(), input.end(), &sax);
+}
+
+namespace {
+    enum ResponseField : size_t {
+        ERROR,
+        MESSAGE,
+        TOKEN,
+        SESSION_KEY,
+        MATCH_NAME,
+        MATCH_ARTIST,
+        MATCH_LISTENERS
+    };
+}
+
+ApiResponse::ApiResponse(std::string responseBody) : body(std::move(responseBody)) {
+    static const JsonFieldExtractor responseFields({
+            "error",
+            "message",
+            "token",
+            "session.key",
+            "results.trackmatches.track[].name",
+            "results.trackmatches.track[].artist",
+            "results.trackmatches.track[].listeners"
+    });
+
+    validJson = responseFields.extract(body, [this](size_t field, size_t element, std::string_view value) {
+        if (field >= MATCH_NAME && element >= matches.size()) {
+            matches.resize(element + 1);
+        }
+        switch (field) {
+            case ERROR:
+                errorCode = std::atoi(std::string(value).c_str());
+                if (errorCode == 0) errorCode = -1;
+                break;
+            case MESSAGE:
+                errorMessage = value;
+                break;
+            case TOKEN:
+                token = value;
+                break;
+            case SESSION_KEY:
+                sessionKey = value;
+                break;
+            case MATCH_NAME:
+                matches[element].name = value;
+                break;
+            case MATCH_ARTIST:
+                matches[element].artist = value;
+                break;
+            default:
+                matches[element].listeners = std::atoi(std::string(value).c_str());
+                break;
+        }
+    });
+}
+
+const json &ApiResponse::document() const {
+    if (!dom) {
+        dom = nlohmann::json::parse(body, nullptr, false);
+        if (dom->is_discarded()) {
+            dom = nullptr;
+        }
+    }
+    return *dom;
+}
+
+std::string ApiResponse::field(std::string_view path) const {
+    if (path == "token") return token;
+    if (path == "session.key") return sessionKey;
+
+    const json *node = &document();
+    while (!path.empty() && node->is_object()) {
+        size_t dot = path.find('.');
+        auto it = node->find(std::string(path.substr(0, dot)));
+        if (it == node->end()) return {};
+        node = &*it;
+        path = dot == std::string_view::npos ? std::string_view() : path.substr(dot + 1);
+    }
+    if (!path.empty() || node->is_structured() || node->is_null()) return {};
+    return node->is_string() ? node->get<std::string>() : node->dump();
+}
@@ -0,0 +1,115 @@
+#include "include/CircuitBreaker.h"
+#include "include/Logger.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+
+CircuitBreaker &CircuitBreaker::forUrl(const std::string &url) {
+    static std::mutex registryMutex;
+    static std::map<std::string, std::unique_ptr<CircuitBreaker>> breakers;
+
+    std::string host = hostOf(url);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto &breaker = breakers[host];
+    if (!breaker) {
+        breaker = std::make_unique<CircuitBreaker>(host);
+    }
+    return *breaker;
+}
+
+std::string CircuitBreaker::hostOf(const std::string &url) {
+    size_t start = url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+    size_t end = url.find_first_of("/?#", start);
+    return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+CircuitBreaker::CircuitBreaker(std::string host, Clock &clock) : host(std::move(host)), clock(clock) {}
+
+bool CircuitBreaker::allowRequest() {
+    std::lock_guard<std::mutex> lock(mutex);
+    switch (state) {
+        case State::CLOSED:
+            return true;
+        case State::OPEN:
+            if (clock.nowMs() < openUntilMs) {
+                rejectedCount++;
+                return false;
+            }
+            state = State::HALF_OPEN;
+            probeInFlight = true;
+            LOG_DEBUG("Circuit for " + host + " half-open, sending a probe");
+            return true;
+        case State::HALF_OPEN:
+            if (probeInFlight) {
+                rejectedCount++;
+                return false;
+            }
+            probeInFlight = true;
+            return true;
+    }
+    return true;
+}
+
+bool CircuitBreaker::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (state == State::OPEN && clock.nowMs() < openUntilMs) || (state == State::HALF_OPEN && probeInFlight);
+}
+
+void CircuitBreaker::onSuccess() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state != State::CLOSED) {
+        LOG_INFO("Circuit for " + host + " closed, service is back");
+    }
+    state = State::CLOSED;
+    consecutiveFailures = 0;
+    nextOpenMs = BASE_OPEN_MS;
+    probeInFlight = false;
+}
+
+void CircuitBreaker::onFailure(int64_t retryAfterMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    probeInFlight = false;
+    if (retryAfterMs >= 0) {
+        open(std::min(retryAfterMs, MAX_OPEN_MS));
+        return;
+    }
+    if (state == State::HALF_OPEN) {
+        nextOpenMs = std::min(nextOpenMs * 2, MAX_OPEN_MS);
+        open(nextOpenMs);
+        return;
+    }
+    if (++consecutiveFailures >= FAILURE_THRESHOLD) {
+        open(nextOpenMs);
+    }
+}
+
+void CircuitBreaker::onAbandoned() {
+    std::lock_guard<std::mutex> lock(mutex);
+    probeInFlight = false;
+}
+
+void CircuitBreaker::open(int64_t durationMs) {
+    state = State::OPEN;
+    openUntilMs = clock.nowMs() + durationMs;
+    consecutiveFailures = 0;
+    LOG_WARNING("Circuit for " + host + " open for " + std::to_string(durationMs / 1000) + " s");
+}
+
+CircuitBreaker::State CircuitBreaker::getState() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state;
+}
+
+int64_t CircuitBreaker::msUntilRetry() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state != State::OPEN) {
+        return 0;
+    }
+    return std::max<int64_t>(openUntilMs - clock.nowMs(), 0);
+}
+
+uint64_t CircuitBreaker::getRejectedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rejectedCount;
+}
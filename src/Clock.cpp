@@ -0,0 +1,36 @@
+#include "include/Clock.h"
+#include <chrono>
+#include <thread>
+
+namespace {
+    class SystemClock : public Clock {
+    public:
+        [[nodiscard]] int64_t nowMs() const override {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        [[nodiscard]] int64_t wallTimeSeconds() const override {
+            return std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        void sleepMs(int64_t ms) const override {
+            if (ms > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            }
+        }
+
+        void waitFor(std::condition_variable &condition, std::unique_lock<std::mutex> &lock,
+                     int64_t ms) const override {
+            condition.wait_for(lock, std::chrono::milliseconds(ms));
+        }
+    };
+}
+
+std::atomic<Clock *> Clock::current{nullptr};
+
+Clock &Clock::system() {
+    static SystemClock clock;
+    return clock;
+}
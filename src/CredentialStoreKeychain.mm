@@ -0,0 +1,114 @@
+#if defined(__APPLE__)
+
+#include "include/CredentialStore.h"
+#include "include/Logger.h"
+#include <cstdio>
+#include <cstdlib>
+#import <Security/Security.h>
+#import <Security/SecKeychain.h>
+#import <Security/SecKeychainItem.h>
+
+namespace {
+    /**
+     * @brief Generic passwords in the login Keychain, with the security CLI as a fallback.
+     */
+    class KeychainStore : public CredentialStore {
+    public:
+        explicit KeychainStore(std::string service) : service(std::move(service)) {}
+
+        std::string load(const std::string &account) override {
+            void *data = nullptr;
+            UInt32 length = 0;
+
+            OSStatus status = SecKeychainFindGenericPassword(nullptr,
+                                                             (UInt32) service.length(), service.c_str(),
+                                                             (UInt32) account.length(), account.c_str(),
+                                                             &length, &data, nullptr);
+
+            if (status == errSecSuccess) {
+                std::string result((char *) data, length);
+                SecKeychainItemFreeContent(nullptr, data);
+                LOG_DEBUG(account + " retrieved from Keychain");
+                return result;
+            } else if (status == errSecItemNotFound) {
+                LOG_ERROR(account + " not found in Keychain");
+                std::string command = "security find-generic-password -s \"" + service + "\" -a \"" + account + "\" -w";
+                FILE *pipe = popen(command.c_str(), "r");
+                if (!pipe) {
+                    LOG_ERROR("Failed to execute security command");
+                    return "";
+                }
+                char buffer[128];
+                std::string result;
+                while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+                    result += buffer;
+                }
+                pclose(pipe);
+
+                // Trim newline
+                result.erase(result.find_last_not_of('\n') + 1);
+
+                if (result.empty()) {
+                    LOG_ERROR("Failed to retrieve " + account + " from Keychain");
+                } else {
+                    LOG_DEBUG(account + " retrieved from Keychain");
+                }
+                return result;
+            }
+
+            LOG_ERROR("Keychain error: " + std::to_string(status));
+
+            return "";
+        }
+
+        bool save(const std::string &account, const std::string &value) override {
+            OSStatus status = SecKeychainAddGenericPassword(nullptr,
+                                                            (UInt32) service.length(), service.c_str(),
+                                                            (UInt32) account.length(), account.c_str(),
+                                                            (UInt32) value.length(), value.c_str(),
+                                                            nullptr);
+
+            if (status == errSecSuccess) {
+                LOG_INFO(account + " saved to Keychain");
+                return true;
+            } else if (status == errSecDuplicateItem) {
+                // Overwrite, so a new session key or a cleared rejected one actually replaces the old value
+                SecKeychainItemRef item = nullptr;
+                status = SecKeychainFindGenericPassword(nullptr,
+                                                        (UInt32) service.length(), service.c_str(),
+                                                        (UInt32) account.length(), account.c_str(),
+                                                        nullptr, nullptr, &item);
+                if (status == errSecSuccess) {
+                    status = SecKeychainItemModifyAttributesAndData(item, nullptr,
+                                                                    (UInt32) value.length(), value.c_str());
+                    CFRelease(item);
+                }
+                if (status == errSecSuccess) {
+                    LOG_INFO(account + " updated in Keychain");
+                    return true;
+                }
+            }
+
+            LOG_ERROR("Keychain error: " + std::to_string(status));
+            std::string command =
+                    "security add-generic-password -U -s \"" + service + "\" -a \"" + account + "\" -w \"" + value + "\"";
+            int result = system(command.c_str());
+
+            if (result == 0) {
+                LOG_INFO(account + " saved to Keychain using CLI fallback");
+                return true;
+            }
+            LOG_INFO("Failed to save " + account + " to Keychain using CLI fallback");
+            return false;
+        }
+
+    private:
+        std::string service;
+    };
+}
+
+std::unique_ptr<CredentialStore> createPlatformCredentialStore(const std::string &service) {
+    return std::make_unique<KeychainStore>(service);
+}
+
+#endif
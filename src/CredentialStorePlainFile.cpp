@@ -0,0 +1,91 @@
+#if !defined(__APPLE__)
+
+#include "include/CredentialStore.h"
+#include "include/Logger.h"
+#include "../lib/json.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+    /**
+     * @brief One JSON object per service in $XDG_CONFIG_HOME/betterscrobbler, readable by the owner only.
+     * Not encrypted: the file mode is the only protection, so anything running as the user can read it.
+     */
+    class PlainFileStore : public CredentialStore {
+    public:
+        explicit PlainFileStore(const std::string &service) {
+            const char *configHome = std::getenv("XDG_CONFIG_HOME");
+            const char *home = std::getenv("HOME");
+            directory = configHome && *configHome ? std::string(configHome)
+                                                  : std::string(home ? home : "/tmp") + "/.config";
+            directory += "/betterscrobbler";
+            path = directory + "/" + service + ".json";
+        }
+
+        std::string load(const std::string &account) override {
+            json document = read();
+            auto found = document.find(account);
+            if (found == document.end() || !found->is_string()) {
+                LOG_DEBUG(account + " not found in " + path);
+                return "";
+            }
+            return found->get<std::string>();
+        }
+
+        bool save(const std::string &account, const std::string &value) override {
+            json document = read();
+            document[account] = value;
+
+            // mkdir -p, the config directory itself may not exist yet
+            for (size_t slash = directory.find('/', 1); ; slash = directory.find('/', slash + 1)) {
+                mkdir(directory.substr(0, slash).c_str(), 0700);
+                if (slash == std::string::npos) break;
+            }
+            std::string temporary = path + ".tmp";
+            int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+            if (fd < 0) {
+                LOG_ERROR("Failed to write credentials: " + temporary);
+                return false;
+            }
+            std::string contents = document.dump();
+            bool written = write(fd, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size());
+            close(fd);
+            if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+                LOG_ERROR("Failed to save credentials: " + path);
+                return false;
+            }
+            LOG_INFO(account + " saved to " + path);
+            return true;
+        }
+
+    private:
+        json read() const {
+            std::ifstream in(path);
+            if (!in.is_open()) {
+                return json::object();
+            }
+            try {
+                json document = json::parse(in);
+                return document.is_object() ? document : json::object();
+            } catch (const std::exception &e) {
+                LOG_ERROR("Failed to read credentials: " + std::string(e.what()));
+                return json::object();
+            }
+        }
+
+        std::string directory;
+        std::string path;
+    };
+}
+
+std::unique_ptr<CredentialStore> createPlatformCredentialStore(const std::string &service) {
+    return std::make_unique<PlainFileStore>(service);
+}
+
+#endif
@@ -0,0 +1,254 @@
+#include "include/Credentials.h"
+#include "include/UrlUtils.h"
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+    /**
+     * @brief memset the compiler may not drop as a dead store.
+     */
+    void wipe(void *data, size_t size) {
+        volatile unsigned char *bytes = static_cast<volatile unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) {
+            bytes[i] = 0;
+        }
+    }
+}
+
+bool Credentials::authenticate() {
+
+    std::string token = getAuthToken();
+    if (token.empty()) {
+        LOG_ERROR("Failed to get Last.fm token");
+        return false;
+    }
+
+    openAuthPage(token);
+    std::string sessionKey = getSessionKey(token);
+
+    if (sessionKey.empty()) {
+        LOG_ERROR("Authentication failed");
+        return false;
+    }
+
+    saveSessionKey(sessionKey);
+    LOG_INFO("Authentication successful");
+    return true;
+}
+
+std::string Credentials::getAuthToken() {
+
+    std::map<std::string, std::string> params = {
+            {"method", "auth.getToken"}
+    };
+
+    std::string url = UrlUtils::buildApiUrl("auth.getToken", params);
+    ApiResponse response = UrlUtils::sendGetRequest(url, nullptr, 3, {}, RateLimiter::Priority::SCROBBLE);
+    return response.field("token");
+}
+
+void Credentials::openAuthPage(const std::string &token) {
+    std::string url = "https://www.last.fm/api/auth/?api_key=" + getApiKey() +
+                      "&token=" + token;
+
+#if defined(__APPLE__)
+    std::string command = "open '" + url + "'";
+#else
+    std::string command = "xdg-open '" + url + "' >/dev/null 2>&1";
+#endif
+    // The key and token are plain alphanumerics, so the quoted URL is safe to hand to the shell
+    if (std::system(command.c_str()) != 0) {
+        LOG_WARNING("Could not open a browser, visit: " + url);
+    }
+
+    LOG_INFO("Please authorize the application in your browser");
+    std::cout << "Press Enter once you've authorized...\n";
+    std::cin.ignore();
+}
+
+std::string Credentials::getSessionKey(const std::string &token) {
+    std::map<std::string, std::string> params = {
+            {"method", "auth.getSession"},
+            {"token",  token}
+    };
+
+    std::string url = UrlUtils::buildApiUrl("auth.getSession", params);
+    ApiResponse response = UrlUtils::sendGetRequest(url, nullptr, 3, {}, RateLimiter::Priority::SCROBBLE);
+
+    std::string sk = response.field("session.key");
+    if (!sk.empty()) {
+        saveSessionKey(sk);
+        return sk;
+    }
+    if (!response.isJson()) {
+        lastError = "Failed to parse session key";
+        LOG_ERROR(lastError);
+    }
+    return "";
+}
+
+void Credentials::saveSessionKey(const std::string &sk) {
+    saveToStore(Config::getInstance().getKeychainSessionKeyAccount(), sk);
+    publish(&Secrets::sessionKey, sk);
+    sessionRejected.store(false, std::memory_order_release);
+    LOG_INFO("Session key saved");
+}
+
+std::string Credentials::loadSessionKey() {
+    // The store still answers with the rejected key until it is overwritten, so do not ask it
+    if (isSessionRejected()) {
+        return "";
+    }
+    std::string sessionKey = cached(&Secrets::sessionKey, Config::getInstance().getKeychainSessionKeyAccount());
+    if (sessionKey.empty()) {
+        LOG_ERROR("Failed to load session key from the credential store");
+    }
+    return sessionKey;
+}
+
+bool Credentials::hasSessionKey() {
+    return !snapshot()->sessionKey.empty() || !loadSessionKey().empty();
+}
+
+void Credentials::invalidateSessionKey() {
+    if (sessionRejected.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    LOG_ERROR("Last.fm rejected the session key; scrobbles are queued until you restart and authenticate again");
+    publish(&Secrets::sessionKey, "");
+    saveToStore(Config::getInstance().getKeychainSessionKeyAccount(), "");
+}
+
+std::string Credentials::getApiKey() {
+    const std::string &account = Config::getInstance().getKeychainApiKeyAccount();
+    std::string apiKey = cached(&Secrets::apiKey, account);
+    if (apiKey.empty()) {
+        std::cout << "🔑 Enter your Last.fm API Key: ";
+        std::getline(std::cin, apiKey);
+        saveToStore(account, apiKey);
+        publish(&Secrets::apiKey, apiKey);
+    }
+    return apiKey;
+}
+
+std::string Credentials::getApiSecret() {
+    const std::string &account = Config::getInstance().getKeychainSecretAccount();
+    std::string apiSecret = cached(&Secrets::apiSecret, account);
+    if (apiSecret.empty()) {
+        std::cout << "🔑 Enter your Last.fm API Secret: ";
+        std::getline(std::cin, apiSecret);
+        saveToStore(account, apiSecret);
+        publish(&Secrets::apiSecret, apiSecret);
+    }
+    return apiSecret;
+}
+
+void Credentials::setStore(std::unique_ptr<CredentialStore> newStore) {
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        store = std::move(newStore);
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache = lockedCopy({});
+}
+
+std::shared_ptr<const Credentials::Secrets> Credentials::apiSecrets() {
+    std::shared_ptr<const Secrets> secrets = snapshot();
+    if (secrets->apiKey.empty() || secrets->apiSecret.empty()) {
+        getApiKey();
+        getApiSecret();
+        secrets = snapshot();
+    }
+    return secrets;
+}
+
+std::shared_ptr<const Credentials::Secrets> Credentials::snapshot() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return cache;
+}
+
+std::string Credentials::cached(std::string_view Secrets::*field, const std::string &account) {
+    std::shared_ptr<const Secrets> secrets = snapshot();
+    if (!((*secrets).*field).empty()) {
+        return std::string((*secrets).*field);
+    }
+
+    std::string value = loadFromStore(account);
+    if (!value.empty()) {
+        publish(field, value);
+    }
+    return value;
+}
+
+void Credentials::publish(std::string_view Secrets::*field, std::string_view value) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    // Views into the current page, which cache keeps alive until it is replaced below
+    Secrets updated = *cache;
+    updated.*field = value;
+    cache = lockedCopy(updated);
+}
+
+std::shared_ptr<const Credentials::Secrets> Credentials::lockedCopy(const Secrets &values) {
+    size_t size = sizeof(Secrets) + values.apiKey.size() + values.apiSecret.size() + values.sessionKey.size();
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t mapped = (size + page - 1) / page * page;
+    void *block = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (block == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    if (mlock(block, mapped) != 0) {
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) {
+            LOG_WARNING("Could not lock credentials in memory, they may be swapped to disk");
+        }
+    }
+#ifdef MADV_DONTDUMP
+    madvise(block, mapped, MADV_DONTDUMP);
+#endif
+
+    char *text = static_cast<char *>(block) + sizeof(Secrets);
+    auto place = [&text](std::string_view value) {
+        if (!value.empty()) {
+            std::memcpy(text, value.data(), value.size());
+        }
+        std::string_view stored(text, value.size());
+        text += value.size();
+        return stored;
+    };
+    Secrets *secrets = new(block) Secrets{place(values.apiKey), place(values.apiSecret), place(values.sessionKey)};
+
+    return std::shared_ptr<const Secrets>(secrets, [mapped](const Secrets *released) {
+        void *base = const_cast<Secrets *>(released);
+        released->~Secrets();
+        wipe(base, mapped);
+        munlock(base, mapped);
+        munmap(base, mapped);
+    });
+}
+
+std::string Credentials::loadFromStore(const std::string &account) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    if (!store) {
+        store = createPlatformCredentialStore(Config::getInstance().getKeychainService());
+    }
+    return store->load(account);
+}
+
+void Credentials::saveToStore(const std::string &account, const std::string &value) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    if (!store) {
+        store = createPlatformCredentialStore(Config::getInstance().getKeychainService());
+    }
+    store->save(account, value);
+}
+
+std::mutex Credentials::cacheMutex;
+std::shared_ptr<const Credentials::Secrets> Credentials::cache = Credentials::lockedCopy({});
+std::mutex Credentials::storeMutex;
+std::unique_ptr<CredentialStore> Credentials::store;
+std::atomic<bool> Credentials::sessionRejected{false};
@@ -0,0 +1,156 @@
+#include "include/CursesTarget.h"
+#include "include/Unicode.h"
+#include <locale.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+    attr_t toAttrs(Surface::Style style) {
+        attr_t attrs = COLOR_PAIR(style.colorPair);
+        if (style.bold) {
+            attrs |= A_BOLD;
+        }
+        return attrs;
+    }
+
+    chtype toChar(Surface::Glyph glyph) {
+        switch (glyph) {
+            case Surface::Glyph::UpArrow:
+                return ACS_UARROW;
+            case Surface::Glyph::DownArrow:
+                return ACS_DARROW;
+            case Surface::Glyph::VerticalLine:
+                return ACS_VLINE;
+            case Surface::Glyph::HorizontalLine:
+            default:
+                return ACS_HLINE;
+        }
+    }
+
+    class CursesSurface : public Surface {
+    public:
+        CursesSurface(CursesTarget &target, WINDOW *win, bool isPad)
+                : target(target), win(win), isPad(isPad) {}
+
+        ~CursesSurface() override {
+            if (win) {
+                delwin(win);
+            }
+        }
+
+        [[nodiscard]] int getRows() const override { return getmaxy(win); }
+        [[nodiscard]] int getCols() const override { return getmaxx(win); }
+        [[nodiscard]] int getOriginY() const override { return getbegy(win); }
+        [[nodiscard]] int getOriginX() const override { return getbegx(win); }
+
+        void resize(int rows, int cols) override { wresize(win, rows, cols); }
+        void moveTo(int y, int x) override { mvwin(win, y, x); }
+
+        void erase() override { werase(win); }
+
+        void clearToEol(int y, int x) override {
+            wmove(win, y, x);
+            wclrtoeol(win);
+        }
+
+        void drawBox(Style style) override {
+            wattron(win, toAttrs(style));
+            box(win, 0, 0);
+            wattroff(win, toAttrs(style));
+        }
+
+        int drawText(int y, int x, std::string_view text, Style style) override {
+            int room = getmaxx(win) - x;
+            if (room <= 0) return x;
+            // mvwaddnstr wraps onto the next row at the right edge, so cut whole clusters that fit before it
+            int columns = 0;
+            size_t length = Unicode::fitColumns(text, room, &columns);
+            wattron(win, toAttrs(style));
+            mvwaddnstr(win, y, x, text.data(), static_cast<int>(length));
+            wattroff(win, toAttrs(style));
+            // The cursor sits on the next row after a write that fills the last column
+            return x + columns;
+        }
+
+        void drawGlyph(int y, int x, Glyph glyph, Style style, int count) override {
+            wattron(win, toAttrs(style));
+            if (count == 1) {
+                mvwaddch(win, y, x, toChar(glyph));
+            } else {
+                mvwhline(win, y, x, toChar(glyph), count);
+            }
+            wattroff(win, toAttrs(style));
+        }
+
+        void touch() override { touchwin(win); }
+
+        void stage() override {
+            wnoutrefresh(win);
+            target.markStaged();
+        }
+
+        void stageRegion(int row, int col, int screenTop, int screenLeft, int screenBottom, int screenRight) override {
+            if (!isPad) return;
+            pnoutrefresh(win, row, col, screenTop, screenLeft, screenBottom, screenRight);
+            target.markStaged();
+        }
+
+    private:
+        CursesTarget &target;
+        WINDOW *win;
+        bool isPad;
+    };
+}
+
+CursesTarget::CursesTarget() {
+    setlocale(LC_ALL, "");
+
+    initscr();
+    cbreak();
+    noecho();
+    curs_set(0);
+    start_color();
+
+    init_pair(1, COLOR_RED, COLOR_BLACK);     // Title
+    init_pair(2, COLOR_YELLOW, COLOR_BLACK);  // Song info
+    init_pair(3, COLOR_WHITE, COLOR_BLACK);   // Lyrics
+    init_pair(4, COLOR_CYAN, COLOR_BLACK);    // Current line
+    init_pair(5, COLOR_GREEN, COLOR_BLACK);   // Progress bar
+    init_pair(6, COLOR_MAGENTA, COLOR_BLACK); // Hint
+}
+
+CursesTarget::~CursesTarget() {
+    endwin();
+}
+
+std::unique_ptr<Surface> CursesTarget::createWindow(int rows, int cols, int y, int x) {
+    WINDOW *win = newwin(rows, cols, y, x);
+    if (!win) return nullptr;
+    return std::make_unique<CursesSurface>(*this, win, false);
+}
+
+std::unique_ptr<Surface> CursesTarget::createPad(int rows, int cols) {
+    WINDOW *pad = newpad(rows, cols);
+    if (!pad) return nullptr;
+    return std::make_unique<CursesSurface>(*this, pad, true);
+}
+
+void CursesTarget::syncSize() {
+    struct winsize size{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        resizeterm(size.ws_row, size.ws_col);
+    }
+}
+
+void CursesTarget::clear() {
+    werase(stdscr);
+    wnoutrefresh(stdscr);
+    staged = true;
+}
+
+void CursesTarget::flush() {
+    if (staged) {
+        doupdate();
+        staged = false;
+    }
+}
@@ -0,0 +1,177 @@
+#include "include/EventLoop.h"
+#include "include/Logger.h"
+#include <algorithm>
+
+EventLoop::EventLoop(Clock &clock, bool platformBackend)
+        : clock(clock), wheel(clock.nowMs()) {
+    if (platformBackend) {
+        backend = createPlatformBackend(*this);
+    }
+}
+
+EventLoop::~EventLoop() {
+    for (auto &entry : timers) {
+        wheel.remove(*entry.second);
+    }
+}
+
+EventLoop::TimerId EventLoop::createTimer(Task task) {
+    auto timer = std::make_unique<Timer>();
+    timer->id = nextTimerId++;
+    timer->task = std::move(task);
+    TimerId id = timer->id;
+    timers.emplace(id, std::move(timer));
+    return id;
+}
+
+void EventLoop::insertTimer(Timer &timer, int64_t delayMs) {
+    int64_t deadline = clock.nowMs() + std::max<int64_t>(delayMs, 0);
+    if (timer.leewayMs > 1) {
+        deadline = (deadline + timer.leewayMs - 1) / timer.leewayMs * timer.leewayMs;
+    }
+    wheel.insert(timer, deadline);
+}
+
+void EventLoop::schedule(TimerId id, int64_t delayMs, int64_t intervalMs, int64_t leewayMs) {
+    auto it = timers.find(id);
+    if (it == timers.end()) {
+        return;
+    }
+    Timer &timer = *it->second;
+    timer.intervalMs = std::max<int64_t>(intervalMs, 0);
+    timer.leewayMs = std::max<int64_t>(leewayMs, 0);
+    insertTimer(timer, delayMs);
+    rearm();
+}
+
+void EventLoop::cancel(TimerId id) {
+    auto it = timers.find(id);
+    if (it == timers.end()) {
+        return;
+    }
+    wheel.remove(*it->second);
+    rearm();
+}
+
+void EventLoop::destroyTimer(TimerId id) {
+    auto it = timers.find(id);
+    if (it == timers.end()) {
+        return;
+    }
+    wheel.remove(*it->second);
+    timers.erase(it);
+    rearm();
+}
+
+EventLoop::TimerId EventLoop::runAfter(int64_t delayMs, Task task) {
+    TimerId id = createTimer(std::move(task));
+    timers[id]->autoDestroy = true;
+    schedule(id, delayMs);
+    return id;
+}
+
+void EventLoop::post(Task task) {
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(postMutex);
+        wasEmpty = posted.empty();
+        posted.push_back(std::move(task));
+    }
+    if (wasEmpty && backend) {
+        backend->wake();
+    }
+}
+
+bool EventLoop::watchReadable(int fd, Task task) {
+    return backend && backend->watchReadable(fd, std::move(task));
+}
+
+void EventLoop::unwatch(int fd) {
+    if (backend) {
+        backend->unwatch(fd);
+    }
+}
+
+bool EventLoop::watchSignal(int signal, Task task) {
+    return backend && backend->watchSignal(signal, std::move(task));
+}
+
+void EventLoop::run() {
+    if (!backend) {
+        LOG_ERROR("EventLoop::run called without a backend");
+        return;
+    }
+    rearm();
+    backend->run();
+}
+
+void EventLoop::stop() {
+    if (backend) {
+        backend->stop();
+    }
+}
+
+void EventLoop::runDue() {
+    wakeups++;
+    dispatching = true;
+    armedDeadline = -1;
+
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(postMutex);
+        tasks.swap(posted);
+    }
+    for (auto &task : tasks) {
+        task();
+    }
+
+    int64_t now = clock.nowMs();
+    expired.clear();
+    wheel.advance(now, expired);
+
+    // Work from ids: a callback may destroy or reschedule other timers from the same batch
+    std::vector<TimerId> due;
+    due.reserve(expired.size());
+    for (auto *node : expired) {
+        due.push_back(static_cast<Timer *>(node)->id);
+    }
+
+    for (TimerId id : due) {
+        auto it = timers.find(id);
+        if (it == timers.end() || it->second->isLinked()) {
+            continue;
+        }
+        Timer &timer = *it->second;
+        timersFired++;
+
+        if (timer.autoDestroy) {
+            Task task = std::move(timer.task);
+            timers.erase(it);
+            task();
+            continue;
+        }
+
+        if (timer.intervalMs > 0) {
+            // Keep the phase, but skip periods missed while the process was stalled
+            int64_t next = timer.deadline + timer.intervalMs;
+            wheel.insert(timer, next > now ? next : now + timer.intervalMs);
+        }
+        Task task = timer.task;
+        task();
+    }
+
+    dispatching = false;
+    rearm();
+}
+
+void EventLoop::rearm() {
+    if (dispatching || !backend) {
+        return;
+    }
+    int64_t deadline = wheel.nextDeadline();
+    if (deadline == armedDeadline) {
+        return;
+    }
+    armedDeadline = deadline;
+    backend->arm(deadline < 0 ? -1 : std::max<int64_t>(deadline - clock.nowMs(), 0));
+}
@@ -0,0 +1,127 @@
+#if defined(__APPLE__)
+
+#include "include/EventLoop.h"
+#include "include/Logger.h"
+#include <CoreFoundation/CoreFoundation.h>
+#include <dispatch/dispatch.h>
+#include <unordered_map>
+
+namespace {
+    /**
+     * @brief Adapter onto the main dispatch queue, which MediaRemote callbacks already use.
+     * One timer source tracks the wheel's earliest deadline; run() spins the main CFRunLoop.
+     */
+    class DispatchBackend : public EventLoop::Backend {
+    public:
+        explicit DispatchBackend(EventLoop &loop) : loop(loop) {
+            timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+            if (!timer) {
+                LOG_ERROR("Failed to create event loop timer");
+                return;
+            }
+            dispatch_source_set_timer(timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+            EventLoop *target = &loop;
+            dispatch_source_set_event_handler(timer, ^{
+                target->runDue();
+            });
+            dispatch_resume(timer);
+        }
+
+        ~DispatchBackend() override {
+            for (auto &entry : readers) {
+                release(entry.second);
+            }
+            for (auto &entry : signals) {
+                release(entry.second);
+            }
+            release(timer);
+        }
+
+        void arm(int64_t delayMs) override {
+            if (!timer) return;
+            dispatch_time_t start = delayMs < 0 ? DISPATCH_TIME_FOREVER
+                                                : dispatch_time(DISPATCH_TIME_NOW, delayMs * NSEC_PER_MSEC);
+            // The wheel already coalesces; a small leeway lets the kernel batch with other processes
+            dispatch_source_set_timer(timer, start, DISPATCH_TIME_FOREVER, NSEC_PER_MSEC);
+        }
+
+        void wake() override {
+            EventLoop *target = &loop;
+            dispatch_async(dispatch_get_main_queue(), ^{
+                target->runDue();
+            });
+        }
+
+        bool watchReadable(int fd, EventLoop::Task task) override {
+            unwatch(fd);
+            dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, fd, 0,
+                                                              dispatch_get_main_queue());
+            if (!source) {
+                return false;
+            }
+            auto handler = std::make_shared<EventLoop::Task>(std::move(task));
+            dispatch_source_set_event_handler(source, ^{
+                EventLoop::Task copy = *handler;
+                copy();
+            });
+            dispatch_resume(source);
+            readers[fd] = source;
+            return true;
+        }
+
+        void unwatch(int fd) override {
+            auto it = readers.find(fd);
+            if (it != readers.end()) {
+                release(it->second);
+                readers.erase(it);
+            }
+        }
+
+        bool watchSignal(int signal, EventLoop::Task task) override {
+            dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, signal, 0,
+                                                              dispatch_get_main_queue());
+            if (!source) {
+                return false;
+            }
+            auto handler = std::make_shared<EventLoop::Task>(std::move(task));
+            dispatch_source_set_event_handler(source, ^{
+                EventLoop::Task copy = *handler;
+                copy();
+            });
+            dispatch_resume(source);
+            auto it = signals.find(signal);
+            if (it != signals.end()) {
+                release(it->second);
+            }
+            signals[signal] = source;
+            return true;
+        }
+
+        void run() override {
+            CFRunLoopRun();
+        }
+
+        void stop() override {
+            CFRunLoopStop(CFRunLoopGetMain());
+        }
+
+    private:
+        static void release(dispatch_source_t source) {
+            if (source) {
+                dispatch_source_cancel(source);
+                dispatch_release(source);
+            }
+        }
+
+        EventLoop &loop;
+        dispatch_source_t timer = nullptr;
+        std::unordered_map<int, dispatch_source_t> readers;
+        std::unordered_map<int, dispatch_source_t> signals;
+    };
+}
+
+std::unique_ptr<EventLoop::Backend> createPlatformBackend(EventLoop &loop) {
+    return std::make_unique<DispatchBackend>(loop);
+}
+
+#endif
@@ -0,0 +1,163 @@
+#if defined(__linux__)
+
+#include "include/EventLoop.h"
+#include "include/Logger.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+    /**
+     * @brief epoll set holding a timerfd for the wheel's next deadline, an eventfd for post(),
+     * one signalfd for every watched signal and the watched fds themselves.
+     */
+    class EpollBackend : public EventLoop::Backend {
+    public:
+        explicit EpollBackend(EventLoop &loop) : loop(loop) {
+            sigemptyset(&signalMask);
+            epollFd = epoll_create1(EPOLL_CLOEXEC);
+            timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epollFd < 0 || timerFd < 0 || wakeFd < 0) {
+                LOG_ERROR("Failed to create event loop descriptors: " + std::string(strerror(errno)));
+                return;
+            }
+            add(timerFd);
+            add(wakeFd);
+        }
+
+        ~EpollBackend() override {
+            for (int fd : {signalFd, wakeFd, timerFd, epollFd}) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+        }
+
+        void arm(int64_t delayMs) override {
+            itimerspec spec = {};
+            if (delayMs >= 0) {
+                // An all-zero it_value disarms, so a due-now deadline becomes 1 ns
+                spec.it_value.tv_sec = delayMs / 1000;
+                spec.it_value.tv_nsec = delayMs % 1000 * 1000000 + (delayMs == 0 ? 1 : 0);
+            }
+            timerfd_settime(timerFd, 0, &spec, nullptr);
+        }
+
+        void wake() override {
+            uint64_t one = 1;
+            ssize_t written = write(wakeFd, &one, sizeof(one));
+            (void) written;
+        }
+
+        bool watchReadable(int fd, EventLoop::Task task) override {
+            if (!add(fd)) {
+                return false;
+            }
+            readers[fd] = std::move(task);
+            return true;
+        }
+
+        void unwatch(int fd) override {
+            if (readers.erase(fd) > 0) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            }
+        }
+
+        bool watchSignal(int signal, EventLoop::Task task) override {
+            sigaddset(&signalMask, signal);
+            if (sigprocmask(SIG_BLOCK, &signalMask, nullptr) != 0) {
+                return false;
+            }
+            bool created = signalFd < 0;
+            signalFd = signalfd(signalFd, &signalMask, SFD_NONBLOCK | SFD_CLOEXEC);
+            if (signalFd < 0 || (created && !add(signalFd))) {
+                return false;
+            }
+            signalHandlers[signal] = std::move(task);
+            return true;
+        }
+
+        void run() override {
+            running = true;
+            epoll_event events[16];
+            while (running) {
+                int ready = epoll_wait(epollFd, events, 16, -1);
+                if (ready < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    LOG_ERROR("epoll_wait failed: " + std::string(strerror(errno)));
+                    return;
+                }
+
+                bool due = false;
+                for (int i = 0; i < ready; ++i) {
+                    int fd = events[i].data.fd;
+                    if (fd == timerFd || fd == wakeFd) {
+                        uint64_t value;
+                        ssize_t consumed = read(fd, &value, sizeof(value));
+                        (void) consumed;
+                        due = true;
+                    } else if (fd == signalFd) {
+                        dispatchSignals();
+                    } else {
+                        auto it = readers.find(fd);
+                        if (it != readers.end()) {
+                            EventLoop::Task task = it->second;
+                            task();
+                        }
+                    }
+                }
+                if (due) {
+                    loop.runDue();
+                }
+            }
+        }
+
+        void stop() override {
+            running = false;
+            wake();
+        }
+
+    private:
+        bool add(int fd) {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+        }
+
+        void dispatchSignals() {
+            signalfd_siginfo info;
+            while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+                auto it = signalHandlers.find(static_cast<int>(info.ssi_signo));
+                if (it != signalHandlers.end()) {
+                    EventLoop::Task task = it->second;
+                    task();
+                }
+            }
+        }
+
+        EventLoop &loop;
+        int epollFd = -1;
+        int timerFd = -1;
+        int wakeFd = -1;
+        int signalFd = -1;
+        sigset_t signalMask;
+        std::unordered_map<int, EventLoop::Task> readers;
+        std::unordered_map<int, EventLoop::Task> signalHandlers;
+        bool running = false;
+    };
+}
+
+std::unique_ptr<EventLoop::Backend> createPlatformBackend(EventLoop &loop) {
+    return std::make_unique<EpollBackend>(loop);
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include "include/HeaderView.h"
+#include "include/Unicode.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    constexpr int SONG_ROW = 1;
+    constexpr int TIME_ROW = 2;
+    constexpr int PROGRESS_ROW = 3;
+    constexpr int PROGRESS_COL = 4;
+
+    constexpr Surface::Style BORDER_STYLE{1, false};
+    constexpr Surface::Style TITLE_STYLE{1, true};
+    constexpr Surface::Style SONG_STYLE{2, true};
+    constexpr Surface::Style PROGRESS_STYLE{5, false};
+
+    void appendTime(std::string &out, double seconds) {
+        int total = std::max(0, static_cast<int>(seconds));
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%d:%02d", total / 60, total % 60);
+        out += buffer;
+    }
+}
+
+void HeaderView::layoutSongInfo(const std::string &artist, const std::string &title, int width) {
+    songArtist = artist;
+    songTitle = title;
+    songWidth = width;
+
+    songInfo.clear();
+    songInfo.reserve(artist.size() + title.size() + 3);
+    songInfo += artist;
+    songInfo += " - ";
+    songInfo += title;
+
+    int maxColumns = std::max(width - 4, 3);
+    songColumns = Unicode::displayWidth(songInfo);
+    if (songColumns > maxColumns) {
+        songInfo.resize(Unicode::fitColumns(songInfo, maxColumns - 3, &songColumns));
+        songInfo += "...";
+        songColumns += 3;
+    }
+}
+
+HeaderView::State HeaderView::compute(const char *label, const std::string &artist, const std::string &title,
+                                      double elapsed, double duration, int width) {
+    if (width != songWidth || artist != songArtist || title != songTitle) {
+        layoutSongInfo(artist, title, width);
+    }
+
+    State state;
+    state.width = width;
+    state.label = label;
+    state.songInfo = songInfo;
+    state.songColumns = songColumns;
+
+    appendTime(state.timeInfo, elapsed);
+    state.timeInfo += " / ";
+    appendTime(state.timeInfo, duration);
+
+    state.progressWidth = std::max(width - 8, 0);
+    double progress = (duration > 0) ? elapsed / duration : 0;
+    state.progressPos = static_cast<int>(progress * state.progressWidth);
+    return state;
+}
+
+bool HeaderView::draw(Surface &surface, const State &next) {
+    if (!valid || next.width != painted.width || std::strcmp(next.label, painted.label) != 0) {
+        drawFrame(surface, next);
+    } else {
+        bool changed = false;
+        if (next.songInfo != painted.songInfo) {
+            drawCenteredRow(surface, SONG_ROW, next.songInfo, next.songColumns, SONG_STYLE);
+            changed = true;
+        }
+        if (next.timeInfo != painted.timeInfo) {
+            drawCenteredRow(surface, TIME_ROW, next.timeInfo, static_cast<int>(next.timeInfo.length()), PROGRESS_STYLE);
+            changed = true;
+        }
+        if (next.progressPos != painted.progressPos) {
+            // Only cells between the old and new head change glyph
+            drawProgressCells(surface, next,
+                              std::min(painted.progressPos, next.progressPos),
+                              std::max(painted.progressPos, next.progressPos));
+            changed = true;
+        }
+        if (!changed) {
+            return false;
+        }
+    }
+
+    painted = next;
+    valid = true;
+    surface.stage();
+    return true;
+}
+
+void HeaderView::drawFrame(Surface &surface, const State &next) {
+    surface.erase();
+
+    int width = surface.getCols();
+    surface.drawBox(BORDER_STYLE);
+
+    std::string_view headerText = next.label;
+    surface.drawText(0, (width - static_cast<int>(headerText.length())) / 2, headerText, TITLE_STYLE);
+
+    drawCenteredRow(surface, SONG_ROW, next.songInfo, next.songColumns, SONG_STYLE);
+    drawCenteredRow(surface, TIME_ROW, next.timeInfo, static_cast<int>(next.timeInfo.length()), PROGRESS_STYLE);
+
+    surface.drawText(PROGRESS_ROW, PROGRESS_COL, "[", PROGRESS_STYLE);
+    surface.drawText(PROGRESS_ROW, PROGRESS_COL + next.progressWidth + 1, "]", PROGRESS_STYLE);
+    drawProgressCells(surface, next, 0, next.progressWidth - 1);
+
+    cellsPainted += width;
+}
+
+void HeaderView::drawCenteredRow(Surface &surface, int row, const std::string &text, int columns,
+                                 Surface::Style style) {
+    int width = surface.getCols();
+    surface.clearToEol(row, 1);
+    surface.drawText(row, std::max((width - columns) / 2, 1), text, style);
+    surface.drawGlyph(row, width - 1, Surface::Glyph::VerticalLine, BORDER_STYLE);
+    cellsPainted += std::max(width - 2, 0);
+}
+
+void HeaderView::drawProgressCells(Surface &surface, const State &next, int from, int to) {
+    from = std::max(from, 0);
+    to = std::min(to, next.progressWidth - 1);
+    if (from > to) return;
+
+    cells.clear();
+    for (int i = from; i <= to; i++) {
+        if (i < next.progressPos) {
+            cells += '=';
+        } else if (i == next.progressPos) {
+            cells += '>';
+        } else {
+            cells += ' ';
+        }
+    }
+    surface.drawText(PROGRESS_ROW, PROGRESS_COL + 1 + from, cells, PROGRESS_STYLE);
+    cellsPainted += to - from + 1;
+}
@@ -3,15 +3,19 @@
 #include "include/Helper.h"
 #include "include/LastFmScrobbler.h"
 #include "include/UrlUtils.h"
-#include "../lib/json.hpp"
+#include "include/Unicode.h"
+#include "include/Clock.h"
+#include "include/SpeculativeResolver.h"
 #import "include/TrackManager.h"
 #include <regex>
+#include <sstream>
 #include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
 #import <Foundation/Foundation.h>
 #import <Cocoa/Cocoa.h>
 
-using json = nlohmann::json;
-
 double getAppleMusicDuration() {
     FILE *pipe = popen("osascript -e 'tell application \"Music\" to get duration of current track'", "r");
     if (!pipe) {
@@ -31,6 +35,74 @@ double getAppleMusicDuration() {
     }
 }
 
+std::vector<Prefetcher::Hint> Helper::getAppleMusicUpNext(const std::string &currentTitle, int count) {
+    std::vector<Prefetcher::Hint> upcoming;
+    if (count <= 0 || currentTitle.empty()) {
+        return upcoming;
+    }
+
+    // Checking "is running" first keeps the query from launching Music
+    const std::vector<std::string> script = {
+            "if application \"Music\" is running then",
+            "tell application \"Music\"",
+            "if player state is not stopped then",
+            "set pl to current playlist",
+            "set i to index of current track",
+            "set j to i + " + std::to_string(count),
+            "if j > (count of tracks of pl) then set j to count of tracks of pl",
+            "set output to \"\"",
+            "repeat with k from i to j",
+            "set t to track k of pl",
+            "set output to output & artist of t & tab & name of t & tab & album of t & linefeed",
+            "end repeat",
+            "return output",
+            "end if",
+            "end tell",
+            "end if",
+            "return \"\""
+    };
+    std::string command = "osascript";
+    for (const auto &line: script) {
+        command += " -e '" + line + "'";
+    }
+    command += " 2>/dev/null";
+
+    FILE *pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        return upcoming;
+    }
+    char buffer[512];
+    std::string result;
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        result += buffer;
+    }
+    pclose(pipe);
+
+    std::istringstream lines(result);
+    std::string line;
+    bool first = true;
+    while (std::getline(lines, line)) {
+        size_t firstTab = line.find('\t');
+        size_t secondTab = firstTab == std::string::npos ? std::string::npos : line.find('\t', firstTab + 1);
+        if (secondTab == std::string::npos) {
+            continue;
+        }
+        Prefetcher::Hint hint{line.substr(0, firstTab),
+                              line.substr(firstTab + 1, secondTab - firstTab - 1),
+                              line.substr(secondTab + 1)};
+        if (first) {
+            // Another player is the source, or the playlist order is not what plays next
+            if (hint.title != currentTitle) {
+                return upcoming;
+            }
+            first = false;
+            continue;
+        }
+        upcoming.push_back(std::move(hint));
+    }
+    return upcoming;
+}
+
 bool getAppleMusicStatus() {
     static NSString *script = @"tell application \"Music\"\n"
                                    "    if player state is playing then\n"
@@ -88,6 +160,32 @@ double getAppleMusicPosition() {
     return -1.0;
 }
 
+std::string decodeLegacyEncoding(const std::string &input) {
+    @autoreleasepool {
+        NSData *data = [NSData dataWithBytes:input.data() length:input.length()];
+        if (!data) {
+            return "";
+        }
+
+        NSStringEncoding encodings[] = {
+            CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingGB_18030_2000),
+            CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingBig5),
+            CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingShiftJIS),
+            CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingEUC_JP),
+            CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingEUC_KR),
+        };
+
+        for (NSStringEncoding encoding : encodings) {
+            NSString *str = [[[NSString alloc] initWithData:data encoding:encoding] autorelease];
+            if (str && str.UTF8String) {
+                return std::string(str.UTF8String);
+            }
+        }
+    }
+
+    return "";
+}
+
 void Helper::extractMetadata(CFDictionaryRef info, std::string &artist, std::string &title, std::string &album,
                              double &duration, double &playbackRate) {
 
@@ -167,7 +265,7 @@ void Helper::extractMetadata(CFDictionaryRef info, std::string &artist, std::str
 double
 Helper::updateElapsedTime(CFDictionaryRef info, double &reportedElapsed, double playbackRate, double &elapsedValue,
                           double &lastElapsed, double &lastFetchTime, double &lastReportedElapsed) {
-    double now = CFAbsoluteTimeGetCurrent();
+    double now = Clock::getInstance().nowSeconds();
 
     auto elapsedTime = (CFNumberRef) CFDictionaryGetValue(info, CFSTR("kMRMediaRemoteNowPlayingInfoElapsedTime"));
     if (elapsedTime) {
@@ -307,106 +405,26 @@ std::string Helper::normalizeString(const std::string &input) {
         return input;
     }
 
-    @autoreleasepool {
-        if (input.find_first_of('\0') != std::string::npos) {
-            LOG_ERROR("Input string contains null characters");
-            return input;
-        }
-
-        // 首先尝试直接创建NSString
-        NSString *str = @(input.c_str());
-        if (!str) {
-            // 如果直接创建失败，尝试通过NSData和不同编码创建
-            NSData *data = [[NSData alloc] initWithBytes:input.c_str() length:input.length()];
-            if (!data) {
-                LOG_ERROR("Failed to create NSData");
-                return input;
-            }
-
-            NSStringEncoding encodings[] = {
-                NSUTF8StringEncoding,
-                CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingGB_18030_2000),
-                CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingBig5),
-                CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingShiftJIS),
-                CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingEUC_JP),
-                CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingEUC_KR),
-            };
-
-            for (NSStringEncoding encoding : encodings) {
-                str = [[NSString alloc] initWithData:data encoding:encoding];
-                if (str) break;
-            }
-
-            [data release];
-
-            if (!str) {
-                LOG_ERROR("Failed to create NSString with any encoding");
-                return input;
-            }
-        } else {
-            str = [str retain];
-        }
+    std::string scratch;
+    std::string_view normalized = Unicode::normalize(input, scratch, Unicode::Form::NarrowNFC);
+    if (normalized.data() == input.data()) {
+        return input;
+    }
+    if (normalized.data()) {
+        return std::string(normalized);
+    }
 
+    // Not valid UTF-8, the metadata is probably in a legacy CJK encoding
+    std::string transcoded = decodeLegacyEncoding(input);
+    if (transcoded.empty()) {
+        LOG_ERROR("Failed to decode string with any encoding");
         std::string result = input;
-        @try {
-            // 规范化处理
-            NSString *decomposedStr = [str decomposedStringWithCanonicalMapping];
-            [str release];
-            
-            if (!decomposedStr) {
-                LOG_ERROR("Failed during decomposed mapping");
-                return input;
-            }
-
-            // 创建可变字符串副本
-            CFMutableStringRef mutableStr = CFStringCreateMutableCopy(kCFAllocatorDefault, 0, (__bridge CFStringRef)decomposedStr);
-            if (!mutableStr) {
-                LOG_ERROR("Failed to create mutable copy of string");
-                return input;
-            }
-
-            // 执行全角到半角的转换
-            if (!CFStringTransform(mutableStr, nullptr, kCFStringTransformFullwidthHalfwidth, false)) {
-                CFRelease(mutableStr);
-                LOG_ERROR("Failed to transform string");
-                return input;
-            }
-
-            // 转换回标准形式
-            NSString *transformedStr = (__bridge NSString *)mutableStr;
-            NSString *precomposedStr = [transformedStr precomposedStringWithCanonicalMapping];
-            CFRelease(mutableStr);
-
-            if (!precomposedStr) {
-                LOG_ERROR("Failed during precomposed mapping");
-                return input;
-            }
-
-            // 转换回UTF-8
-            NSData *resultData = [precomposedStr dataUsingEncoding:NSUTF8StringEncoding 
-                                          allowLossyConversion:YES];
-            if (!resultData) {
-                LOG_ERROR("Failed to convert normalized string back to UTF-8");
-                return input;
-            }
-
-            const char *bytes = static_cast<const char*>(resultData.bytes);
-            NSUInteger length = resultData.length;
-
-            if (bytes && length > 0) {
-                result = std::string(bytes, length);
-                result.erase(std::remove_if(result.begin(), result.end(),
-                                            [](unsigned char c) { return isUtf8Control(std::string(1, c)); }),
-                             result.end());
-            }
-        }
-        @catch (NSException *exception) {
-            LOG_ERROR("Exception during string normalization: " + std::string([[exception description] UTF8String]));
-            [str release];
-        }
-
+        Unicode::stripAsciiControls(result);
         return result;
     }
+
+    normalized = Unicode::normalize(transcoded, scratch, Unicode::Form::NarrowNFC);
+    return normalized.data() ? std::string(normalized) : transcoded;
 }
 
 
@@ -479,10 +497,11 @@ bool parseStandardFormat(const std::string &title, std::string &outArtist, std::
 }
 
 bool
-tryLastFmSearch(const std::string &artist, const std::string &title, std::string &outArtist, std::string &outTitle) {
+tryLastFmSearch(const std::string &artist, const std::string &title, std::string &outArtist, std::string &outTitle,
+                const CancellationToken &cancel, RateLimiter::Priority priority) {
     if (!title.empty()) {
         LastFmScrobbler &scrobbler = LastFmScrobbler::getInstance();
-        auto matches = scrobbler.bestMatch(artist, title);
+        auto matches = scrobbler.bestMatch(artist, title, cancel, priority);
         if (!matches.empty() && matches.size() >= 2) {
             outArtist = matches.front();
             matches.pop_front();
@@ -496,38 +515,79 @@ tryLastFmSearch(const std::string &artist, const std::string &title, std::string
     return false;
 }
 
-bool isRealArtist(const std::string &artist) {
+bool isRealArtist(const std::string &artist, const CancellationToken &cancel, RateLimiter::Priority priority) {
     std::map<std::string, std::string> params = {
             {"artist",      artist},
             {"autocorrect", "0"}
     };
 
     std::string url = UrlUtils::buildApiUrl("artist.getInfo", params);
-    std::string response = UrlUtils::sendGetRequest(url);
-
-    try {
-        json j = json::parse(response);
-        return !j.contains("error");
-    } catch (...) {
-        return false;
-    }
+    ApiResponse response = UrlUtils::sendGetRequest(url, nullptr, 3, cancel, priority);
+    return response.ok();
 }
 
-bool
-Helper::extractMusicInfo(const std::string &artist, const std::string &title, const std::string &album,
-                         std::string &outArtist,
-                         std::string &outTitle) {
-    auto &trackManager = TrackManager::getInstance();
-    auto currentTrack = trackManager.getCurrentTrack();
-    std::string trackId = TrackManager::generateTrackId(artist, title, album);
+namespace {
+    struct Resolution {
+        std::string artist;
+        std::string title;
+        bool prefetched = false;
+        bool used = false;
+    };
 
-    if (trackManager.isCachedTrak(trackId)) {
-        currentTrack = trackManager.getCachedTrack(trackId);
-        outArtist = currentTrack->artist;
-        outTitle = currentTrack->title;
+    constexpr size_t MAX_RESOLUTIONS = 64;
+
+    // Shared by resolution on the event loop and prefetching on worker threads
+    std::mutex resolutionMutex;
+    std::map<std::string, Resolution> resolutions;
+    std::deque<std::string> resolutionOrder;
+    std::atomic<uint64_t> resolutionHits{0};
+    std::atomic<uint64_t> resolutionWasted{0};
+
+    bool lookupResolution(const std::string &trackId, std::string &outArtist, std::string &outTitle, bool consume) {
+        std::lock_guard<std::mutex> lock(resolutionMutex);
+        auto it = resolutions.find(trackId);
+        if (it == resolutions.end()) {
+            return false;
+        }
+        outArtist = it->second.artist;
+        outTitle = it->second.title;
+        if (consume && it->second.prefetched && !it->second.used) {
+            it->second.used = true;
+            resolutionHits++;
+        }
         return true;
     }
 
+    void storeResolution(const std::string &trackId, const std::string &artist, const std::string &title,
+                         bool prefetched) {
+        std::lock_guard<std::mutex> lock(resolutionMutex);
+        if (!resolutions.emplace(trackId, Resolution{artist, title, prefetched, false}).second) {
+            return;
+        }
+        resolutionOrder.push_back(trackId);
+        if (resolutionOrder.size() > MAX_RESOLUTIONS) {
+            auto oldest = resolutions.find(resolutionOrder.front());
+            if (oldest->second.prefetched && !oldest->second.used) {
+                resolutionWasted++;
+            }
+            resolutions.erase(oldest);
+            resolutionOrder.pop_front();
+        }
+    }
+
+    /**
+     * @brief Threads for SpeculativeResolver, one pool per priority so prefetches waiting for rate-limit tokens
+     * never hold up a track that is playing. Five is every job of one resolution.
+     */
+    WorkQueue &resolutionPool(RateLimiter::Priority priority) {
+        static WorkQueue foreground(5);
+        static WorkQueue prefetch(5);
+        return priority == RateLimiter::Priority::LYRICS_PREFETCH ? prefetch : foreground;
+    }
+}
+
+bool resolveMusicInfo(const std::string &artist, const std::string &title, std::string &outArtist,
+                      std::string &outTitle, const CancellationToken &cancel, RateLimiter::Priority priority) {
     if (nonMusicDetect(title)) {
         return false;
     }
@@ -535,62 +595,114 @@ Helper::extractMusicInfo(const std::string &artist, const std::string &title, co
     std::string normalizedArtist = Helper::normalizeString(artist);
     std::string cleanedArtist = Helper::cleanArtistName(normalizedArtist);
 
-    if (!cleanedArtist.empty() && isRealArtist(cleanedArtist)) {
-        LOG_DEBUG("Found valid artist on Last.fm: " + cleanedArtist);
-        if (tryLastFmSearch(cleanedArtist, title, outArtist, outTitle)) {
-            return true;
-        }
-    }
-
     std::string normalizedTitle = Helper::normalizeString(title);
     std::string cleanedTitle = Helper::cleanVideoTitle(normalizedTitle);
 
     trim(cleanedArtist);
     trim(cleanedTitle);
 
-    if (hasMusicSeparators(cleanedTitle)) {
-        if (parseStandardFormat(cleanedTitle, outArtist, outTitle)) {
-            outArtist = Helper::normalizeString(outArtist);
-            outTitle = Helper::normalizeString(outTitle);
-
-            outTitle = Helper::cleanVideoTitle(outTitle);
-            outArtist = Helper::cleanArtistName(outArtist);
-
-            trim(outArtist);
-            trim(outTitle);
-
-            if (!outArtist.empty() && !outTitle.empty() &&
-                outArtist.length() > 1 && outTitle.length() > 1) {
-                if (isRealArtist(outArtist)) {
-                    LOG_DEBUG("Found valid artist on Last.fm: " + outArtist);
-                    std::string verifiedArtist, verifiedTitle;
-                    if (tryLastFmSearch(outArtist, outTitle, verifiedArtist, verifiedTitle)) {
-                        outArtist = verifiedArtist;
-                        outTitle = verifiedTitle;
-                        return true;
-                    } else {
-                        return false;
-                    }
-                } else {
-                    LOG_DEBUG("Invalid artist name: " + outArtist);
-                    return false;
-                }
+    // Every interpretation is checked at once, so resolution costs one round trip instead of up to four
+    using Match = std::pair<std::string, std::string>;
+    SpeculativeResolver<Match> resolver(resolutionPool(priority));
+
+    auto artistExists = [priority](const std::string &candidate) {
+        return [candidate, priority](const CancellationToken &cancel) {
+            bool exists = isRealArtist(candidate, cancel, priority);
+            LOG_DEBUG((exists ? "Found valid artist on Last.fm: " : "Invalid artist name: ") + candidate);
+            return exists;
+        };
+    };
+    auto searchFor = [priority](const std::string &searchArtist, const std::string &searchTitle) {
+        return [searchArtist, searchTitle, priority](const CancellationToken &cancel) -> std::optional<Match> {
+            std::string foundArtist, foundTitle;
+            if (tryLastFmSearch(searchArtist, searchTitle, foundArtist, foundTitle, cancel, priority)) {
+                return Match(foundArtist, foundTitle);
             }
+            return std::nullopt;
+        };
+    };
+
+    // Preferred: the uploader is a real artist and the raw title finds the track
+    if (!cleanedArtist.empty()) {
+        resolver.add({artistExists(cleanedArtist)}, searchFor(cleanedArtist, title));
+    }
+
+    // Next: an "Artist - Title" style video title. When it parses, it is the last word
+    std::string parsedArtist, parsedTitle;
+    bool parsed = false;
+    if (hasMusicSeparators(cleanedTitle) && parseStandardFormat(cleanedTitle, parsedArtist, parsedTitle)) {
+        parsedArtist = Helper::cleanArtistName(Helper::normalizeString(parsedArtist));
+        parsedTitle = Helper::cleanVideoTitle(Helper::normalizeString(parsedTitle));
+
+        trim(parsedArtist);
+        trim(parsedTitle);
+
+        parsed = parsedArtist.length() > 1 && parsedTitle.length() > 1;
+        if (parsed) {
+            resolver.add({artistExists(parsedArtist)}, searchFor(parsedArtist, parsedTitle));
         }
-    } else {
-        outArtist = cleanedArtist;
-        outTitle = cleanedTitle;
-        LOG_DEBUG("No common title separator found in: " + cleanedTitle + ", trying Last.fm search");
     }
 
-    LOG_DEBUG("Trying Last.fm search with cleaned artist and title: " + cleanedArtist + " - " + cleanedTitle);
+    // Otherwise: search with the cleaned uploader and title as they are
+    if (!parsed) {
+        LOG_DEBUG("Trying Last.fm search with cleaned artist and title: " + cleanedArtist + " - " + cleanedTitle);
+        resolver.add({}, searchFor(cleanedArtist, cleanedTitle));
+    }
+
+    std::optional<Match> match = resolver.resolve(cancel);
+    if (!match) {
+        return false;
+    }
+
+    outArtist = match->first;
+    outTitle = match->second;
+    return true;
+}
+
+bool
+Helper::extractMusicInfo(const std::string &artist, const std::string &title, const std::string &album,
+                         std::string &outArtist,
+                         std::string &outTitle,
+                         const CancellationToken &cancel) {
+    // Tracks TrackManager already knows never get here, so only the thread-safe resolution cache is consulted
+    std::string trackId = TrackManager::generateTrackId(artist, title, album);
+
+    if (lookupResolution(trackId, outArtist, outTitle, true)) {
+        LOG_DEBUG("Resolved from cache: " + outArtist + " - " + outTitle);
+        return true;
+    }
 
-    return tryLastFmSearch(cleanedArtist, cleanedTitle, outArtist, outTitle);
-};
+    if (!resolveMusicInfo(artist, title, outArtist, outTitle, cancel, RateLimiter::Priority::RESOLUTION)) {
+        return false;
+    }
+    storeResolution(trackId, outArtist, outTitle, false);
+    return true;
+}
+
+bool Helper::prefetchMusicInfo(const std::string &artist, const std::string &title, const std::string &album,
+                               std::string &outArtist, std::string &outTitle, const CancellationToken &cancel) {
+    std::string trackId = TrackManager::generateTrackId(artist, title, album);
+    if (lookupResolution(trackId, outArtist, outTitle, false)) {
+        return true;
+    }
+
+    if (!resolveMusicInfo(artist, title, outArtist, outTitle, cancel, RateLimiter::Priority::LYRICS_PREFETCH)) {
+        return false;
+    }
+    storeResolution(trackId, outArtist, outTitle, true);
+    return true;
+}
+
+uint64_t Helper::getPrefetchedResolutionHits() {
+    return resolutionHits.load();
+}
+
+uint64_t Helper::getPrefetchedResolutionWasted() {
+    return resolutionWasted.load();
+}
 
 std::string Helper::toLower(std::string str) {
-    std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-    return str;
+    return Unicode::caseFold(str);
 }
 
 int Helper::levenshteinDistance(const std::string &s1, const std::string &s2) {
@@ -0,0 +1,130 @@
+#include "include/KeyDecoder.h"
+#include <cstring>
+
+namespace {
+    constexpr char ESC = 0x1B;
+
+    void emit(const KeyDecoder::Callback &callback, KeyEvent::Type type, char character = 0) {
+        KeyEvent event;
+        event.type = type;
+        event.character = character;
+        callback(event);
+    }
+
+    bool finalKey(char final, KeyEvent::Type &type) {
+        switch (final) {
+            case 'A': type = KeyEvent::Type::UP; return true;
+            case 'B': type = KeyEvent::Type::DOWN; return true;
+            case 'C': type = KeyEvent::Type::RIGHT; return true;
+            case 'D': type = KeyEvent::Type::LEFT; return true;
+            case 'H': type = KeyEvent::Type::HOME; return true;
+            case 'F': type = KeyEvent::Type::END; return true;
+            default: return false;
+        }
+    }
+
+    bool tildeKey(int code, KeyEvent::Type &type) {
+        switch (code) {
+            case 1:
+            case 7: type = KeyEvent::Type::HOME; return true;
+            case 4:
+            case 8: type = KeyEvent::Type::END; return true;
+            case 5: type = KeyEvent::Type::PAGE_UP; return true;
+            case 6: type = KeyEvent::Type::PAGE_DOWN; return true;
+            default: return false;
+        }
+    }
+}
+
+void KeyDecoder::feed(const char *data, size_t length, const Callback &callback) {
+    for (size_t i = 0; i < length; i++) {
+        char c = data[i];
+        if (pendingLength == 0 && c != ESC) {
+            emit(callback, KeyEvent::Type::CHARACTER, c);
+            continue;
+        }
+
+        if (pendingLength == MAX_SEQUENCE) {
+            // Not a sequence we understand; drop it rather than stall input
+            pendingLength = 0;
+        }
+        pending[pendingLength++] = c;
+
+        size_t consumed = decodeEscape(callback);
+        if (consumed > 0) {
+            std::memmove(pending, pending + consumed, pendingLength - consumed);
+            pendingLength -= consumed;
+        }
+        // A malformed sequence can leave an ordinary byte at the front
+        while (pendingLength > 0 && pending[0] != ESC) {
+            emit(callback, KeyEvent::Type::CHARACTER, pending[0]);
+            std::memmove(pending, pending + 1, --pendingLength);
+        }
+    }
+}
+
+void KeyDecoder::flush(const Callback &callback) {
+    if (pendingLength == 0) return;
+
+    emit(callback, KeyEvent::Type::ESCAPE);
+    for (size_t i = 1; i < pendingLength; i++) {
+        emit(callback, KeyEvent::Type::CHARACTER, pending[i]);
+    }
+    pendingLength = 0;
+}
+
+size_t KeyDecoder::decodeEscape(const Callback &callback) {
+    if (pendingLength < 2) {
+        return 0;
+    }
+
+    char introducer = pending[1];
+    if (introducer == ESC) {
+        emit(callback, KeyEvent::Type::ESCAPE);
+        return 1;
+    }
+
+    KeyEvent::Type type;
+    if (introducer == 'O') {
+        if (pendingLength < 3) return 0;
+        if (finalKey(pending[2], type)) {
+            emit(callback, type);
+        }
+        return 3;
+    }
+
+    if (introducer != '[') {
+        // Alt+key arrives as ESC followed by the key; deliver the key itself
+        emit(callback, KeyEvent::Type::CHARACTER, introducer);
+        return 2;
+    }
+
+    // CSI: parameter bytes 0x30-0x3F, intermediate bytes 0x20-0x2F, then a final byte 0x40-0x7E
+    size_t i = 2;
+    int firstParam = 0;
+    bool inFirstParam = true;
+    while (i < pendingLength) {
+        auto c = static_cast<unsigned char>(pending[i]);
+        if (c >= 0x40 && c <= 0x7E) {
+            if (c == '~') {
+                if (tildeKey(firstParam, type)) {
+                    emit(callback, type);
+                }
+            } else if (finalKey(static_cast<char>(c), type)) {
+                emit(callback, type);
+            }
+            return i + 1;
+        }
+        if (c < 0x20 || c > 0x3F) {
+            // Malformed; discard what we have and let the byte be read again
+            return i;
+        }
+        if (c >= '0' && c <= '9' && inFirstParam) {
+            firstParam = firstParam * 10 + (c - '0');
+        } else {
+            inFirstParam = false;
+        }
+        i++;
+    }
+    return 0;
+}
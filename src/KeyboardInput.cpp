@@ -0,0 +1,66 @@
+#include "include/KeyboardInput.h"
+#include "include/EventLoop.h"
+#include "include/Logger.h"
+#include <csignal>
+#include <unistd.h>
+
+KeyboardInput::~KeyboardInput() {
+    stop();
+}
+
+void KeyboardInput::start(Handler newHandler) {
+    stop();
+    handler = std::move(newHandler);
+    auto &loop = EventLoop::getInstance();
+
+    if (!loop.watchReadable(STDIN_FILENO, [this] { onReadable(); })) {
+        LOG_ERROR("Failed to watch stdin for keyboard input");
+        return;
+    }
+    watching = true;
+
+    loop.watchSignal(SIGWINCH, [this] {
+        KeyEvent event;
+        event.type = KeyEvent::Type::RESIZE;
+        handler(event);
+    });
+
+    // A lone ESC might be the start of a sequence whose remainder is still in flight
+    escapeTimer = loop.createTimer([this] {
+        decoder.flush(handler);
+    });
+}
+
+void KeyboardInput::stop() {
+    auto &loop = EventLoop::getInstance();
+    if (watching) {
+        loop.unwatch(STDIN_FILENO);
+        watching = false;
+    }
+    if (escapeTimer) {
+        loop.destroyTimer(escapeTimer);
+        escapeTimer = 0;
+    }
+}
+
+void KeyboardInput::onReadable() {
+    char buffer[64];
+    ssize_t bytesRead = read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (bytesRead == 0) {
+        LOG_DEBUG("stdin closed, keyboard input stopped");
+        stop();
+        return;
+    }
+    if (bytesRead < 0) {
+        return;
+    }
+
+    decoder.feed(buffer, static_cast<size_t>(bytesRead), handler);
+
+    auto &loop = EventLoop::getInstance();
+    if (decoder.hasPending()) {
+        loop.schedule(escapeTimer, KeyDecoder::ESCAPE_TIMEOUT_MS);
+    } else {
+        loop.cancel(escapeTimer);
+    }
+}
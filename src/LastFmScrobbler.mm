@@ -3,17 +3,22 @@
 #include "include/Credentials.h"
 #include "include/UrlUtils.h"
 #include "include/Helper.h"
+#include "include/Unicode.h"
 #include "include/Config.h"
-#include "../lib/json.hpp"
+#include "include/Clock.h"
+#include "include/CircuitBreaker.h"
+#include "include/EventLoop.h"
 #include <map>
 
-using json = nlohmann::json;
-
 LastFmScrobbler::LastFmScrobbler() : curl(nullptr) {
+    // The worker posts results to the loop, so the loop has to be destroyed after this
+    EventLoop::getInstance();
     init();
 }
 
 LastFmScrobbler::~LastFmScrobbler() {
+    shutdown.cancel();
+    worker.stop();
     cleanup();
 }
 
@@ -36,41 +41,19 @@ void LastFmScrobbler::cleanup() {
 
 bool LastFmScrobbler::sendNowPlaying(const std::string &artist, const std::string &track, const std::string &album,
                                      double duration) {
-    auto &credentials = Credentials::getInstance();
-
-    std::string sessionKey = Credentials::loadSessionKey();
-    if (sessionKey.empty()) {
-        lastError = "No session key available";
-        LOG_ERROR(lastError);
+    std::shared_ptr<const Credentials::Secrets> secrets = Credentials::snapshot();
+    if (secrets->sessionKey.empty()) {
+        LOG_ERROR("No session key available");
         return false;
     }
 
-    std::map<std::string, std::string> params = {
-            {"method", "track.updateNowPlaying"},
-            {"artist", artist},
-            {"track",  track},
-            {"sk",     sessionKey}
-    };
-
-    if (!album.empty()) {
-        params["album"] = album;
-    }
-    if (duration > 0) {
-        params["duration"] = std::to_string((int) duration);
+    if (!UrlUtils::encodeNowPlaying(artist, track, album, duration, *secrets, requestBody)) {
+        return false;
     }
+    ApiResponse response = UrlUtils::sendPostRequest(UrlUtils::API_URL, requestBody, curl, 3, shutdown,
+                                                     RateLimiter::Priority::NOW_PLAYING);
 
-    LOG_DEBUG("Sending now playing - Artist: '" + artist + "', Track: '" + track + "'");
-
-    std::map<std::string, std::string> allParams = params;
-    allParams["api_key"] = Credentials::getApiKey();
-    std::string apiSig = UrlUtils::generateSignature(allParams, credentials);
-    allParams["api_sig"] = apiSig;
-    allParams["format"] = "json";
-
-    std::string url = "https://ws.audioscrobbler.com/2.0/";
-    std::string response = UrlUtils::sendPostRequest(url, allParams, curl);
-
-    if (response.empty()) {
+    if (!response.ok()) {
         LOG_ERROR("Empty response from Last.fm");
         return false;
     }
@@ -78,114 +61,156 @@ bool LastFmScrobbler::sendNowPlaying(const std::string &artist, const std::strin
     return true;
 }
 
-void LastFmScrobbler::sendNowPlayingUpdate(const std::string &artist, const std::string &title, bool isMusic,
-                                           const std::string &album, double &lastNowPlayingSent, double playbackRate) {
-
+void LastFmScrobbler::updateNowPlaying(const NowPlayingPolicy::Observation &observation) {
     // Check if scrobbling is enabled in config
     if (!Config::getInstance().isScrobblingEnabled()) {
         return;
     }
 
-    if (playbackRate == 0.0) {
+    NowPlayingPolicy::Decision decision = nowPlayingPolicy.observe(observation);
+    if (decision == NowPlayingPolicy::Decision::SKIP || Credentials::isSessionRejected()) {
         return;
     }
 
-    if (!isMusic) {
+    // Scrobbles are going to the queue while Last.fm is down; an update would only fail the same way
+    if (CircuitBreaker::forUrl(UrlUtils::API_URL).isOpen()) {
+        nowPlayingPolicy.onSendFailed();
         return;
     }
 
-    double now = CFAbsoluteTimeGetCurrent();
-    if (now - lastNowPlayingSent < 30.0) {
-        return;
-    }
-
-    LOG_DEBUG("Sending now playing update");
-    lastNowPlayingSent = now;
-    LastFmScrobbler::getInstance().sendNowPlaying(artist, title, album, 0.0 /* duration placeh. */);
+    LOG_DEBUG("Sending now playing update: " + std::string(NowPlayingPolicy::describe(decision)));
+    worker.post([this, observation] {
+        if (!sendNowPlaying(observation.artist, observation.title, observation.album, observation.duration)) {
+            EventLoop::getInstance().post([this] { nowPlayingPolicy.onSendFailed(); });
+        }
+    });
 }
 
 bool LastFmScrobbler::scrobble(const std::string &artist, const std::string &track, const std::string &album,
                                double duration, int timeStamp) {
-    auto &credentials = Credentials::getInstance();
-
     if (!Config::getInstance().isScrobblingEnabled()) {
         LOG_DEBUG("Scrobbling is disabled in config");
         return false;
     }
 
-    std::string sessionKey = Credentials::loadSessionKey();
-    if (sessionKey.empty()) {
+    if (timeStamp == 0) {
+        timeStamp = static_cast<int>(Clock::getInstance().wallTimeSeconds());
+    }
+
+    ScrobbleQueue::Entry entry{artist, track, album, duration, timeStamp};
+
+    // Kept for the next run, which signs in again and flushes the queue on startup
+    if (Credentials::isSessionRejected()) {
+        LOG_INFO("No valid session, queued scrobble: " + artist + " - " + track);
+        lastScrobbled = entry;
+        worker.post([entry = std::move(entry)]() mutable { ScrobbleQueue::getInstance().push(std::move(entry)); });
+        return true;
+    }
+
+    if (!Credentials::hasSessionKey()) {
         lastError = "No session key available";
         LOG_ERROR(lastError);
         return false;
     }
 
-    if (timeStamp == 0) {
-        timeStamp = (int) std::time(nullptr);
+    // While Last.fm is known to be down the entry only waits in the queue for the next flush
+    if (CircuitBreaker::forUrl(UrlUtils::API_URL).isOpen()) {
+        LOG_INFO("Last.fm unavailable, queued scrobble: " + artist + " - " + track);
     }
 
-    std::map<std::string, std::string> params = {
-            {"method",    "track.scrobble"},
-            {"artist",    artist},
-            {"track",     track},
-            {"timestamp", std::to_string(timeStamp)},
-            {"sk",        sessionKey}
-    };
+    lastScrobbled = entry;
 
-    if (!album.empty()) {
-        params["album"] = album;
-    }
-    if (duration > 0) {
-        params["duration"] = std::to_string((int) duration);
+    // Queued first, even when Last.fm is up, so it goes out behind older entries and survives a crash mid-request
+    worker.post([this, entry = std::move(entry)]() mutable {
+        ScrobbleQueue::getInstance().push(std::move(entry));
+        drainQueue();
+    });
+    return true;
+}
+
+ScrobbleQueue::Result LastFmScrobbler::submitScrobble(const ScrobbleQueue::Entry &entry,
+                                                      const Credentials::Secrets &secrets) {
+    if (!UrlUtils::encodeScrobble(entry, secrets, requestBody)) {
+        return ScrobbleQueue::Result::REJECTED;
     }
+    ApiResponse response = UrlUtils::sendPostRequest(UrlUtils::API_URL, requestBody, curl, 3, shutdown);
 
-    std::map<std::string, std::string> allParams = params;
-    allParams["api_key"] = Credentials::getApiKey();
-    std::string apiSig = UrlUtils::generateSignature(allParams, credentials);
-    allParams["api_sig"] = apiSig;
-    allParams["format"] = "json";
+    if (response.ok()) {
+        return ScrobbleQueue::Result::SUBMITTED;
+    }
+    // A rejected session key is the account's problem, not the scrobble's; keep it until the user signs in again
+    if (UrlUtils::lastFailureWasTransient() || UrlUtils::getLastErrorCode() == 9) {
+        return ScrobbleQueue::Result::FAILED;
+    }
+    return ScrobbleQueue::Result::REJECTED;
+}
 
-    std::string url = "https://ws.audioscrobbler.com/2.0/";
-    std::string response = UrlUtils::sendPostRequest(url, allParams, curl);
+void LastFmScrobbler::flushQueue() {
+    CircuitBreaker &breaker = CircuitBreaker::forUrl(UrlUtils::API_URL);
+    if (breaker.isOpen()) {
+        scheduleQueueFlush(breaker.msUntilRetry());
+        return;
+    }
 
-    if (!response.empty()) {
-        LOG_INFO("Scrobbled: " + artist + " - " + track +
-                 (album.empty() ? "" : " [" + album + "]"));
-        return true;
+    if (!Credentials::hasSessionKey()) {
+        return;
     }
 
-    return false;
+    worker.post([this] { drainQueue(); });
 }
 
-bool
-LastFmScrobbler::shouldScrobble(double elapsed, double duration, double playbackRate, bool isMusic) {
-    // Check if scrobbling is enabled in config
-    if (!Config::getInstance().isScrobblingEnabled()) {
-        return false;
+void LastFmScrobbler::drainQueue() {
+    // Empty once Last.fm has rejected the key, including after this was posted
+    std::shared_ptr<const Credentials::Secrets> secrets = Credentials::snapshot();
+    if (secrets->sessionKey.empty()) {
+        return;
     }
 
-    if (!isMusic) return false;
+    auto &queue = ScrobbleQueue::getInstance();
+    size_t submitted = queue.flush([this, &secrets](const ScrobbleQueue::Entry &entry) {
+        ScrobbleQueue::Result result = submitScrobble(entry, *secrets);
+        // Reported once the request is done, so building and signing it stays free of string work
+        if (result == ScrobbleQueue::Result::SUBMITTED) {
+            LOG_INFO("Scrobbled: " + entry.artist + " - " + entry.track +
+                     (entry.album.empty() ? "" : " [" + entry.album + "]"));
+        }
+        return result;
+    });
+    if (submitted > 0) {
+        LOG_INFO("Submitted " + std::to_string(submitted) + " queued scrobbles");
+    }
 
-    double progressPercentage = (duration > 0.0) ? (elapsed / duration) * 100.0 : 0.0;
+    size_t remaining = queue.size();
+    // A rejected session stays rejected until the next sign-in, so retrying would only be refused again
+    if (remaining == 0 || shutdown.isCancelled() || Credentials::isSessionRejected()) {
+        return;
+    }
+    LOG_INFO(std::to_string(remaining) + " scrobbles queued until Last.fm is reachable");
+    EventLoop::getInstance().post([this] {
+        CircuitBreaker &breaker = CircuitBreaker::forUrl(UrlUtils::API_URL);
+        scheduleQueueFlush(breaker.isOpen() ? breaker.msUntilRetry() : QUEUE_RETRY_MS);
+    });
+}
 
-    return (progressPercentage > 50.0 || elapsed > 240.0);
+void LastFmScrobbler::scheduleQueueFlush(int64_t delayMs) {
+    auto &loop = EventLoop::getInstance();
+    if (!queueFlushTimer) {
+        queueFlushTimer = loop.createTimer([this] { flushQueue(); });
+    }
+    // Late by up to a second is fine, so it can share a wakeup with the playback poll
+    loop.schedule(queueFlushTimer, std::max<int64_t>(delayMs, 1), 0, 1000);
 }
 
-std::string LastFmScrobbler::search(const std::string &artist, const std::string &track) {
+ApiResponse LastFmScrobbler::search(const std::string &artist, const std::string &track,
+                                    const CancellationToken &cancel, RateLimiter::Priority priority) {
     std::string safeArtist = artist;
     std::string safeTrack = track;
 
-    auto cleanString = [](std::string &s) {
-        s.erase(std::remove_if(s.begin(), s.end(),
-                               [](unsigned char c)  { return Helper::isUtf8Control(std::string(1, c)); }),
-                s.end());
-    };
-
     LOG_DEBUG("Cleaning artist and track names");
     LOG_DEBUG("Original: " + safeArtist + " - " + safeTrack);
 
-    cleanString(safeArtist);
-    cleanString(safeTrack);
+    Unicode::stripAsciiControls(safeArtist);
+    Unicode::stripAsciiControls(safeTrack);
 
     std::map<std::string, std::string> params;
     if (!safeArtist.empty()) {
@@ -196,38 +221,29 @@ std::string LastFmScrobbler::search(const std::string &artist, const std::string
     }
 
     std::string url = UrlUtils::buildApiUrl("track.search", params);
-    std::string response = UrlUtils::sendGetRequest(url, curl);
+    ApiResponse response = UrlUtils::sendGetRequest(url, nullptr, 3, cancel, priority);
 
     if (response.empty()) {
         LOG_ERROR("Empty response from Last.fm search");
-        return "{}";
     }
 
     return response;
 }
 
-std::list<std::string> LastFmScrobbler::bestMatch(const std::string &artist, const std::string &track) {
+std::list<std::string> LastFmScrobbler::bestMatch(const std::string &artist, const std::string &track,
+                                                  const CancellationToken &cancel, RateLimiter::Priority priority) {
     std::list<std::string> result;
     LOG_DEBUG("Searching for best match for: " + artist + " - " + track);
 
     auto searchAndMatch = [&](const std::string &searchArtist, const std::string &searchTrack) -> bool {
-        json j;
-        try {
-            std::string response = LastFmScrobbler::search(searchArtist, searchTrack);
-            if (response == "{}") {
-                LOG_DEBUG("Empty search response");
-                return false;
-            }
-            j = json::parse(response);
-        } catch (const std::exception &e) {
-            LOG_ERROR("JSON Parsing failed: " + std::string(e.what()));
+        ApiResponse response = LastFmScrobbler::search(searchArtist, searchTrack, cancel, priority);
+        if (!response.ok()) {
+            LOG_DEBUG("Empty search response");
             return false;
         }
 
-        if (!j.contains("results") ||
-            !j["results"].contains("trackmatches") ||
-            !j["results"]["trackmatches"].contains("track") ||
-            j["results"]["trackmatches"]["track"].empty()) {
+        const std::vector<ApiResponse::TrackMatch> &candidates = response.trackMatches();
+        if (candidates.empty()) {
             LOG_DEBUG("No track matches found in JSON response");
             return false;
         }
@@ -238,14 +254,13 @@ std::list<std::string> LastFmScrobbler::bestMatch(const std::string &artist, con
         std::string artistLower = Helper::toLower(searchArtist);
         std::string trackLower = Helper::toLower(searchTrack);
 
-        for (const auto &candidate: j["results"]["trackmatches"]["track"]) {
-            if (!candidate.contains("artist") || !candidate.contains("name") ||
-                !candidate.contains("listeners"))
+        for (const auto &candidate: candidates) {
+            if (candidate.artist.empty() || candidate.name.empty())
                 continue;
 
-            std::string foundArtist = candidate["artist"].get<std::string>();
-            std::string foundTrack = candidate["name"].get<std::string>();
-            int listeners = std::stoi(candidate["listeners"].get<std::string>());
+            const std::string &foundArtist = candidate.artist;
+            const std::string &foundTrack = candidate.name;
+            int listeners = candidate.listeners;
 
             std::string foundArtistLower = Helper::toLower(foundArtist);
             std::string foundTrackLower = Helper::toLower(foundTrack);
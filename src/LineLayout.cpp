@@ -0,0 +1,45 @@
+#include "include/LineLayout.h"
+#include "include/Unicode.h"
+#include <algorithm>
+
+void LineLayout::build(const LyricTimeline &lyrics, int maxColumns) {
+    if (!isSource(lyrics)) {
+        source = &lyrics;
+        generation = lyrics.getGeneration();
+        widths.clear();
+    }
+
+    auto cached = std::find_if(widths.begin(), widths.end(),
+                               [maxColumns](const Width &width) { return width.columns == maxColumns; });
+    if (cached != widths.end()) {
+        std::rotate(cached, cached + 1, widths.end());
+        return;
+    }
+    if (widths.size() == MAX_WIDTHS) {
+        widths.erase(widths.begin());
+    }
+
+    Width width;
+    width.columns = maxColumns;
+    size_t lineCount = lyrics.size();
+    int budget = std::max(maxColumns - static_cast<int>(ELLIPSIS.size()), 0);
+    width.fitted.assign(lineCount, NOT_TRUNCATED);
+    for (size_t i = 0; i < lineCount; i++) {
+        if (lyrics.widthAt(i) > maxColumns) {
+            width.fitted[i] = static_cast<uint32_t>(Unicode::fitColumns(lyrics.textAt(i), budget));
+        }
+    }
+    widths.push_back(std::move(width));
+    computed++;
+}
+
+void LineLayout::clear() {
+    source = nullptr;
+    generation = 0;
+    widths.clear();
+}
+
+std::string_view LineLayout::textAt(size_t index) const {
+    std::string_view text = source->textAt(index);
+    return isTruncated(index) ? text.substr(0, widths.back().fitted[index]) : text;
+}
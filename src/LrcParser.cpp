@@ -0,0 +1,153 @@
+#include "include/LrcParser.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    /**
+     * @brief Parse "mm:ss", "mm:ss.x", "mm:ss.xx" or "mm:ss.xxx" (':' is accepted before the fraction too).
+     */
+    bool parseTimestamp(std::string_view tag, int32_t &timeMs) {
+        size_t i = 0;
+        int64_t minutes = 0;
+        size_t start = i;
+        while (i < tag.size() && isDigit(tag[i]) && i - start < 4) {
+            minutes = minutes * 10 + (tag[i++] - '0');
+        }
+        if (i == start || i >= tag.size() || tag[i] != ':') return false;
+        i++;
+
+        int64_t seconds = 0;
+        start = i;
+        while (i < tag.size() && isDigit(tag[i]) && i - start < 2) {
+            seconds = seconds * 10 + (tag[i++] - '0');
+        }
+        if (i == start) return false;
+
+        int64_t fraction = 0;
+        if (i < tag.size() && (tag[i] == '.' || tag[i] == ':')) {
+            i++;
+            start = i;
+            while (i < tag.size() && isDigit(tag[i]) && i - start < 3) {
+                fraction = fraction * 10 + (tag[i++] - '0');
+            }
+            size_t digits = i - start;
+            if (digits == 0) return false;
+            if (digits == 1) fraction *= 100;
+            else if (digits == 2) fraction *= 10;
+        }
+        if (i != tag.size()) return false;
+
+        timeMs = static_cast<int32_t>((minutes * 60 + seconds) * 1000 + fraction);
+        return true;
+    }
+
+    bool parseOffset(std::string_view value, int32_t &offset) {
+        while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+        while (!value.empty() && value.back() == ' ') value.remove_suffix(1);
+
+        bool negative = false;
+        if (!value.empty() && (value.front() == '+' || value.front() == '-')) {
+            negative = value.front() == '-';
+            value.remove_prefix(1);
+        }
+        if (value.empty() || value.size() > 7) return false;
+
+        int32_t result = 0;
+        for (char c: value) {
+            if (!isDigit(c)) return false;
+            result = result * 10 + (c - '0');
+        }
+        offset = negative ? -result : result;
+        return true;
+    }
+}
+
+LrcDocument LrcDocument::parse(std::string_view lyrics) {
+    LrcDocument doc;
+    doc.bufferSize = lyrics.size();
+    doc.buffer = std::make_unique<char[]>(lyrics.size() + 1);
+    char *out = doc.buffer.get();
+    size_t written = 0;
+
+    std::vector<int32_t> stamps;
+    size_t pos = 0;
+
+    while (pos < lyrics.size()) {
+        size_t end = lyrics.find('\n', pos);
+        if (end == std::string_view::npos) end = lyrics.size();
+        std::string_view line = lyrics.substr(pos, end - pos);
+        pos = end + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+        // Leading [tag] run: timestamps and metadata
+        stamps.clear();
+        size_t i = 0;
+        while (i < line.size() && line[i] == '[') {
+            size_t close = line.find(']', i + 1);
+            if (close == std::string_view::npos) break;
+            std::string_view tag = line.substr(i + 1, close - i - 1);
+            int32_t timeMs;
+            if (parseTimestamp(tag, timeMs)) {
+                stamps.push_back(timeMs);
+            } else if (tag.size() > 7 && tag.compare(0, 7, "offset:") == 0) {
+                parseOffset(tag.substr(7), doc.offsetMs);
+            }
+            i = close + 1;
+        }
+        if (stamps.empty()) continue;
+
+        // Copy the text, cutting <mm:ss.xx> word tags out as we go
+        size_t textStart = written;
+        auto firstWord = static_cast<uint32_t>(doc.words.size());
+        size_t wordStart = written;
+        int32_t wordTime = -1;
+
+        auto closeWord = [&]() {
+            if (wordTime >= 0) {
+                doc.words.push_back({wordTime - stamps.front(),
+                                     std::string_view(out + wordStart, written - wordStart)});
+            }
+        };
+
+        while (i < line.size()) {
+            if (line[i] == '<') {
+                size_t close = line.find('>', i + 1);
+                int32_t timeMs;
+                if (close != std::string_view::npos && parseTimestamp(line.substr(i + 1, close - i - 1), timeMs)) {
+                    closeWord();
+                    wordTime = timeMs;
+                    wordStart = written;
+                    i = close + 1;
+                    continue;
+                }
+            }
+            out[written++] = line[i++];
+        }
+        closeWord();
+
+        // A trailing word tag only marks the end time of the previous word
+        while (doc.words.size() > firstWord && doc.words.back().text.empty()) {
+            doc.words.pop_back();
+        }
+
+        std::string_view text(out + textStart, written - textStart);
+        auto wordCount = static_cast<uint32_t>(doc.words.size() - firstWord);
+        for (int32_t stamp: stamps) {
+            doc.lines.push_back({stamp, text, firstWord, wordCount});
+        }
+    }
+
+    if (doc.offsetMs != 0) {
+        for (Line &line: doc.lines) {
+            line.timeMs = std::max(0, line.timeMs - doc.offsetMs);
+        }
+    }
+
+    std::stable_sort(doc.lines.begin(), doc.lines.end(),
+                     [](const Line &a, const Line &b) { return a.timeMs < b.timeMs; });
+    return doc;
+}
@@ -0,0 +1,55 @@
+#include "include/LyricCursor.h"
+#include <algorithm>
+
+void LyricCursor::reset() {
+    generation = 0;
+    index = -1;
+    lastTimeMs = 0;
+    lastRate = 0.0;
+    repositions = 0;
+}
+
+void LyricCursor::reposition(const LyricTimeline &lines, int32_t timeMs) {
+    const auto &times = lines.getTimes();
+    auto it = std::upper_bound(times.begin(), times.end(), timeMs);
+    index = static_cast<int>(it - times.begin()) - 1;
+    repositions++;
+}
+
+int LyricCursor::update(const LyricTimeline &lines, int32_t timeMs, double playbackRate) {
+    if (lines.empty()) {
+        reset();
+        return -1;
+    }
+
+    // Replacing or editing lyrics in place changes the generation even when the address and size stay the same
+    bool sameTimeline = generation == lines.getGeneration();
+    int32_t delta = timeMs - lastTimeMs;
+    bool seeked = delta < -JITTER_TOLERANCE_MS || delta > SEEK_THRESHOLD_MS;
+
+    if (!sameTimeline || seeked || playbackRate != lastRate) {
+        generation = lines.getGeneration();
+        reposition(lines, timeMs);
+    } else {
+        auto size = static_cast<int>(lines.size());
+        while (index + 1 < size && lines.timeAt(index + 1) <= timeMs) {
+            index++;
+        }
+        // Interpolated time can run slightly ahead of the player and get corrected back
+        while (index >= 0 && lines.timeAt(index) > timeMs) {
+            index--;
+        }
+    }
+
+    lastTimeMs = timeMs;
+    lastRate = playbackRate;
+    return index;
+}
+
+int32_t LyricCursor::msUntilNextLine(const LyricTimeline &lines, int32_t timeMs) const {
+    auto next = static_cast<size_t>(index + 1);
+    if (next >= lines.size()) {
+        return -1;
+    }
+    return std::max(0, lines.timeAt(next) - timeMs);
+}
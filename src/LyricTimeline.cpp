@@ -0,0 +1,105 @@
+#include "include/LyricTimeline.h"
+#include "include/LrcParser.h"
+#include "include/Unicode.h"
+#include <algorithm>
+#include <atomic>
+
+LyricTimeline LyricTimeline::fromPlain(std::string_view lyrics) {
+    LyricTimeline timeline;
+    size_t lineCount = std::count(lyrics.begin(), lyrics.end(), '\n') + 1;
+    timeline.reserve(lineCount, lyrics.size());
+
+    size_t pos = 0;
+    while (pos < lyrics.size()) {
+        size_t end = lyrics.find('\n', pos);
+        if (end == std::string_view::npos) end = lyrics.size();
+        std::string_view line = lyrics.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        timeline.append(0, line);
+        pos = end + 1;
+    }
+
+    return timeline;
+}
+
+LyricTimeline LyricTimeline::fromSynced(const LrcDocument &document) {
+    LyricTimeline timeline;
+    const auto &lines = document.getLines();
+
+    size_t textBytes = 1;
+    size_t wordCount = 0;
+    for (const auto &line: lines) {
+        textBytes += line.text.size();
+        wordCount += line.wordCount;
+    }
+    timeline.reserve(lines.size() + 1, textBytes);
+    timeline.wordTimesMs.reserve(wordCount);
+    timeline.wordOffsets.reserve(wordCount);
+    timeline.wordLengths.reserve(wordCount);
+
+    timeline.append(0, " ");
+    for (const auto &line: lines) {
+        timeline.append(line.timeMs, line.text);
+        // Word views are slices of their line's text in the document buffer
+        for (const auto *word = document.wordsBegin(line); word != document.wordsEnd(line); ++word) {
+            timeline.appendWord(word->offsetMs, static_cast<size_t>(word->text.data() - line.text.data()),
+                                word->text.size());
+        }
+    }
+    return timeline;
+}
+
+void LyricTimeline::reserve(size_t lineCount, size_t textBytes) {
+    timesMs.reserve(lineCount);
+    offsets.reserve(lineCount);
+    lengths.reserve(lineCount);
+    widths.reserve(lineCount);
+    firstWords.reserve(lineCount);
+    arena.reserve(textBytes);
+}
+
+uint64_t LyricTimeline::nextGeneration() {
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void LyricTimeline::append(int32_t timeMs, std::string_view text) {
+    generation = nextGeneration();
+    timesMs.push_back(timeMs);
+    offsets.push_back(static_cast<uint32_t>(arena.size()));
+    lengths.push_back(static_cast<uint32_t>(text.size()));
+    widths.push_back(static_cast<uint16_t>(std::min(Unicode::displayWidth(text), 0xFFFF)));
+    firstWords.push_back(static_cast<uint32_t>(wordTimesMs.size()));
+    arena.append(text);
+}
+
+void LyricTimeline::appendWord(int32_t offsetMs, size_t byteOffset, size_t length) {
+    wordTimesMs.push_back(offsetMs);
+    wordOffsets.push_back(offsets.back() + static_cast<uint32_t>(byteOffset));
+    wordLengths.push_back(static_cast<uint32_t>(length));
+}
+
+void LyricTimeline::clear() {
+    generation = nextGeneration();
+    timesMs.clear();
+    offsets.clear();
+    lengths.clear();
+    widths.clear();
+    firstWords.clear();
+    wordTimesMs.clear();
+    wordOffsets.clear();
+    wordLengths.clear();
+    arena.clear();
+}
+
+size_t LyricTimeline::memoryUsage() const {
+    return timesMs.capacity() * sizeof(int32_t) +
+           offsets.capacity() * sizeof(uint32_t) +
+           lengths.capacity() * sizeof(uint32_t) +
+           widths.capacity() * sizeof(uint16_t) +
+           firstWords.capacity() * sizeof(uint32_t) +
+           wordTimesMs.capacity() * sizeof(int32_t) +
+           wordOffsets.capacity() * sizeof(uint32_t) +
+           wordLengths.capacity() * sizeof(uint32_t) +
+           arena.capacity();
+}
@@ -1,49 +1,192 @@
 #include "include/LyricsManager.h"
+#include "include/CursesTarget.h"
 #include "include/TrackManager.h"
 #include "include/Logger.h"
 #include "include/UrlUtils.h"
+#include "include/CircuitBreaker.h"
 #include "include/Helper.h"
+#include "include/LrcParser.h"
+#include "include/Unicode.h"
+#include "include/EventLoop.h"
+#include "include/Clock.h"
 #include "../lib/json.hpp"
-#include <sstream>
 #include <curl/curl.h>
-#include <regex>
-#include <locale.h>
+#include <algorithm>
+#include <cmath>
 
 using json = nlohmann::json;
 
-void LyricsManager::fetchLyrics(const std::string &artist, const std::string &title, const std::string &album,
-                                double duration) {
-    TrackManager::TrackState *currentTrack = TrackManager::getInstance().getCurrentTrack();
-    auto &config = Config::getInstance();
-    if (!currentTrack) return;
+LyricsManager::LyricsManager() {
+    // Fetches post their results to the loop, so the loop has to be destroyed after this
+    EventLoop::getInstance();
+}
 
-    currentTrack->plainLyrics = "";
-    currentTrack->syncedLyrics = "";
-    currentTrack->hasSyncedLyrics = false;
-    currentTrack->parsedPlainLyrics.clear();
-    currentTrack->parsedSyncedLyrics.clear();
-    currentTrack->currentLyricIndex = -1;
+LyricsManager::~LyricsManager() {
+    pendingCancel.cancel();
+    fetcher.stop();
+}
 
-    forceRefreshLyrics();
+void LyricsManager::fetchLyrics(const std::string &trackId, const std::string &artist, const std::string &title,
+                                const std::string &album, double duration, const CancellationToken &cancel) {
+    if (!Config::getInstance().isShowLyrics()) {
+        return;
+    }
+    if (trackId == pendingTrackId && !pendingCancel.isCancelled()) {
+        LOG_DEBUG("Lyrics already requested for: " + artist + " - " + title);
+        return;
+    }
+
+    pendingTrackId = trackId;
+    pendingCancel = cancel;
+    uint64_t fetchId = ++pendingFetchId;
 
-    if (!config.isShowLyrics()) {
+    std::string url = lyricsUrl(artist, title, album);
+    if (std::shared_ptr<const FetchedLyrics> warm = takeWarmLyrics(url)) {
+        LOG_DEBUG("Using prefetched lyrics for: " + artist + " - " + title);
+        EventLoop::getInstance().post([this, trackId, fetchId, warm] {
+            attachLyrics(trackId, fetchId, warm);
+        });
         return;
     }
+    if (duration > 0) {
+        url += "&duration=" + std::to_string(static_cast<int>(duration));
+    }
 
-    CURL *curl = curl_easy_init();
-    if (!curl) {
-        LOG_ERROR("Failed to initialize CURL");
+    fetcher.post([this, trackId, fetchId, url, cancel, description = artist + " - " + title] {
+        // Queued behind other fetches while its track was skipped
+        if (cancel.isCancelled()) return;
+        bool shared = false;
+        std::string key = flightKey(RateLimiter::Priority::RESOLUTION, url);
+        std::shared_ptr<const FetchedLyrics> fetched = lyricsFlights.run(key, [&] {
+            return requestLyrics(url, RateLimiter::Priority::RESOLUTION, cancel);
+        }, &shared);
+        if (shared) {
+            LOG_DEBUG("Joined in-flight lyrics request for: " + description);
+            if (!fetched && !cancel.isCancelled()) {
+                fetched = requestLyrics(url, RateLimiter::Priority::RESOLUTION, cancel);
+            }
+        }
+        EventLoop::getInstance().post([this, trackId, fetchId, fetched = std::move(fetched)] {
+            attachLyrics(trackId, fetchId, fetched);
+        });
+    });
+}
+
+void LyricsManager::prefetchLyrics(const std::string &artist, const std::string &title, const std::string &album,
+                                   const CancellationToken &cancel) {
+    if (!Config::getInstance().isShowLyrics()) {
         return;
     }
 
+    std::string url = lyricsUrl(artist, title, album);
+    auto isWarm = [&] {
+        return std::any_of(warmLyrics.begin(), warmLyrics.end(), [&](const auto &entry) { return entry.first == url; });
+    };
+    {
+        std::lock_guard<std::mutex> lock(warmMutex);
+        if (isWarm()) return;
+    }
+
+    std::string key = flightKey(RateLimiter::Priority::LYRICS_PREFETCH, url);
+    std::shared_ptr<const FetchedLyrics> fetched = lyricsFlights.run(key, [&] {
+        return requestLyrics(url, RateLimiter::Priority::LYRICS_PREFETCH, cancel);
+    });
+    // A cancelled prefetch is for a track that is no longer coming up, or is already playing
+    if (!fetched || cancel.isCancelled()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(warmMutex);
+    if (isWarm()) return;
+    warmLyrics.emplace_back(url, std::move(fetched));
+    LOG_DEBUG("Prefetched lyrics for: " + artist + " - " + title);
+    if (warmLyrics.size() > MAX_WARM_LYRICS) {
+        warmLyrics.pop_front();
+        prefetchWasted++;
+    }
+}
+
+std::shared_ptr<const LyricsManager::FetchedLyrics> LyricsManager::takeWarmLyrics(const std::string &url) {
+    std::lock_guard<std::mutex> lock(warmMutex);
+    auto it = std::find_if(warmLyrics.begin(), warmLyrics.end(), [&](const auto &entry) { return entry.first == url; });
+    if (it == warmLyrics.end()) {
+        return nullptr;
+    }
+    std::shared_ptr<const FetchedLyrics> fetched = std::move(it->second);
+    warmLyrics.erase(it);
+    prefetchHits++;
+    return fetched;
+}
+
+std::string LyricsManager::lyricsUrl(const std::string &artist, const std::string &title, const std::string &album) {
     std::string url = "https://lrclib.net/api/get?";
     url += "artist_name=" + UrlUtils::urlEncode(artist);
     url += "&track_name=" + UrlUtils::urlEncode(title);
     if (!album.empty()) {
         url += "&album_name=" + UrlUtils::urlEncode(album);
     }
-    if (duration > 0) {
-        url += "&duration=" + std::to_string(static_cast<int>(duration));
+    return url;
+}
+
+std::string LyricsManager::flightKey(RateLimiter::Priority priority, const std::string &url) {
+    return std::to_string(static_cast<int>(priority)) + ' ' + url;
+}
+
+void LyricsManager::attachLyrics(const std::string &trackId, uint64_t fetchId,
+                                 const std::shared_ptr<const FetchedLyrics> &fetched) {
+    if (fetchId == pendingFetchId) {
+        pendingTrackId.clear();
+    }
+
+    auto &trackManager = TrackManager::getInstance();
+    if (!trackManager.isCachedTrak(trackId)) {
+        LOG_DEBUG("Dropping lyrics for a track no longer cached: " + trackId);
+        return;
+    }
+    TrackManager::TrackState *state = trackManager.getCachedTrack(trackId);
+    if (fetched) {
+        state->plainLyrics = fetched->plain;
+        state->syncedLyrics = fetched->synced;
+        state->hasSyncedLyrics = !state->syncedLyrics.empty();
+        state->currentLyricIndex = -1;
+        LOG_DEBUG("Lyrics memory usage: " + std::to_string(state->lyricsMemoryUsage()) + " bytes");
+    }
+    if (state != trackManager.getCurrentTrack()) {
+        return;
+    }
+
+    lastLyricsLatencyMs = Clock::getInstance().nowMs() - trackManager.getTitleChangedMs();
+    LOG_DEBUG("Lyrics settled " + std::to_string(lastLyricsLatencyMs) + " ms after the title change");
+    if (state->hasSyncedLyrics && Config::getInstance().isPreferSyncedLyrics()) {
+        LOG_INFO("Synced lyrics found for: " + state->artist + " - " + state->title);
+    } else if (!state->plainLyrics.empty()) {
+        LOG_INFO("Plain lyrics found for: " + state->artist + " - " + state->title);
+    } else {
+        LOG_INFO("No lyrics found for: " + state->artist + " - " + state->title);
+    }
+    forceRefreshLyrics();
+}
+
+std::shared_ptr<const LyricsManager::FetchedLyrics> LyricsManager::requestLyrics(const std::string &url,
+                                                                                 RateLimiter::Priority priority,
+                                                                                 const CancellationToken &cancel) {
+    CircuitBreaker &breaker = CircuitBreaker::forUrl(url);
+    if (!breaker.allowRequest()) {
+        LOG_DEBUG("lrclib circuit open, skipping lyrics request: " + url);
+        return nullptr;
+    }
+
+    Deadline deadline = Deadline::after(LYRICS_BUDGET_MS);
+    if (!RateLimiter::lyrics().acquire(priority, cancel, deadline)) {
+        breaker.onAbandoned();
+        LOG_DEBUG("Lyrics request abandoned before it started: " + url);
+        return nullptr;
+    }
+
+    CURL *curl = UrlUtils::createHandle();
+    if (!curl) {
+        LOG_ERROR("Failed to initialize CURL");
+        return nullptr;
     }
 
     struct curl_slist *headers = nullptr;
@@ -52,25 +195,37 @@ void LyricsManager::fetchLyrics(const std::string &artist, const std::string &ti
     std::string response;
 
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
 
-    CURLcode res = curl_easy_perform(curl);
+    UrlUtils::ResponseInfo info;
+    CURLcode res = UrlUtils::perform(curl, url, nullptr, response, deadline, cancel, &info);
     curl_slist_free_all(headers);
     curl_easy_cleanup(curl);
 
+    if (res == CURLE_ABORTED_BY_CALLBACK) {
+        breaker.onAbandoned();
+        LOG_DEBUG("Lyrics request cancelled: " + url);
+        return nullptr;
+    }
     if (res != CURLE_OK) {
+        breaker.onFailure();
         LOG_ERROR("CURL error: " + std::string(curl_easy_strerror(res)));
-        return;
+        return nullptr;
+    }
+    // lrclib answers 404 for a track it has no lyrics for, which says nothing bad about lrclib
+    if (info.status == 429 || info.status >= 500) {
+        breaker.onFailure(info.retryAfterMs);
+        LOG_ERROR("lrclib returned HTTP " + std::to_string(info.status));
+        return nullptr;
     }
+    breaker.onSuccess();
 
     if (response.empty()) {
         LOG_INFO("No lyrics found");
-        return;
+        return nullptr;
     }
 
-    LOG_DEBUG("Lyrics response: " + response);
+    LOG_DEBUG("Lyrics response: HTTP " + std::to_string(info.status) + ", " + std::to_string(response.size()) +
+              " bytes");
 
     json j;
     try {
@@ -83,302 +238,259 @@ void LyricsManager::fetchLyrics(const std::string &artist, const std::string &ti
         LOG_INFO("No lyrics found: " + j.value("message", "Unknown error"));
     }
 
-    if (j.contains("plainLyrics") && !j["plainLyrics"].is_null()) {
-        currentTrack->plainLyrics = j["plainLyrics"];
-        parsePlainLyrics(currentTrack->plainLyrics);
-    } else {
-        currentTrack->plainLyrics = "";
+    auto fetched = std::make_shared<FetchedLyrics>();
+    if (j.contains("plainLyrics") && j["plainLyrics"].is_string()) {
+        fetched->plain = LyricTimeline::fromPlain(j["plainLyrics"].get_ref<const std::string &>());
     }
 
-    if (j.contains("syncedLyrics") && !j["syncedLyrics"].is_null()) {
-        currentTrack->syncedLyrics = j["syncedLyrics"];
-        parseSyncedLyrics(currentTrack->syncedLyrics);
-    } else {
-        currentTrack->syncedLyrics = "";
-        currentTrack->hasSyncedLyrics = false;
+    if (j.contains("syncedLyrics") && j["syncedLyrics"].is_string()) {
+        LrcDocument document = LrcDocument::parse(j["syncedLyrics"].get_ref<const std::string &>());
+        fetched->synced = LyricTimeline::fromSynced(document);
+        LOG_DEBUG("Parsed " + std::to_string(document.getLines().size()) + " synced lyric lines (offset " +
+                  std::to_string(document.getOffsetMs()) + "ms)");
     }
-
-    currentTrack->hasSyncedLyrics = !currentTrack->parsedSyncedLyrics.empty();
+    return fetched;
 }
 
 void LyricsManager::parseSyncedLyrics(const std::string &lyrics) {
     TrackManager::TrackState *currentTrack = TrackManager::getInstance().getCurrentTrack();
     if (!currentTrack) return;
 
-    currentTrack->parsedSyncedLyrics.clear();
-
-    std::regex timeTagRegex(R"(\[(\d+):(\d+)\.(\d+)\](.*))");
-    std::istringstream stream(lyrics);
-    std::string line;
-
-    currentTrack->parsedSyncedLyrics.emplace_back(0, " ");
-
-    while (std::getline(stream, line)) {
-        std::smatch matches;
-        if (std::regex_search(line, matches, timeTagRegex) && matches.size() > 4) {
-            int minutes = std::stoi(matches[1].str());
-            int seconds = std::stoi(matches[2].str());
-            int milliseconds = std::stoi(matches[3].str());
-            std::string lyricText = matches[4].str();
-
-            int totalMs = (minutes * 60 + seconds) * 1000 + milliseconds;
-            LOG_DEBUG("Parsed synced lyric: " + std::to_string(totalMs) + "ms - " + lyricText);
-            currentTrack->parsedSyncedLyrics.emplace_back(totalMs, lyricText);
-        }
-    }
-
-    std::sort(currentTrack->parsedSyncedLyrics.begin(), currentTrack->parsedSyncedLyrics.end(),
-              [](const auto &a, const auto &b) { return a.first < b.first; });
-}
+    LrcDocument document = LrcDocument::parse(lyrics);
+    currentTrack->syncedLyrics = LyricTimeline::fromSynced(document);
 
-size_t LyricsManager::WriteCallback(void *contents, size_t size, size_t nmemb, std::string *userp) {
-    size_t realsize = size * nmemb;
-    userp->append((char *) contents, realsize);
-    return realsize;
+    LOG_DEBUG("Parsed " + std::to_string(document.getLines().size()) + " synced lyric lines (offset " +
+              std::to_string(document.getOffsetMs()) + "ms)");
 }
 
 void LyricsManager::initNcurses() {
     if (!ncursesInitialized) {
-        setlocale(LC_ALL, "");
-
-        initscr();
-        cbreak();
-        noecho();
-        keypad(stdscr, TRUE);
-        curs_set(0);
-        start_color();
-
-        init_pair(1, COLOR_RED, COLOR_BLACK);     // Title
-        init_pair(2, COLOR_YELLOW, COLOR_BLACK);  // Song info
-        init_pair(3, COLOR_WHITE, COLOR_BLACK);   // Lyrics
-        init_pair(4, COLOR_CYAN, COLOR_BLACK);    // Current line
-        init_pair(5, COLOR_GREEN, COLOR_BLACK);   // Progress bar
-        init_pair(6, COLOR_MAGENTA, COLOR_BLACK); // Hint
+        renderTarget = std::make_unique<CursesTarget>();
 
-        int termHeight, termWidth;
-        getmaxyx(stdscr, termHeight, termWidth);
+        int termHeight = renderTarget->getRows();
+        int termWidth = renderTarget->getCols();
 
         int headerHeight = 5;
         int contentHeight = termHeight - headerHeight - 1;
 
-        lyricsWin = newwin(termHeight, termWidth, 0, 0);
+        headerSurface = renderTarget->createWindow(headerHeight, termWidth, 0, 0);
 
-        headerWin = newwin(headerHeight, termWidth, 0, 0);
+        contentSurface = renderTarget->createWindow(contentHeight, termWidth, headerHeight, 0);
 
-        contentWin = newwin(contentHeight, termWidth, headerHeight, 0);
+        statusSurface = renderTarget->createWindow(1, termWidth, termHeight - 1, 0);
 
         maxVisibleLines = contentHeight - 2;
         scrollPosition = 0;
-
-        nodelay(stdscr, TRUE);
+        headerView.invalidate();
+        lyricsView.attach(*renderTarget, *contentSurface);
+        hintDirty = true;
+        viewState = PLAYING;
+
+        // Log lines would scroll the screen, so show the latest one on the status row instead
+        Logger::getInstance().setConsoleSink([this](const std::string &message) { postStatus(message); });
+
+        static bool exitHandlerRegistered = false;
+        if (!exitHandlerRegistered) {
+            std::atexit([] { LyricsManager::getInstance().endNcurses(); });
+            exitHandlerRegistered = true;
+        }
 
         ncursesInitialized = true;
     }
 }
 
+void LyricsManager::handleResize() {
+    renderTarget->syncSize();
+
+    int termHeight = renderTarget->getRows();
+    int termWidth = renderTarget->getCols();
+
+    int headerHeight = 5;
+    int contentHeight = std::max(termHeight - headerHeight - 1, 3);
+
+    headerSurface->resize(headerHeight, termWidth);
+    contentSurface->resize(contentHeight, termWidth);
+    contentSurface->moveTo(headerHeight, 0);
+    statusSurface->resize(1, termWidth);
+    statusSurface->moveTo(termHeight - 1, 0);
+    maxVisibleLines = contentHeight - 2;
+
+    renderTarget->clear();
+    headerView.invalidate();
+    lyricsView.attach(*renderTarget, *contentSurface);
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        statusDirty = true;
+    }
+}
+
 void LyricsManager::endNcurses() {
     if (ncursesInitialized) {
-        delwin(contentWin);
-        delwin(headerWin);
-        delwin(lyricsWin);
-        endwin();
+        Logger::getInstance().setConsoleSink(nullptr);
+        lyricsView.detach();
+        statusSurface.reset();
+        contentSurface.reset();
+        headerSurface.reset();
+        // Surfaces go first: they delete their windows through the session the target ends
+        renderTarget.reset();
         ncursesInitialized = false;
     }
 }
 
-std::string LyricsManager::formatTime(double seconds) {
-    int mins = static_cast<int>(seconds) / 60;
-    int secs = static_cast<int>(seconds) % 60;
-    char buffer[10];
-    snprintf(buffer, sizeof(buffer), "%d:%02d", mins, secs);
-    return {buffer};
+void LyricsManager::drawHeader(const std::string &artist, const std::string &title, double elapsed, double duration) {
+    const char *label = viewState == PAUSED ? "Paused" : "Now Playing";
+    headerView.draw(*headerSurface,
+                    headerView.compute(label, artist, title, elapsed, duration, headerSurface->getCols()));
 }
 
-std::string LyricsManager::truncateText(const std::string &text, int maxWidth) {
-    if (text.length() <= maxWidth) {
-        return text;
-    }
-    return text.substr(0, maxWidth - 3) + "...";
+void LyricsManager::postStatus(const std::string &message) {
+    std::lock_guard<std::mutex> lock(statusMutex);
+    statusText = message;
+    statusDirty = true;
 }
 
-void LyricsManager::drawHeader(const std::string &artist, const std::string &title, double elapsed, double duration) {
-    werase(headerWin);
-
-    int height, width;
-    getmaxyx(headerWin, height, width);
-
-    wattron(headerWin, COLOR_PAIR(1));
-    box(headerWin, 0, 0);
-    wattroff(headerWin, COLOR_PAIR(1));
-
-    std::string headerText = "Now Playing";
-    wattron(headerWin, COLOR_PAIR(1) | A_BOLD);
-    mvwprintw(headerWin, 0, (width - headerText.length()) / 2, "%s", headerText.c_str());
-    wattroff(headerWin, COLOR_PAIR(1) | A_BOLD);
-
-    std::string songInfo = artist + " - " + title;
-    songInfo = truncateText(songInfo, width - 4);
-    wattron(headerWin, COLOR_PAIR(2) | A_BOLD);
-    mvwprintw(headerWin, 1, (width - songInfo.length()) / 2, "%s", songInfo.c_str());
-    wattroff(headerWin, COLOR_PAIR(2) | A_BOLD);
-
-    std::string timeInfo = formatTime(elapsed) + " / " + formatTime(duration);
-    wattron(headerWin, COLOR_PAIR(5));
-    mvwprintw(headerWin, 2, (width - timeInfo.length()) / 2, "%s", timeInfo.c_str());
-    wattroff(headerWin, COLOR_PAIR(5));
-
-    int progressWidth = width - 8;
-    double progress = (duration > 0) ? elapsed / duration : 0;
-    int progressPos = static_cast<int>(progress * progressWidth);
-
-    wattron(headerWin, COLOR_PAIR(5));
-    mvwprintw(headerWin, 3, 4, "[");
-    for (int i = 0; i < progressWidth; i++) {
-        if (i < progressPos) {
-            waddch(headerWin, '=');
-        } else if (i == progressPos) {
-            waddch(headerWin, '>');
-        } else {
-            waddch(headerWin, ' ');
-        }
+void LyricsManager::drawStatus() {
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        if (!statusDirty) return;
+        text = statusText;
+        statusDirty = false;
     }
-    mvwprintw(headerWin, 3, 4 + progressWidth + 1, "]");
-    wattroff(headerWin, COLOR_PAIR(5));
 
-    wrefresh(headerWin);
+    int width = statusSurface->getCols();
+    size_t length = Unicode::fitColumns(text, std::max(width - 1, 0));
+    statusSurface->erase();
+    statusSurface->drawText(0, 0, std::string_view(text).substr(0, length), {6, false});
+    statusSurface->stage();
 }
 
-void LyricsManager::drawSyncedLyrics(const std::vector<std::pair<int, std::string>> &lyrics, int currentIndex) {
-    werase(contentWin);
-
-    int height, width;
-    getmaxyx(contentWin, height, width);
-
-    wattron(contentWin, COLOR_PAIR(3));
-    box(contentWin, 0, 0);
-    wattroff(contentWin, COLOR_PAIR(3));
-
+void LyricsManager::drawSyncedLyrics(const LyricTimeline &lyrics, int currentIndex) {
     totalLines = lyrics.size();
 
     if (!manualScrollMode) {
-        int middleLine = (height - 2) / 2;
+        int middleLine = maxVisibleLines / 2;
         scrollPosition = std::max(0, currentIndex - middleLine);
         autoScrollPosition = scrollPosition;
     }
 
-    int displayedLines = 0;
-    for (int i = scrollPosition; i < totalLines && displayedLines < height - 2; i++) {
-        std::string line = lyrics[i].second;
-        line = truncateText(line, width - 6);
+    lyricsView.load(lyrics, LyricsView::Mode::Synced);
+    lyricsView.setCurrent(currentIndex);
 
-        if (i == currentIndex) {
-            wattron(contentWin, COLOR_PAIR(4) | A_BOLD);
-            mvwprintw(contentWin, displayedLines + 1, 2, ">%s", line.c_str());
-            wattroff(contentWin, COLOR_PAIR(4) | A_BOLD);
-        } else if (i < currentIndex) {
-            wattron(contentWin, COLOR_PAIR(3) | A_BOLD);
-            mvwprintw(contentWin, displayedLines + 1, 2, " %s", line.c_str());
-            wattroff(contentWin, COLOR_PAIR(3) | A_BOLD);
-        } else {
-            wattron(contentWin, COLOR_PAIR(3));
-            mvwprintw(contentWin, displayedLines + 1, 2, " %s", line.c_str());
-            wattroff(contentWin, COLOR_PAIR(3));
-        }
+    if (hintDirty) {
+        int width = lyricsView.getWidth();
+        std::string scrollModeHint = manualScrollMode ? "[Manual] 'a':auto" : "[Auto] 'a':manual";
+        std::string scrobblingHint = Config::getInstance().isScrobblingEnabled() ?
+                                     "[Scrobbling On] 's':toggle" :
+                                     "[Scrobbling Off] 's':toggle";
 
-        displayedLines++;
-    }
+        std::string combinedHint = scrollModeHint + " | " + scrobblingHint;
+        if (Unicode::displayWidth(combinedHint) > width - 4) {
+            scrollModeHint = manualScrollMode ? "[M]" : "[A]";
+            scrobblingHint = Config::getInstance().isScrobblingEnabled() ? "[S:On]" : "[S:Off]";
+            combinedHint = scrollModeHint + " 'a':toggle | " + scrobblingHint + " 's':toggle";
 
-    if (totalLines > height - 2) {
-        wattron(contentWin, COLOR_PAIR(6));
-        if (scrollPosition > 0) {
-            mvwaddch(contentWin, 0, width / 2, ACS_UARROW);
-        }
-        if (scrollPosition + height - 2 < totalLines) {
-            mvwaddch(contentWin, height - 1, width / 2, ACS_DARROW);
-        }
-        wattroff(contentWin, COLOR_PAIR(6));
-    }
-
-    std::string scrollModeHint = manualScrollMode ? "[Manual] 'a':auto" : "[Auto] 'a':manual";
-    std::string scrobblingHint = Config::getInstance().isScrobblingEnabled() ?
-                                 "[Scrobbling On] 's':toggle" :
-                                 "[Scrobbling Off] 's':toggle";
-
-    std::string combinedHint = scrollModeHint + " | " + scrobblingHint;
-    if (combinedHint.length() > width - 4) {
-        scrollModeHint = manualScrollMode ? "[M]" : "[A]";
-        scrobblingHint = Config::getInstance().isScrobblingEnabled() ? "[S:On]" : "[S:Off]";
-        combinedHint = scrollModeHint + " 'a':toggle | " + scrobblingHint + " 's':toggle";
-
-        if (combinedHint.length() > width - 4) {
-            combinedHint = manualScrollMode ? "[M]" : "[A]";
-            combinedHint += Config::getInstance().isScrobblingEnabled() ? " [S+]" : " [S-]";
+            if (Unicode::displayWidth(combinedHint) > width - 4) {
+                combinedHint = manualScrollMode ? "[M]" : "[A]";
+                combinedHint += Config::getInstance().isScrobblingEnabled() ? " [S+]" : " [S-]";
+            }
         }
+        lyricsView.setHint(combinedHint);
+        hintDirty = false;
     }
 
-    wattron(contentWin, COLOR_PAIR(6));
-    mvwprintw(contentWin, height - 1, (width - combinedHint.length()) / 2, "%s", combinedHint.c_str());
-    wattroff(contentWin, COLOR_PAIR(6));
-
-    wrefresh(contentWin);
+    lyricsView.present(scrollPosition);
 }
 
-LyricsManager::KeyAction LyricsManager::checkKeypress() {
-    int ch = getch();
-    if (ch == ERR) {
-        return NO_ACTION;
+bool LyricsManager::handleKey(const KeyEvent &event) {
+    if (!ncursesInitialized) {
+        return false;
     }
 
-    KeyAction action = NO_ACTION;
+    bool changed = false;
 
-    switch (ch) {
-        case KEY_UP:
+    switch (event.type) {
+        case KeyEvent::Type::UP:
             if (scrollPosition > 0) {
                 scrollPosition--;
-                action = SCROLL;
+                changed = true;
             }
             break;
-        case KEY_DOWN:
+        case KeyEvent::Type::DOWN:
             if (totalLines > maxVisibleLines && scrollPosition < totalLines - maxVisibleLines) {
                 scrollPosition++;
-                action = SCROLL;
+                changed = true;
             }
             break;
-        case KEY_PPAGE: // Page Up
+        case KeyEvent::Type::PAGE_UP:
             scrollPosition -= maxVisibleLines;
             if (scrollPosition < 0) {
                 scrollPosition = 0;
             }
-            action = SCROLL;
+            changed = true;
             break;
-        case KEY_NPAGE: // Page Down
+        case KeyEvent::Type::PAGE_DOWN:
             scrollPosition += maxVisibleLines;
             if (totalLines > maxVisibleLines && scrollPosition > totalLines - maxVisibleLines) {
                 scrollPosition = totalLines - maxVisibleLines;
             }
-            action = SCROLL;
+            changed = true;
             break;
-        case 'a':
-            manualScrollMode = !manualScrollMode;
-            if (!manualScrollMode) {
-                scrollPosition = autoScrollPosition;
-            }
-            action = SCROLL;
+        case KeyEvent::Type::RESIZE:
+            handleResize();
+            changed = true;
             break;
-        case 's':
-            Config::getInstance().toggleScrobbling();
-            action = SCROLL;
+        case KeyEvent::Type::CHARACTER:
+            switch (event.character) {
+                case 'a':
+                    manualScrollMode = !manualScrollMode;
+                    if (!manualScrollMode) {
+                        scrollPosition = autoScrollPosition;
+                    }
+                    changed = true;
+                    break;
+                case 's':
+                    Config::getInstance().toggleScrobbling();
+                    changed = true;
+                    break;
+                case 'q':
+                    exit(0);
+                default:
+                    break;
+            }
             break;
-        case 'q':
-            action = QUIT;
-            exit(0);
+        default:
             break;
     }
 
-    return action;
+    if (changed) {
+        forceRedraw = true;
+        hintDirty = true;
+        if (frameRequestHandler) {
+            frameRequestHandler();
+        }
+    }
+    return true;
 }
 
 void LyricsManager::displaySyncedLyrics(double playbackRateValue, double elapsedValue) {
+    TrackManager::TrackState *currentTrack = TrackManager::getInstance().getCurrentTrack();
+    displayFrame(currentTrack ? &currentTrack->syncedLyrics : nullptr, LyricsView::Mode::Synced,
+                 playbackRateValue, elapsedValue);
+}
+
+void LyricsManager::displayPlainLyrics(double playbackRateValue, double elapsedValue) {
+    TrackManager::TrackState *currentTrack = TrackManager::getInstance().getCurrentTrack();
+    displayFrame(currentTrack ? &currentTrack->plainLyrics : nullptr, LyricsView::Mode::Plain,
+                 playbackRateValue, elapsedValue);
+}
+
+void LyricsManager::displayWithoutLyrics(double playbackRateValue, double elapsedValue) {
+    displayFrame(nullptr, LyricsView::Mode::Plain, playbackRateValue, elapsedValue);
+}
+
+void LyricsManager::displayFrame(const LyricTimeline *lyrics, LyricsView::Mode mode,
+                                 double playbackRateValue, double elapsedValue) {
     auto &config = Config::getInstance();
     TrackManager::TrackState *currentTrack = TrackManager::getInstance().getCurrentTrack();
 
@@ -389,85 +501,93 @@ void LyricsManager::displaySyncedLyrics(double playbackRateValue, double elapsed
         return;
     }
 
-    if (playbackRateValue > 0.0) {
-        if (!ncursesInitialized) {
-            initNcurses();
-        }
-
-        int currentTimeMs = static_cast<int>(elapsedValue * 1000);
-        int newLyricIndex = -1;
-
-        size_t left = 0;
-        size_t right = currentTrack->parsedSyncedLyrics.size() - 1;
-
-        while (left <= right) {
-            size_t mid = (left + right) / 2;
-            int timeStamp = currentTrack->parsedSyncedLyrics[mid].first;
+    if (!ncursesInitialized) {
+        initNcurses();
+    }
 
-            if (timeStamp <= currentTimeMs) {
-                newLyricIndex = mid;
-                left = mid + 1;
-            } else {
-                if (mid == 0) break;
-                right = mid - 1;
-            }
+    ViewState state = playbackRateValue > 0.0 ? PLAYING : PAUSED;
+    if (state != viewState) {
+        viewState = state;
+        if (state == PAUSED) {
+            LOG_INFO("⏸️ Paused: " + currentTrack->artist + " - " + currentTrack->title + " [" + currentTrack->album +
+                     "]  (" + std::to_string(currentTrack->duration) + " sec)");
         }
+    }
+
+    bool needRedraw = forceRedraw;
 
-        bool needRedraw = forceRedraw;
+    int newLyricIndex = -1;
+    if (lyrics && mode == LyricsView::Mode::Synced) {
+        int currentTimeMs = static_cast<int>(elapsedValue * 1000);
+        newLyricIndex = lyricCursor.update(*lyrics, currentTimeMs, playbackRateValue);
 
         if (newLyricIndex != currentTrack->currentLyricIndex || newLyricIndex == -1) {
             currentTrack->currentLyricIndex = newLyricIndex;
             needRedraw = true;
         }
+    }
 
-        KeyAction action = checkKeypress();
-        if (action == QUIT) {
-            endNcurses();
-            return;
-        } else if (action == SCROLL) {
-            needRedraw = true;
+    drawHeader(currentTrack->artist, currentTrack->title, elapsedValue, currentTrack->duration);
+    drawStatus();
+
+    if (needRedraw) {
+        if (!lyrics || lyrics->empty()) {
+            lyricsView.clearBody();
+            lyricsView.setHint("No lyrics");
+            lyricsView.present(0);
+            hintDirty = true;
+        } else if (mode == LyricsView::Mode::Synced) {
+            if (newLyricIndex >= 0) {
+                drawSyncedLyrics(*lyrics, newLyricIndex);
+            }
+        } else {
+            drawPlainLyrics(*lyrics);
         }
+        forceRedraw = false;
+    }
 
-        drawHeader(currentTrack->artist, currentTrack->title, elapsedValue, currentTrack->duration);
+    renderTarget->flush();
+}
 
-        if (needRedraw) {
-            if (newLyricIndex >= 0 && !currentTrack->parsedSyncedLyrics.empty()) {
-                drawSyncedLyrics(currentTrack->parsedSyncedLyrics, newLyricIndex);
-            }
-            forceRedraw = false;
+double LyricsManager::nextFrameDelay(double playbackRateValue, double elapsedValue) const {
+    if (playbackRateValue <= 0.0) {
+        return MAX_FRAME_INTERVAL;
+    }
+
+    // The header clock changes on every whole second of media time
+    double untilChange = std::ceil(elapsedValue + 0.001) - elapsedValue;
+
+    TrackManager::TrackState *currentTrack = TrackManager::getInstance().getCurrentTrack();
+    if (currentTrack && currentTrack->hasSyncedLyrics) {
+        int32_t untilNextLineMs = lyricCursor.msUntilNextLine(currentTrack->syncedLyrics,
+                                                              static_cast<int32_t>(elapsedValue * 1000));
+        if (untilNextLineMs >= 0) {
+            untilChange = std::min(untilChange, (untilNextLineMs + 1) / 1000.0);
         }
-    } else if (ncursesInitialized) {
-        endNcurses();
-        LOG_INFO("⏸️ Paused: " + currentTrack->artist + " - " + currentTrack->title + " [" + currentTrack->album +
-                 "]  (" + std::to_string(currentTrack->duration) + " sec)");
     }
+
+    return std::clamp(untilChange / playbackRateValue, MIN_FRAME_INTERVAL, MAX_FRAME_INTERVAL);
 }
 
 void LyricsManager::clearLyricsArea() {
-    if (ncursesInitialized) {
-        endNcurses();
-    }
-    forceRedraw = false;
+    lyricCursor.reset();
+    lyricsView.clearBody();
+    forceRedraw = true;
 }
 
 void LyricsManager::forceRefreshLyrics() {
     forceRedraw = true;
+    hintDirty = true;
+    lyricCursor.reset();
+    // Reloads the body; layouts are keyed on the timeline's generation, so ones for the same lyrics survive
+    lyricsView.invalidate();
 
     if (ncursesInitialized) {
         scrollPosition = 0;
     }
 }
 
-void LyricsManager::drawPlainLyrics(const std::vector<std::string> &lyrics) {
-    werase(contentWin);
-
-    int height, width;
-    getmaxyx(contentWin, height, width);
-
-    wattron(contentWin, COLOR_PAIR(3));
-    box(contentWin, 0, 0);
-    wattroff(contentWin, COLOR_PAIR(3));
-
+void LyricsManager::drawPlainLyrics(const LyricTimeline &lyrics) {
     totalLines = lyrics.size();
 
     if (scrollPosition < 0) {
@@ -476,99 +596,35 @@ void LyricsManager::drawPlainLyrics(const std::vector<std::string> &lyrics) {
         scrollPosition = totalLines - maxVisibleLines;
     }
 
-    int displayedLines = 0;
-    for (int i = scrollPosition; i < totalLines && displayedLines < maxVisibleLines; i++) {
-        std::string line = lyrics[i];
-        line = truncateText(line, width - 6);
-
-        wattron(contentWin, COLOR_PAIR(3) | A_BOLD);
-        mvwprintw(contentWin, displayedLines + 1, 3, "%s", line.c_str());
-        wattroff(contentWin, COLOR_PAIR(3) | A_BOLD);
-
-        displayedLines++;
-    }
-
-    if (totalLines > maxVisibleLines) {
-        wattron(contentWin, COLOR_PAIR(6));
-        if (scrollPosition > 0) {
-            mvwaddch(contentWin, 0, width / 2, ACS_UARROW);
-        }
-        if (scrollPosition + maxVisibleLines < totalLines) {
-            mvwaddch(contentWin, height - 1, width / 2, ACS_DARROW);
-        }
-        wattroff(contentWin, COLOR_PAIR(6));
-    }
-
-    std::string scrollHint = "Use arrow keys to scroll";
-    std::string scrobblingHint = Config::getInstance().isScrobblingEnabled() ? 
-                              "[Scrobbling On] 's':toggle" : 
-                              "[Scrobbling Off] 's':toggle";
-    
-    std::string combinedHint = scrollHint + " | " + scrobblingHint;
-    
-    if (combinedHint.length() > width - 4) {
-        scrobblingHint = Config::getInstance().isScrobblingEnabled() ? "[S:On]" : "[S:Off]";
-        combinedHint = scrollHint + " | " + scrobblingHint + " 's':toggle";
-        
-        if (combinedHint.length() > width - 4) {
-            combinedHint = "↑↓:scroll | " + std::string(Config::getInstance().isScrobblingEnabled() ? "[S+]" : "[S-]");
-        }
-    }
-
-    wattron(contentWin, COLOR_PAIR(6));
-    mvwprintw(contentWin, height - 1, (width - combinedHint.length()) / 2, "%s", combinedHint.c_str());
-    wattroff(contentWin, COLOR_PAIR(6));
+    lyricsView.load(lyrics, LyricsView::Mode::Plain);
 
-    wrefresh(contentWin);
-}
-
-void LyricsManager::displayPlainLyrics(double playbackRateValue, double elapsedValue) {
-    auto &config = Config::getInstance();
-    TrackManager::TrackState *currentTrack = TrackManager::getInstance().getCurrentTrack();
-
-    if (!config.isShowLyrics() || !currentTrack) {
-        if (ncursesInitialized) {
-            endNcurses();
-        }
-        return;
-    }
-
-    if (playbackRateValue > 0.0) {
-        if (!ncursesInitialized) {
-            initNcurses();
-        }
+    if (hintDirty) {
+        int width = lyricsView.getWidth();
+        std::string scrollHint = "Use arrow keys to scroll";
+        std::string scrobblingHint = Config::getInstance().isScrobblingEnabled() ?
+                                     "[Scrobbling On] 's':toggle" :
+                                     "[Scrobbling Off] 's':toggle";
 
-        bool needRedraw = forceRedraw;
+        std::string combinedHint = scrollHint + " | " + scrobblingHint;
 
-        KeyAction action = checkKeypress();
-        if (action == QUIT) {
-            endNcurses();
-            return;
-        } else if (action == SCROLL) {
-            needRedraw = true;
-        }
+        if (Unicode::displayWidth(combinedHint) > width - 4) {
+            scrobblingHint = Config::getInstance().isScrobblingEnabled() ? "[S:On]" : "[S:Off]";
+            combinedHint = scrollHint + " | " + scrobblingHint + " 's':toggle";
 
-        drawHeader(currentTrack->artist, currentTrack->title, elapsedValue, currentTrack->duration);
-
-        if (needRedraw) {
-            if (!currentTrack->parsedPlainLyrics.empty()) {
-                drawPlainLyrics(currentTrack->parsedPlainLyrics);
+            if (Unicode::displayWidth(combinedHint) > width - 4) {
+                combinedHint = "↑↓:scroll | " + std::string(Config::getInstance().isScrobblingEnabled() ? "[S+]" : "[S-]");
             }
-            forceRedraw = false;
         }
-    } else if (ncursesInitialized) {
-        endNcurses();
-        LOG_INFO("⏸️ Paused: " + currentTrack->artist + " - " + currentTrack->title + " [" + currentTrack->album +
-                 "]  (" + std::to_string(currentTrack->duration) + " sec)");
+        lyricsView.setHint(combinedHint);
+        hintDirty = false;
     }
+
+    lyricsView.present(scrollPosition);
 }
 
 void LyricsManager::parsePlainLyrics(const std::string &lyrics) {
     TrackManager::TrackState *currentTrack = TrackManager::getInstance().getCurrentTrack();
-    std::istringstream stream(lyrics);
-    std::string line;
+    if (!currentTrack) return;
 
-    while (std::getline(stream, line)) {
-        currentTrack->parsedPlainLyrics.push_back(line);
-    }
-}
\ No newline at end of file
+    currentTrack->plainLyrics = LyricTimeline::fromPlain(lyrics);
+}
@@ -0,0 +1,189 @@
+#include "include/LyricsView.h"
+#include "include/Unicode.h"
+#include <algorithm>
+
+namespace {
+    constexpr int UP_ARROW = 1;
+    constexpr int DOWN_ARROW = 2;
+
+    constexpr Surface::Style TEXT_STYLE{3, false};
+    constexpr Surface::Style PASSED_STYLE{3, true};
+    constexpr Surface::Style CURRENT_STYLE{4, true};
+    constexpr Surface::Style HINT_STYLE{6, false};
+}
+
+void LyricsView::attach(RenderTarget &renderTarget, Surface &frameSurface) {
+    detach();
+    target = &renderTarget;
+    frame = &frameSurface;
+    invalidate();
+}
+
+void LyricsView::detach() {
+    pad.reset();
+    target = nullptr;
+    frame = nullptr;
+    lyrics = nullptr;
+    layout.clear();
+}
+
+void LyricsView::invalidate() {
+    lyrics = nullptr;
+    loadedSize = 0;
+    loadedGeneration = 0;
+    current = -1;
+    paintedTop = -1;
+    frameDirty = true;
+}
+
+void LyricsView::clearBody() {
+    pad.reset();
+    layout.clear();
+    invalidate();
+}
+
+void LyricsView::load(const LyricTimeline &body, Mode newMode) {
+    if (!frame) return;
+
+    int width = frame->getCols();
+    if (lyrics == &body && loadedGeneration == body.getGeneration() && loadedWidth == width && mode == newMode) {
+        return;
+    }
+
+    // Blank rows after the last line let the viewport scroll past the end without stale rows
+    int rows = static_cast<int>(body.size()) + getVisibleRows();
+    pad = target->createPad(std::max(rows, 1), std::max(width - 2, 1));
+
+    lyrics = &body;
+    loadedSize = body.size();
+    loadedGeneration = body.getGeneration();
+    loadedWidth = width;
+    mode = newMode;
+    current = -1;
+    paintedTop = -1;
+    frameDirty = true;
+    if (!layout.matches(body, width - 6)) {
+        layout.build(body, width - 6);
+    }
+
+    if (!pad) return;
+    for (int i = 0; i < static_cast<int>(loadedSize); i++) {
+        drawLine(i);
+    }
+}
+
+void LyricsView::setCurrent(int index) {
+    if (index == current) return;
+
+    int previous = current;
+    current = index;
+    if (!pad || !lyrics || mode != Mode::Synced) return;
+
+    // Lines between the two positions switch between passed and upcoming
+    int from = std::max(std::min(previous, index), 0);
+    int to = std::min(std::max(previous, index), static_cast<int>(loadedSize) - 1);
+    for (int i = from; i <= to; i++) {
+        drawLine(i);
+    }
+}
+
+void LyricsView::setHint(const std::string &newHint) {
+    if (newHint != hint) {
+        hint = newHint;
+        bordersDirty = true;
+    }
+}
+
+void LyricsView::drawLine(int index) {
+    std::string_view text = layout.textAt(index);
+    pad->clearToEol(index, 0);
+
+    Surface::Style style = TEXT_STYLE;
+    int column = 1;
+    if (mode == Mode::Plain) {
+        style = PASSED_STYLE;
+        column = 2;
+    } else if (index == current) {
+        style = CURRENT_STYLE;
+        column = pad->drawText(index, column, ">", style);
+    } else {
+        if (index < current) {
+            style = PASSED_STYLE;
+        }
+        column = pad->drawText(index, column, " ", style);
+    }
+
+    column = pad->drawText(index, column, text, style);
+    if (layout.isTruncated(index)) {
+        pad->drawText(index, column, LineLayout::ELLIPSIS, style);
+    }
+    padDirty = true;
+}
+
+void LyricsView::drawBorderRows() {
+    int height = frame->getRows();
+    int width = frame->getCols();
+
+    frame->drawGlyph(0, 1, Surface::Glyph::HorizontalLine, TEXT_STYLE, width - 2);
+    frame->drawGlyph(height - 1, 1, Surface::Glyph::HorizontalLine, TEXT_STYLE, width - 2);
+
+    if (arrows & UP_ARROW) {
+        frame->drawGlyph(0, width / 2, Surface::Glyph::UpArrow, HINT_STYLE);
+    }
+    if (arrows & DOWN_ARROW) {
+        frame->drawGlyph(height - 1, width / 2, Surface::Glyph::DownArrow, HINT_STYLE);
+    }
+    frame->drawText(height - 1, std::max((width - Unicode::displayWidth(hint)) / 2, 1), hint, HINT_STYLE);
+}
+
+void LyricsView::present(int top) {
+    if (!frame) return;
+
+    int width = frame->getCols();
+    int rows = getVisibleRows();
+    int total = static_cast<int>(loadedSize);
+
+    int newArrows = 0;
+    if (total > rows) {
+        if (top > 0) newArrows |= UP_ARROW;
+        if (top + rows < total) newArrows |= DOWN_ARROW;
+    }
+    if (newArrows != arrows) {
+        arrows = newArrows;
+        bordersDirty = true;
+    }
+
+    if (frameDirty) {
+        frame->erase();
+        frame->drawBox(TEXT_STYLE);
+        drawBorderRows();
+        frame->stage();
+        frameDirty = false;
+        bordersDirty = false;
+        // Staging the frame blanked the interior, so the whole viewport must be copied again
+        paintedTop = -1;
+    } else if (bordersDirty) {
+        drawBorderRows();
+        frame->stage();
+        bordersDirty = false;
+    }
+
+    if (pad && (top != paintedTop || padDirty)) {
+        if (top != paintedTop) {
+            pad->touch();
+        }
+        int originY = frame->getOriginY() + 1;
+        int originX = frame->getOriginX() + 1;
+        pad->stageRegion(std::max(top, 0), 0, originY, originX, originY + rows - 1, originX + width - 3);
+        paintedTop = top;
+        padDirty = false;
+    }
+}
+
+int LyricsView::getVisibleRows() const {
+    return frame ? std::max(frame->getRows() - 2, 0) : 0;
+}
+
+int LyricsView::getWidth() const {
+    return frame ? frame->getCols() : 0;
+}
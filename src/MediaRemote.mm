@@ -7,6 +7,13 @@
 #include <include/Helper.h>
 #include<include/TrackManager.h>
 #import "include/LyricsManager.h"
+#include "include/EventLoop.h"
+#include "include/Clock.h"
+#include "include/MetadataDebouncer.h"
+#include "include/PlaybackSchedule.h"
+#include "include/Prefetcher.h"
+#include "include/WorkQueue.h"
+#include <atomic>
 
 typedef void (*MRMediaRemoteGetNowPlayingInfo_t)(dispatch_queue_t, void(^)(CFDictionaryRef));
 
@@ -14,14 +21,32 @@ class MediaRemote::Impl {
 public:
     void *handle = nullptr;
     MRMediaRemoteGetNowPlayingInfo_t MRMediaRemoteGetNowPlayingInfo = nullptr;
-    dispatch_source_t playbackTimer = nullptr;
-    dispatch_source_t lyricsTimer = nullptr;
+    EventLoop &eventLoop = EventLoop::getInstance();
+    EventLoop::TimerId playbackTimer = 0;
+    EventLoop::TimerId lyricsTimer = 0;
+    EventLoop::TimerId settleTimer = 0;
+    MetadataDebouncer metadataDebouncer{Config::getInstance().getMetadataSettleMs()};
     LastFmScrobbler &scrobbler = LastFmScrobbler::getInstance();
     TrackManager &trackManager = TrackManager::getInstance();
     std::mutex mediaRemoteMutex;
     bool isInitialized = false;
+    MediaRemote::InfoSource infoSource;
+    MediaRemote::UpNextSource upNextSource;
+    // Up Next queries for each title change, one at a time; only the latest one still matters
+    WorkQueue upNextWorker;
+    std::atomic<uint64_t> upNextRequest{0};
+
+    Impl(MediaRemote::InfoSource source, MediaRemote::UpNextSource upNext)
+            : infoSource(std::move(source)), upNextSource(std::move(upNext)) {
+        // Apple Music's queue only matches what MediaRemote.framework reports
+        if (!upNextSource && !infoSource) {
+            upNextSource = Helper::getAppleMusicUpNext;
+        }
+        if (infoSource) {
+            isInitialized = true;
+            return;
+        }
 
-    Impl() {
         handle = dlopen("/System/Library/PrivateFrameworks/MediaRemote.framework/MediaRemote", RTLD_LAZY);
         if (!handle) {
             LOG_ERROR("Failed to load MediaRemote.framework");
@@ -39,15 +64,18 @@ public:
     }
 
     ~Impl() {
+        upNextWorker.stop();
         if (playbackTimer) {
-            dispatch_source_cancel(playbackTimer);
-            dispatch_release(playbackTimer);
-            playbackTimer = nullptr;
+            eventLoop.destroyTimer(playbackTimer);
+            playbackTimer = 0;
         }
         if (lyricsTimer) {
-            dispatch_source_cancel(lyricsTimer);
-            dispatch_release(lyricsTimer);
-            lyricsTimer = nullptr;
+            eventLoop.destroyTimer(lyricsTimer);
+            lyricsTimer = 0;
+        }
+        if (settleTimer) {
+            eventLoop.destroyTimer(settleTimer);
+            settleTimer = 0;
         }
         if (handle) {
             dlclose(handle);
@@ -64,45 +92,34 @@ public:
         LOG_INFO("Listening for Now Playing changes");
         
         // 创建播放状态检查定时器
-        playbackTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
-        if (!playbackTimer) {
-            LOG_ERROR("Failed to create dispatch timer");
-            return;
-        }
-        
-        dispatch_source_set_timer(playbackTimer, 
-                                dispatch_time(DISPATCH_TIME_NOW, 0), 
-                                NSEC_PER_SEC, 
-                                NSEC_PER_SEC / 10);
-        
-        dispatch_source_set_event_handler(playbackTimer, ^{
+        playbackTimer = eventLoop.createTimer([this] {
+            @autoreleasepool {
+                fetchNowPlayingInfo();
+            }
+        });
+        // Aligned to whole poll periods so idle lyrics frames can share its wakeup
+        PlaybackSchedule::armPoll(eventLoop, playbackTimer);
+
+        // Extra poll at the end of a metadata settle window, so a real change is not held back to the next tick
+        settleTimer = eventLoop.createTimer([this] {
             @autoreleasepool {
                 fetchNowPlayingInfo();
             }
         });
-        
-        dispatch_resume(playbackTimer);
 
         // 创建歌词显示定时器
-        lyricsTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
-        if (!lyricsTimer) {
-            LOG_ERROR("Failed to create lyrics timer");
-            return;
-        }
-        
-        dispatch_source_set_timer(lyricsTimer,
-                                dispatch_time(DISPATCH_TIME_NOW, 0),
-                                0.05 * NSEC_PER_SEC,
-                                0.05 * NSEC_PER_SEC / 10);
-        
-        dispatch_source_set_event_handler(lyricsTimer, ^{
+        // One-shot timer, re-armed after each frame for when the display next changes
+        lyricsTimer = eventLoop.createTimer([this] {
             @autoreleasepool {
                 auto &lyricsManager = LyricsManager::getInstance();
                 auto &config = Config::getInstance();
                 auto *currentTrack = trackManager.getCurrentTrack();
-                if (!currentTrack) return;
+                if (!currentTrack) {
+                    scheduleLyricsFrame(LyricsManager::MAX_FRAME_INTERVAL);
+                    return;
+                }
 
-                double now = CFAbsoluteTimeGetCurrent();
+                double now = Clock::getInstance().nowSeconds();
                 double interpolatedTime = currentTrack->lastElapsed;
 
                 if (currentTrack->lastPlaybackRate > 0.0) {
@@ -120,15 +137,33 @@ public:
                                 currentTrack->lastPlaybackRate,
                                 interpolatedTime
                         );
+                    } else {
+                        lyricsManager.displayWithoutLyrics(
+                                currentTrack->lastPlaybackRate,
+                                interpolatedTime
+                        );
                     }
                 }
+
+                scheduleLyricsFrame(lyricsManager.nextFrameDelay(currentTrack->lastPlaybackRate,
+                                                                 interpolatedTime));
             }
         });
-        
-        dispatch_resume(lyricsTimer);
+        eventLoop.schedule(lyricsTimer, 0);
+
+        LyricsManager::getInstance().setFrameRequestHandler([this] { scheduleLyricsFrame(0); });
+    }
+
+    void scheduleLyricsFrame(double delaySeconds) {
+        if (!lyricsTimer) return;
+        PlaybackSchedule::armFrame(eventLoop, lyricsTimer, delaySeconds);
     }
 
     void fetchNowPlayingInfo() {
+        if (infoSource) {
+            infoSource([this](CFDictionaryRef info) { receiveNowPlayingInfo(info); });
+            return;
+        }
         if (!MRMediaRemoteGetNowPlayingInfo) {
             LOG_ERROR("MediaRemote function not available");
             return;
@@ -136,30 +171,7 @@ public:
 
         @autoreleasepool {
             void (^callback)(CFDictionaryRef) = ^(CFDictionaryRef info) {
-                if (!info) {
-                    LOG_DEBUG("No Now Playing info available");
-                    return;
-                }
-
-                @autoreleasepool {
-                    @try {
-                        LOG_DEBUG("Received Now Playing info, creating copy");
-                        CFDictionaryRef infoCopy = CFDictionaryCreateCopy(kCFAllocatorDefault, info);
-                        if (!infoCopy) {
-                            LOG_ERROR("Failed to create info dictionary copy");
-                            return;
-                        }
-
-                        LOG_DEBUG("Processing Now Playing info");
-                        processNowPlayingInfo(infoCopy);
-                        LOG_DEBUG("Finished processing Now Playing info");
-                        
-                        CFRelease(infoCopy);
-                        LOG_DEBUG("Released info dictionary copy");
-                    } @catch (NSException *exception) {
-                        LOG_ERROR("Exception in processNowPlayingInfo: " + std::string([[exception description] UTF8String]));
-                    }
-                }
+                receiveNowPlayingInfo(info);
             };
 
             LOG_DEBUG("Creating callback block copy");
@@ -176,6 +188,59 @@ public:
         }
     }
 
+    void receiveNowPlayingInfo(CFDictionaryRef info) {
+        if (!info) {
+            LOG_DEBUG("No Now Playing info available");
+            return;
+        }
+
+        @autoreleasepool {
+            @try {
+                LOG_DEBUG("Received Now Playing info, creating copy");
+                CFDictionaryRef infoCopy = CFDictionaryCreateCopy(kCFAllocatorDefault, info);
+                if (!infoCopy) {
+                    LOG_ERROR("Failed to create info dictionary copy");
+                    return;
+                }
+
+                LOG_DEBUG("Processing Now Playing info");
+                processNowPlayingInfo(infoCopy);
+                LOG_DEBUG("Finished processing Now Playing info");
+                
+                CFRelease(infoCopy);
+                LOG_DEBUG("Released info dictionary copy");
+            } @catch (NSException *exception) {
+                LOG_ERROR("Exception in processNowPlayingInfo: " + std::string([[exception description] UTF8String]));
+            }
+        }
+    }
+
+    // Apple Music is the one source that says what plays next. osascript is slow, so ask from the worker;
+    // a query still queued when the title changes again is skipped rather than run for a track already gone
+    void hintUpcomingTracks(const std::string &title) {
+        int ahead = Config::getInstance().getPrefetchAhead();
+        if (ahead <= 0 || !upNextSource) return;
+
+        uint64_t request = ++upNextRequest;
+        upNextWorker.post([this, title, ahead, request] {
+            if (request != upNextRequest.load()) return;
+            std::vector<Prefetcher::Hint> upcoming = upNextSource(title, ahead);
+            if (request != upNextRequest.load()) return;
+            EventLoop::getInstance().post([upcoming = std::move(upcoming)] {
+                Prefetcher::getInstance().hintUpcoming(upcoming);
+            });
+        });
+    }
+
+    static void logPrefetchCounters() {
+        const Prefetcher &prefetcher = Prefetcher::getInstance();
+        LOG_DEBUG("Prefetch: " + std::to_string(prefetcher.getStartedCount()) + " started, " +
+                  std::to_string(prefetcher.getCancelledCount()) + " cancelled, " +
+                  std::to_string(prefetcher.getHitCount()) + " hits, " +
+                  std::to_string(prefetcher.getWastedCount()) + " wasted (" +
+                  std::to_string(static_cast<int>(prefetcher.getHitRate() * 100.0)) + "% hit rate)");
+    }
+
     void processNowPlayingInfo(CFDictionaryRef info) {
         if (!info) {
             LOG_ERROR("Invalid info dictionary");
@@ -200,29 +265,43 @@ public:
                      "', Last artist: '" + lastArtist + "'");
 
             std::string artist, title, album;
-            double durationValue = currentTrack->duration;
+            double durationValue = 0.0;
             double elapsedValue = currentTrack->lastElapsed;
             double reportedElapsed = 0.0;
             double playbackRateValue = 0.0;
 
             @try {
-                Helper::extractMetadata(info, artist, title, album, currentTrack->duration, playbackRateValue);
-                if (artist.empty() && title.empty() && album.empty()) {
-                    LOG_DEBUG("No metadata available in info dictionary");
-                    handleFlushedMetadata(artist, title, album);
-                }
+                Helper::extractMetadata(info, artist, title, album, durationValue, playbackRateValue);
 
                 LOG_DEBUG("Extracted metadata - Artist: '" + artist + 
                          "', Title: '" + title + 
                          "', Album: '" + album + 
-                         "', Duration: " + std::to_string(currentTrack->duration) +
+                         "', Duration: " + std::to_string(durationValue) +
                          ", Playback rate: " + std::to_string(playbackRateValue));
 
+                // Transitional dictionaries must not reach TrackManager: a half-switched track would be resolved,
+                // fetched lyrics for, or mistaken for the old one restarting
+                bool flushed = title.empty();
+                MetadataDebouncer::Verdict verdict = metadataDebouncer.observe({artist, title, album});
+                if (verdict == MetadataDebouncer::Verdict::SETTLING) {
+                    LOG_DEBUG("Metadata settling, checking again in " +
+                              std::to_string(metadataDebouncer.msUntilSettled()) + " ms");
+                    eventLoop.schedule(settleTimer, metadataDebouncer.msUntilSettled() + 1);
+                    return;
+                }
+                if (flushed) {
+                    LOG_DEBUG("No title in info dictionary, keeping current track");
+                }
+                const MetadataDebouncer::Metadata &settled = metadataDebouncer.getCommitted();
+                artist = settled.artist;
+                title = settled.title;
+                album = settled.album;
+
                 bool isFromMusicPlatform = !artist.empty() && !title.empty() && !album.empty();
                 trackManager.setFromMusicPlatform(isFromMusicPlatform);
                 LOG_DEBUG("Is from music platform: " + std::to_string(isFromMusicPlatform));
 
-                if (!title.empty() && title != lastTitle) {
+                if (verdict == MetadataDebouncer::Verdict::CHANGED && title != lastTitle) {
                     LOG_DEBUG("Title changed, processing title change");
                     trackManager.processTitleChange(artist, title, album, playbackRateValue);
                     currentTrack = trackManager.getCurrentTrack();
@@ -230,8 +309,15 @@ public:
                         LOG_ERROR("Failed to get current track after title change");
                         return;
                     }
+                    logPrefetchCounters();
+                    if (isFromMusicPlatform) {
+                        hintUpcomingTracks(title);
+                    }
                 }
 
+                if (!flushed) {
+                    currentTrack->duration = durationValue;
+                }
                 currentTrack->lastPlaybackRate = playbackRateValue;
                 LOG_DEBUG("Updated playback rate: " + std::to_string(playbackRateValue));
 
@@ -242,14 +328,18 @@ public:
                 LOG_DEBUG("Updated elapsed time - Reported: " + std::to_string(reportedElapsed) +
                          ", Current: " + std::to_string(currentTrack->lastElapsed));
 
-                if (currentTrack->isMusic && playbackRateValue > 0.0) {
-                    LOG_DEBUG("Sending Now Playing update");
-                    scrobbler.sendNowPlayingUpdate(currentTrack->extractArtist,
-                                                  currentTrack->extractTitle,
-                                                  currentTrack->isMusic, album,
-                                                  currentTrack->lastNowPlayingSent,
-                                                  playbackRateValue);
-                }
+                // Every poll is reported, pauses included, so the policy can tell a resume from a steady play
+                NowPlayingPolicy::Observation observation;
+                observation.artist = currentTrack->extractArtist;
+                observation.title = currentTrack->extractTitle;
+                observation.album = album;
+                observation.isMusic = currentTrack->isMusic;
+                observation.playbackRate = playbackRateValue;
+                observation.elapsed = elapsedValue;
+                observation.duration = currentTrack->duration;
+                observation.scrobbleSettled = scrobbler.hasScrobbled(currentTrack->artist, currentTrack->title,
+                                                                      currentTrack->scrobbleTracker.getStartedAt());
+                scrobbler.updateNowPlaying(observation);
 
                 LOG_DEBUG("Handling playback state change");
                 trackManager.handlePlaybackStateChange(playbackRateValue, elapsedValue);
@@ -261,30 +351,12 @@ public:
             }
         }
     }
-
-    void handleFlushedMetadata(std::string &artist, std::string &title, std::string &album) const {
-        auto *currentTrack = trackManager.getCurrentTrack();
-        if (!currentTrack) {
-            return;
-        }
-
-        const std::string &lastArtist = trackManager.getLastArtist();
-        const std::string &lastTitle = trackManager.getLastTitle();
-        const std::string &lastAlbum = trackManager.getLastAlbum();
-
-        if (artist.empty() && title.empty() && !lastTitle.empty()) {
-            // Metadata was flushed, using cached values
-            artist = lastArtist;
-            title = lastTitle;
-            album = lastAlbum;
-        }
-    }
 };
 
 #pragma mark - MediaRemoteBridge
 
-MediaRemote::MediaRemote()
-        : impl(new Impl) {
+MediaRemote::MediaRemote(InfoSource source, UpNextSource upNext)
+        : impl(new Impl(std::move(source), std::move(upNext))) {
 }
 
 MediaRemote::~MediaRemote() {
@@ -293,4 +365,12 @@ MediaRemote::~MediaRemote() {
 
 void MediaRemote::registerForNowPlayingNotifications() {
     if (impl) impl->registerTimer();
+}
+
+void MediaRemote::poll() {
+    if (impl) impl->fetchNowPlayingInfo();
+}
+
+const MetadataDebouncer &MediaRemote::getMetadataDebouncer() const {
+    return impl->metadataDebouncer;
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "include/MetadataDebouncer.h"
+#include "include/Logger.h"
+#include <algorithm>
+
+MetadataDebouncer::Verdict MetadataDebouncer::observe(const Metadata &incoming) {
+    if (incoming.title.empty()) {
+        flushedCount++;
+        return settling ? Verdict::SETTLING : Verdict::UNCHANGED;
+    }
+
+    // Nothing to protect yet, so the first track goes straight through
+    if (!hasCommitted) {
+        return commit(incoming);
+    }
+
+    if (incoming == committed) {
+        if (settling) {
+            LOG_DEBUG("Metadata flipped back before settling, ignoring: " + candidate.artist + " - " + candidate.title);
+            settling = false;
+            suppressedCount++;
+        }
+        return Verdict::UNCHANGED;
+    }
+
+    int64_t now = clock.nowMs();
+    if (!settling || incoming != candidate) {
+        if (settling) {
+            LOG_DEBUG("Metadata changed again before settling, ignoring: " + candidate.artist + " - " + candidate.title);
+            suppressedCount++;
+        }
+        candidate = incoming;
+        candidateSinceMs = now;
+        settling = true;
+    }
+
+    if (now - candidateSinceMs >= settleMs) {
+        return commit(candidate);
+    }
+    return Verdict::SETTLING;
+}
+
+MetadataDebouncer::Verdict MetadataDebouncer::commit(const Metadata &metadata) {
+    committed = metadata;
+    hasCommitted = true;
+    settling = false;
+    commitCount++;
+    return Verdict::CHANGED;
+}
+
+int64_t MetadataDebouncer::msUntilSettled() const {
+    if (!settling) {
+        return 0;
+    }
+    return std::max<int64_t>(candidateSinceMs + settleMs - clock.nowMs(), 0);
+}
@@ -0,0 +1,67 @@
+#include "include/NowPlayingPolicy.h"
+
+NowPlayingPolicy::Decision NowPlayingPolicy::observe(const Observation &observation) {
+    bool playing = observation.playbackRate > 0.0;
+    bool resumed = playing && !wasPlaying;
+    bool restarted = observation.elapsed + RESTART_JUMP_S < lastElapsed;
+    wasPlaying = playing;
+    lastElapsed = observation.elapsed;
+
+    if (!observation.isMusic || !playing || observation.scrobbleSettled) {
+        skippedCount++;
+        return Decision::SKIP;
+    }
+
+    std::string key = observation.artist + '\n' + observation.title + '\n' + observation.album;
+    double now = clock.nowSeconds();
+
+    Decision decision = Decision::SKIP;
+    if (key != sentKey) {
+        decision = Decision::TRACK_CHANGED;
+    } else if (restarted) {
+        decision = Decision::RESTARTED;
+    } else if (resumed) {
+        decision = Decision::RESUMED;
+    } else if (now >= expiresAt - EXPIRY_MARGIN_S && outlivesStatus(observation, now)) {
+        decision = Decision::REFRESH;
+    }
+
+    if (decision == Decision::SKIP) {
+        skippedCount++;
+        return decision;
+    }
+
+    sentKey = std::move(key);
+    expiresAt = now + (observation.duration > 0.0 ? observation.duration : UNKNOWN_DURATION_TTL_S);
+    sentCount++;
+    return decision;
+}
+
+bool NowPlayingPolicy::outlivesStatus(const Observation &observation, double now) const {
+    if (observation.duration <= 0.0) {
+        return true;
+    }
+    // Played straight through, a track ends exactly when the status sent at its start lapses
+    double remaining = (observation.duration - observation.elapsed) / observation.playbackRate;
+    return now + remaining > expiresAt;
+}
+
+void NowPlayingPolicy::onSendFailed() {
+    expiresAt = clock.nowSeconds() + FAILURE_RETRY_S + EXPIRY_MARGIN_S;
+}
+
+const char *NowPlayingPolicy::describe(Decision decision) {
+    switch (decision) {
+        case Decision::SKIP:
+            return "skip";
+        case Decision::TRACK_CHANGED:
+            return "track changed";
+        case Decision::RESTARTED:
+            return "track restarted";
+        case Decision::RESUMED:
+            return "playback resumed";
+        case Decision::REFRESH:
+            return "refresh before expiry";
+    }
+    return "";
+}
@@ -0,0 +1,14 @@
+#include "include/PlaybackSchedule.h"
+
+void PlaybackSchedule::armPoll(EventLoop &loop, EventLoop::TimerId poll) {
+    loop.schedule(poll, 0, PLAYBACK_POLL_MS, PLAYBACK_POLL_MS);
+}
+
+void PlaybackSchedule::armFrame(EventLoop &loop, EventLoop::TimerId frame, double delaySeconds) {
+    if (delaySeconds >= MAX_FRAME_INTERVAL) {
+        loop.schedule(frame, 1, 0, PLAYBACK_POLL_MS);
+        return;
+    }
+    loop.schedule(frame, static_cast<int64_t>(delaySeconds * 1000), 0,
+                  static_cast<int64_t>(MIN_FRAME_INTERVAL * 1000 / 2));
+}
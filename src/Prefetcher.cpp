@@ -0,0 +1,82 @@
+#include "include/Prefetcher.h"
+#include "include/Config.h"
+#include "include/Logger.h"
+#include <algorithm>
+
+Prefetcher::Prefetcher(EventLoop &loop, Identify identify, Warm warm)
+        : loop(loop), identify(std::move(identify)), warm(std::move(warm)) {
+}
+
+Prefetcher::~Prefetcher() {
+    for (const Job &job: jobs) {
+        job.cancel.cancel();
+    }
+    workers.stop();
+}
+
+void Prefetcher::hintUpcoming(const std::vector<Hint> &upcoming) {
+    int ahead = Config::getInstance().getPrefetchAhead();
+    std::vector<Job> next;
+
+    for (const Hint &hint: upcoming) {
+        if (static_cast<int>(next.size()) >= ahead) break;
+
+        std::string trackId = identify(hint);
+        if (trackId.empty()) continue;
+        auto sameTrack = [&](const Job &job) { return job.trackId == trackId; };
+        if (std::any_of(next.begin(), next.end(), sameTrack)) continue;
+
+        auto it = std::find_if(jobs.begin(), jobs.end(), sameTrack);
+        if (it != jobs.end()) {
+            next.push_back(std::move(*it));
+            jobs.erase(it);
+            continue;
+        }
+
+        Job job;
+        job.id = ++nextJobId;
+        job.trackId = trackId;
+        job.hint = hint;
+        job.cancel = CancellationToken::create();
+        next.push_back(std::move(job));
+    }
+
+    for (const Job &dropped: jobs) {
+        dropped.cancel.cancel();
+        if (dropped.running) {
+            cancelled++;
+            LOG_DEBUG("Cancelled prefetch for: " + dropped.hint.artist + " - " + dropped.hint.title);
+        }
+    }
+    jobs = std::move(next);
+    pump();
+}
+
+void Prefetcher::pump() {
+    for (Job &job: jobs) {
+        // Cancelled jobs still hold their slot until their task finishes
+        if (inFlight >= MAX_IN_FLIGHT) break;
+        if (job.running || job.done) continue;
+
+        job.running = true;
+        inFlight++;
+        started++;
+        LOG_DEBUG("Prefetching: " + job.hint.artist + " - " + job.hint.title);
+        workers.post([this, id = job.id, hint = job.hint, cancel = job.cancel] {
+            if (!cancel.isCancelled()) {
+                warm(hint, cancel);
+            }
+            loop.post([this, id] { finish(id); });
+        });
+    }
+}
+
+void Prefetcher::finish(uint64_t id) {
+    inFlight--;
+    auto it = std::find_if(jobs.begin(), jobs.end(), [id](const Job &job) { return job.id == id; });
+    if (it != jobs.end()) {
+        it->running = false;
+        it->done = true;
+    }
+    pump();
+}
@@ -0,0 +1,58 @@
+#include "include/Prefetcher.h"
+#include "include/Logger.h"
+#include "include/EventLoop.h"
+#include "include/Helper.h"
+#include "include/LyricsManager.h"
+#include "include/TrackManager.h"
+
+namespace {
+    std::string identifyTrack(const Prefetcher::Hint &hint) {
+        std::string trackId = TrackManager::generateTrackId(hint.artist, hint.title, hint.album);
+        // A cached track already has its lyrics
+        if (trackId.empty() || TrackManager::getInstance().isCachedTrak(trackId)) {
+            return {};
+        }
+        return trackId;
+    }
+
+    void warmTrack(const Prefetcher::Hint &hint, const CancellationToken &cancel) {
+        @autoreleasepool {
+            std::string artist = hint.artist;
+            std::string title = hint.title;
+
+            // Same test MediaRemote uses before trusting platform metadata as it is
+            bool complete = !hint.artist.empty() && !hint.title.empty() && !hint.album.empty();
+            if (!complete && !Helper::prefetchMusicInfo(hint.artist, hint.title, hint.album, artist, title, cancel)) {
+                LOG_DEBUG("Nothing to prefetch for: " + hint.artist + " - " + hint.title);
+                return;
+            }
+            if (cancel.isCancelled()) return;
+
+            LyricsManager::getInstance().prefetchLyrics(artist, title, hint.album, cancel);
+        }
+    }
+}
+
+Prefetcher &Prefetcher::getInstance() {
+    // Constructed first so they are destroyed after the pool that warms through them
+    EventLoop &loop = EventLoop::getInstance();
+    TrackManager::getInstance();
+    LyricsManager::getInstance();
+    static Prefetcher instance(loop, identifyTrack, warmTrack);
+    return instance;
+}
+
+uint64_t Prefetcher::getHitCount() const {
+    return LyricsManager::getInstance().getPrefetchedLyricsHits() + Helper::getPrefetchedResolutionHits();
+}
+
+uint64_t Prefetcher::getWastedCount() const {
+    return LyricsManager::getInstance().getPrefetchedLyricsWasted() + Helper::getPrefetchedResolutionWasted() +
+           cancelled.load();
+}
+
+double Prefetcher::getHitRate() const {
+    uint64_t hits = getHitCount();
+    uint64_t total = hits + getWastedCount();
+    return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+}
@@ -0,0 +1,104 @@
+#include "include/RateLimiter.h"
+#include "include/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+RateLimiter::RateLimiter(double ratePerSecond, double burst, Clock &clock)
+        : clock(clock), configuredRate(ratePerSecond), rate(ratePerSecond), burst(burst), tokens(burst),
+          lastRefillMs(clock.nowMs()) {}
+
+void RateLimiter::refill(int64_t now) {
+    if (now > lastRefillMs) {
+        tokens = std::min(burst, tokens + static_cast<double>(now - lastRefillMs) * rate / 1000.0);
+        lastRefillMs = now;
+    }
+}
+
+int64_t RateLimiter::msUntilToken() const {
+    if (tokens >= 1.0) {
+        return 0;
+    }
+    return static_cast<int64_t>(std::ceil((1.0 - tokens) * 1000.0 / rate));
+}
+
+void RateLimiter::grant() {
+    refill(clock.nowMs());
+    bool grantedAny = false;
+    for (auto &queue : queues) {
+        while (!queue.empty() && tokens >= 1.0) {
+            tokens -= 1.0;
+            std::shared_ptr<Waiter> waiter = queue.front();
+            queue.pop_front();
+            waiter->granted = true;
+            grantedAny = true;
+        }
+        if (tokens < 1.0) break;
+    }
+    // Whoever was granted may be asleep until its own timeout
+    if (grantedAny) {
+        granted.notify_all();
+    }
+}
+
+bool RateLimiter::acquire(Priority priority, const CancellationToken &cancel, const Deadline &deadline) {
+    std::unique_lock<std::mutex> lock(mutex);
+    refill(clock.nowMs());
+
+    bool idle = std::all_of(std::begin(queues), std::end(queues), [](const auto &queue) { return queue.empty(); });
+    if (idle && tokens >= 1.0) {
+        tokens -= 1.0;
+        return true;
+    }
+
+    auto waiter = std::make_shared<Waiter>();
+    auto &queue = queues[static_cast<int>(priority)];
+    queue.push_back(waiter);
+    queuedCount++;
+
+    while (true) {
+        grant();
+        if (waiter->granted) {
+            return true;
+        }
+        if (cancel.isCancelled() || deadline.isExpired()) {
+            queue.erase(std::find(queue.begin(), queue.end(), waiter));
+            granted.notify_all();
+            return false;
+        }
+        // Wake for the next token, a grant by another thread, or to look at the cancel flag again
+        int64_t waitMs = std::clamp<int64_t>(std::min(msUntilToken(), deadline.remainingMs()), 1, 100);
+        clock.waitFor(granted, lock, waitMs);
+    }
+}
+
+void RateLimiter::onRateLimited() {
+    std::lock_guard<std::mutex> lock(mutex);
+    refill(clock.nowMs());
+    rate = std::max(MIN_RATE, rate / 2.0);
+    tokens = 0.0;
+    rateLimitedCount++;
+    LOG_WARNING("Rate limited, slowing requests to " + std::to_string(rate) + "/s");
+}
+
+void RateLimiter::onSuccess() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (rate < configuredRate) {
+        refill(clock.nowMs());
+        rate = std::min(configuredRate, rate + configuredRate / 50.0);
+    }
+}
+
+double RateLimiter::getRate() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rate;
+}
+
+uint64_t RateLimiter::getRateLimitedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rateLimitedCount;
+}
+
+uint64_t RateLimiter::getQueuedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queuedCount;
+}
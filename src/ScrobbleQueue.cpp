@@ -0,0 +1,123 @@
+#include "include/ScrobbleQueue.h"
+#include "include/Config.h"
+#include "include/Logger.h"
+#include "include/Clock.h"
+#include "../lib/json.hpp"
+#include <cstdio>
+#include <fstream>
+
+using json = nlohmann::json;
+
+void ScrobbleQueue::push(Entry entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    loadLocked();
+    if (entries.size() >= MAX_ENTRIES) {
+        LOG_WARNING("Scrobble queue full, dropping oldest: " + entries.front().artist + " - " + entries.front().track);
+        entries.pop_front();
+    }
+    entries.push_back(std::move(entry));
+    saveLocked();
+}
+
+size_t ScrobbleQueue::flush(const std::function<Result(const Entry &)> &submit) {
+    size_t submitted = 0;
+    while (true) {
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loadLocked();
+            int64_t oldest = Clock::getInstance().wallTimeSeconds() - MAX_AGE_SECONDS;
+            while (!entries.empty() && entries.front().timeStamp < oldest) {
+                LOG_WARNING("Dropping queued scrobble too old for Last.fm: " + entries.front().artist + " - " +
+                            entries.front().track);
+                entries.pop_front();
+                saveLocked();
+            }
+            if (entries.empty()) {
+                return submitted;
+            }
+            entry = entries.front();
+        }
+
+        Result result = submit(entry);
+        if (result == Result::FAILED) {
+            return submitted;
+        }
+        if (result == Result::SUBMITTED) {
+            submitted++;
+        } else {
+            LOG_WARNING("Last.fm rejected queued scrobble, dropping: " + entry.artist + " - " + entry.track);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.pop_front();
+        saveLocked();
+    }
+}
+
+size_t ScrobbleQueue::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    loadLocked();
+    return entries.size();
+}
+
+void ScrobbleQueue::loadLocked() {
+    if (loaded) {
+        return;
+    }
+    loaded = true;
+
+    std::ifstream in(Config::getInstance().getScrobbleQueuePath());
+    if (!in.is_open()) {
+        return;
+    }
+    try {
+        json document = json::parse(in);
+        for (const auto &item : document) {
+            Entry entry;
+            entry.artist = item.value("artist", "");
+            entry.track = item.value("track", "");
+            entry.album = item.value("album", "");
+            entry.duration = item.value("duration", 0.0);
+            entry.timeStamp = item.value("timestamp", int64_t{0});
+            entries.push_back(std::move(entry));
+        }
+        if (!entries.empty()) {
+            LOG_INFO("Loaded " + std::to_string(entries.size()) + " queued scrobbles");
+        }
+    } catch (const std::exception &e) {
+        LOG_ERROR("Failed to read scrobble queue: " + std::string(e.what()));
+    }
+}
+
+void ScrobbleQueue::saveLocked() const {
+    const std::string &path = Config::getInstance().getScrobbleQueuePath();
+    json document = json::array();
+    for (const auto &entry : entries) {
+        document.push_back({
+                {"artist",    entry.artist},
+                {"track",     entry.track},
+                {"album",     entry.album},
+                {"duration",  entry.duration},
+                {"timestamp", entry.timeStamp}
+        });
+    }
+
+    // Write aside and rename, so a crash mid-write never loses the queue that is already on disk
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out.is_open()) {
+            LOG_ERROR("Failed to write scrobble queue: " + temporary);
+            return;
+        }
+        out << document.dump();
+        if (!out.good()) {
+            LOG_ERROR("Failed to write scrobble queue: " + temporary);
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        LOG_ERROR("Failed to replace scrobble queue: " + path);
+    }
+}
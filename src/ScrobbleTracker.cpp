@@ -0,0 +1,51 @@
+#include "include/ScrobbleTracker.h"
+
+bool ScrobbleTracker::meetsThreshold(double elapsed, double duration, double playbackRate, bool isMusic) {
+    (void) playbackRate;
+    if (!isMusic) return false;
+
+    double progressPercentage = (duration > 0.0) ? (elapsed / duration) * 100.0 : 0.0;
+
+    return (progressPercentage > 50.0 || elapsed > 240.0);
+}
+
+void ScrobbleTracker::start(int64_t startedAtSeconds) {
+    startedAt = startedAtSeconds;
+    counted = false;
+    submitted = false;
+}
+
+bool ScrobbleTracker::finish(const Submit &submit) {
+    if (!isPending() || !submit(startedAt)) {
+        return false;
+    }
+    markSubmitted();
+    return true;
+}
+
+bool ScrobbleTracker::restart(int64_t startedAtSeconds, const Submit &submit) {
+    bool submittedPlay = finish(submit);
+    start(startedAtSeconds);
+    return submittedPlay;
+}
+
+ScrobbleTracker::Event ScrobbleTracker::observe(double elapsed, double duration, double playbackRate, bool eligible) {
+    if (!eligible) {
+        return Event::NONE;
+    }
+
+    if (!counted) {
+        if (meetsThreshold(elapsed, duration, playbackRate, eligible)) {
+            counted = true;
+            return Event::COUNTED;
+        }
+        return Event::NONE;
+    }
+
+    // Without a duration there is no telling a loop from a long track, which would otherwise look
+    // like a restart on every poll once it had counted by playing four minutes
+    if (duration > 0.0 && elapsed < duration * LOOP_PROGRESS && playbackRate > 0.0) {
+        return Event::LOOPED;
+    }
+    return Event::NONE;
+}
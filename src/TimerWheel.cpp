@@ -0,0 +1,183 @@
+#include "include/TimerWheel.h"
+#include <algorithm>
+
+namespace {
+    void initHead(TimerWheel::Node &head) {
+        head.prev = &head;
+        head.next = &head;
+    }
+
+    bool isEmpty(const TimerWheel::Node &head) {
+        return head.next == &head;
+    }
+}
+
+TimerWheel::TimerWheel(int64_t nowMs) : current(nowMs) {
+    for (auto &level : slots) {
+        for (auto &head : level) {
+            initHead(head);
+        }
+    }
+    initHead(overdue);
+}
+
+void TimerWheel::link(Node &head, Node &node, int level) {
+    node.level = level;
+    node.prev = head.prev;
+    node.next = &head;
+    head.prev->next = &node;
+    head.prev = &node;
+    if (level < LEVELS) {
+        levelCount[level]++;
+    }
+}
+
+void TimerWheel::place(Node &node) {
+    int64_t delta = node.deadline - current;
+    if (delta < 0) {
+        link(overdue, node, LEVELS);
+        return;
+    }
+
+    for (int level = 0; level < LEVELS; ++level) {
+        int shift = level * SLOT_BITS;
+        if (delta < (int64_t(1) << (shift + SLOT_BITS))) {
+            link(slots[level][(node.deadline >> shift) & MASK], node, level);
+            return;
+        }
+    }
+
+    // Beyond the wheel's range: park in the furthest top-level slot and re-place on cascade
+    int shift = (LEVELS - 1) * SLOT_BITS;
+    link(slots[LEVELS - 1][((current + SPAN - 1) >> shift) & MASK], node, LEVELS - 1);
+}
+
+void TimerWheel::insert(Node &node, int64_t deadlineMs) {
+    if (node.isLinked()) {
+        remove(node);
+    }
+    node.deadline = deadlineMs;
+    count++;
+    if (deadlineMs <= current) {
+        link(overdue, node, LEVELS);
+    } else {
+        place(node);
+    }
+}
+
+void TimerWheel::remove(Node &node) {
+    if (!node.isLinked()) {
+        return;
+    }
+    node.prev->next = node.next;
+    node.next->prev = node.prev;
+    node.prev = nullptr;
+    node.next = nullptr;
+    if (node.level < LEVELS) {
+        levelCount[node.level]--;
+    }
+    node.level = -1;
+    count--;
+}
+
+void TimerWheel::cascade(int level, int index) {
+    Node &head = slots[level][index];
+    Node pending;
+    initHead(pending);
+    if (isEmpty(head)) {
+        return;
+    }
+
+    // Detach the whole slot first so re-placed nodes cannot land back in the list being walked
+    pending.next = head.next;
+    pending.prev = head.prev;
+    pending.next->prev = &pending;
+    pending.prev->next = &pending;
+    initHead(head);
+
+    while (!isEmpty(pending)) {
+        Node *node = pending.next;
+        pending.next = node->next;
+        node->next->prev = &pending;
+        levelCount[level]--;
+        place(*node);
+    }
+}
+
+void TimerWheel::drain(Node &head, std::vector<Node *> &expired) {
+    while (!isEmpty(head)) {
+        Node *node = head.next;
+        remove(*node);
+        expired.push_back(node);
+    }
+}
+
+void TimerWheel::advance(int64_t nowMs, std::vector<Node *> &expired) {
+    drain(overdue, expired);
+
+    while (current < nowMs) {
+        if (count == 0) {
+            current = nowMs;
+            break;
+        }
+
+        // Jump over ticks where no slot can fire or cascade: up to the next boundary of the lowest busy level
+        int busy = 0;
+        while (busy < LEVELS - 1 && levelCount[busy] == 0) {
+            busy++;
+        }
+        if (busy > 0) {
+            int64_t boundary = (current | ((int64_t(1) << (busy * SLOT_BITS)) - 1)) + 1;
+            if (boundary > nowMs) {
+                current = nowMs;
+                break;
+            }
+            current = boundary - 1;
+        }
+
+        int64_t tick = ++current;
+        int index = static_cast<int>(tick & MASK);
+        for (int level = 1; index == 0 && level < LEVELS; ++level) {
+            index = static_cast<int>((tick >> (level * SLOT_BITS)) & MASK);
+            cascade(level, index);
+        }
+        drain(slots[0][tick & MASK], expired);
+        drain(overdue, expired);
+    }
+}
+
+int64_t TimerWheel::nextDeadline() const {
+    if (count == 0) {
+        return -1;
+    }
+    if (!isEmpty(overdue)) {
+        return current;
+    }
+
+    // Level 0 holds the next 64 ticks in order, so its first non-empty slot is its minimum
+    int64_t earliest = -1;
+    if (levelCount[0] > 0) {
+        for (int64_t tick = current + 1; tick <= current + SLOTS; ++tick) {
+            const Node &head = slots[0][tick & MASK];
+            if (!isEmpty(head)) {
+                earliest = head.next->deadline;
+                break;
+            }
+        }
+    }
+
+    // A timer placed higher up before time moved on can still be due sooner; there are few, so scan them
+    for (int level = 1; level < LEVELS; ++level) {
+        if (levelCount[level] == 0) {
+            continue;
+        }
+        for (const auto &head : slots[level]) {
+            for (const Node *node = head.next; node != &head; node = node->next) {
+                if (earliest < 0 || node->deadline < earliest) {
+                    earliest = node->deadline;
+                }
+            }
+        }
+    }
+    return earliest;
+}
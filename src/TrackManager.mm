@@ -2,6 +2,8 @@
 #include <include/Logger.h>
 #include <include/Helper.h>
 #include <include/LyricsManager.h>
+#include <include/Clock.h>
+#include <include/EventLoop.h>
 #include <sys/ioctl.h>
 #include <mutex>
 #include <CoreFoundation/CoreFoundation.h>
@@ -72,33 +74,73 @@ void TrackManager::processTitleChange(const std::string &artist, const std::stri
     @autoreleasepool {
         LOG_DEBUG("Title changed: '" + lastTitle + "' -> '" + title + "'");
         LOG_DEBUG("Artist: '" + artist + "', Album: '" + album + "'");
+        titleChangedMs = Clock::getInstance().nowMs();
 
-        if (currentTrack && currentTrack->hasScrobbled && !currentTrack->hasSubmitted && currentTrack->isMusic) {
-            LOG_DEBUG("Attempting to scrobble previous track");
-            currentTrack->hasSubmitted = scrobbler.scrobble(currentTrack->artist,
-                                                            currentTrack->title,
-                                                            currentTrack->album,
-                                                            currentTrack->duration,
-                                                            currentTrack->beginTimeStamp);
+        // Resolution and lyrics still in flight for the previous track are no longer wanted
+        trackRequests.cancel();
+        trackRequests = CancellationToken::create();
+
+        // Platform metadata is final, so its lyrics need not wait for the previous scrobble to go out
+        if (isFromMusicPlatform && config.isShowLyrics()) {
+            std::string trackId = generateTrackId(artist, title, album);
+            if (!trackId.empty() && !isCachedTrak(trackId)) {
+                lyricsManager.fetchLyrics(trackId, artist, title, album, 0.0, trackRequests);
+            }
+        }
+
+        if (currentTrack && currentTrack->isMusic && currentTrack->scrobbleTracker.finish(submitPlay(*currentTrack))) {
             LOG_DEBUG("Previous track scrobbled on change");
         }
 
         lyricsManager.clearLyricsArea();
 
-        bool isMusic = false;
-        extractedArtist = safeStringCopy(artist);
-        extractedTitle = safeStringCopy(title);
-        LOG_DEBUG("Extracted artist: '" + extractedArtist + "', title: '" + extractedTitle + "'");
+        // Recorded now so the polls that arrive while this resolves do not report the change again
+        lastTitle = safeStringCopy(title);
+        lastArtist = safeStringCopy(artist);
+        lastAlbum = safeStringCopy(album);
 
         if (isFromMusicPlatform) {
-            isMusic = true;
-            LOG_DEBUG("Using platform metadata: " + extractedArtist + " - " + extractedTitle);
-        } else if (Helper::extractMusicInfo(artist, title, album, extractedArtist, extractedTitle)) {
-            isMusic = true;
-            LOG_DEBUG("Extracted metadata: " + extractedArtist + " - " + extractedTitle);
+            LOG_DEBUG("Using platform metadata: " + artist + " - " + title);
+            finishTitleChange(artist, title, album, true, artist, title);
+            return;
+        }
+
+        std::string trackId = generateTrackId(artist, title, album);
+        if (!trackId.empty() && isCachedTrak(trackId)) {
+            TrackState *cached = getCachedTrack(trackId);
+            finishTitleChange(artist, title, album, cached->isMusic, cached->artist, cached->title);
+            return;
         }
 
+        // Until resolution answers, playback belongs to no track, so nothing counts towards the previous one
+        resolvingTrack = TrackState();
+        resolvingTrack.artist = lastArtist;
+        resolvingTrack.title = lastTitle;
+        resolvingTrack.album = lastAlbum;
+        currentTrack = &resolvingTrack;
+
+        CancellationToken cancel = trackRequests;
+        resolver.post([this, artist, title, album, cancel] {
+            std::string resolvedArtist, resolvedTitle;
+            bool isMusic = Helper::extractMusicInfo(artist, title, album, resolvedArtist, resolvedTitle, cancel);
+            EventLoop::getInstance().post([this, artist, title, album, cancel, isMusic, resolvedArtist, resolvedTitle] {
+                if (cancel.isCancelled()) {
+                    LOG_DEBUG("Dropping resolution for a track no longer playing: " + artist + " - " + title);
+                    return;
+                }
+                finishTitleChange(artist, title, album, isMusic, resolvedArtist, resolvedTitle);
+            });
+        });
+    }
+}
+
+void TrackManager::finishTitleChange(const std::string &artist, const std::string &title, const std::string &album,
+                                     bool isMusic, const std::string &resolvedArtist,
+                                     const std::string &resolvedTitle) {
+    @autoreleasepool {
         if (isMusic) {
+            extractedArtist = safeStringCopy(resolvedArtist);
+            extractedTitle = safeStringCopy(resolvedTitle);
             LOG_DEBUG("Updating track info for music content");
             updateTrackInfo(extractedArtist, extractedTitle, album, isMusic, 0.0, 0.0);
             lastTitle = safeStringCopy(title);
@@ -108,17 +150,9 @@ void TrackManager::processTitleChange(const std::string &artist, const std::stri
             LOG_INFO("⏭️ Switched to: " + extractedArtist + " - " + extractedTitle + " [" + album + "]  (" +
                      std::to_string(currentTrack->duration) + " sec)");
             LOG_DEBUG("Resetting scrobble state for new track");
-
-            if (config.isShowLyrics()) {
-                if (currentTrack->hasSyncedLyrics && config.isPreferSyncedLyrics()) {
-                    LOG_INFO("Synced lyrics found for: " + currentTrack->artist + " - " + currentTrack->title);
-                } else if (!currentTrack->plainLyrics.empty()) {
-                    LOG_INFO("Plain lyrics found for: " + currentTrack->artist + " - " + currentTrack->title);
-                } else {
-                    LOG_INFO("No lyrics found for: " + currentTrack->artist + " - " + currentTrack->title);
-                }
-            }
         } else {
+            extractedArtist = safeStringCopy(artist);
+            extractedTitle = safeStringCopy(title);
             LOG_DEBUG("Updating track info for non-music content");
             updateTrackInfo(artist, title, album, isMusic, 0.0, 0.0);
             lastTitle = safeStringCopy(title);
@@ -135,14 +169,10 @@ void TrackManager::handlePlaybackStateChange(double playbackRateValue, double el
 
     if (!currentTrack) return;
 
-    double progressPercentage = (currentTrack->duration > 0.0)
-                                ? (elapsedValue / currentTrack->duration) * 100.0
-                                : 0.0;
-
-    if (!currentTrack->hasScrobbled &&
-        LastFmScrobbler::shouldScrobble(elapsedValue, currentTrack->duration,
-                                        playbackRateValue, currentTrack->isMusic)) {
-        currentTrack->hasScrobbled = true;
+    bool eligible = currentTrack->isMusic && config.isScrobblingEnabled();
+    ScrobbleTracker::Event event = currentTrack->scrobbleTracker.observe(elapsedValue, currentTrack->duration,
+                                                                         playbackRateValue, eligible);
+    if (event == ScrobbleTracker::Event::COUNTED) {
         LOG_DEBUG("Track reached scrobble threshold");
     }
 
@@ -162,14 +192,11 @@ void TrackManager::handlePlaybackStateChange(double playbackRateValue, double el
         }
     }
 
-    if (currentTrack->title == lastTitle && progressPercentage < 10.0 && playbackRateValue > 0.0 &&
-        currentTrack->hasScrobbled && currentTrack->isMusic) {
-        if (!currentTrack->hasSubmitted) {
-            scrobbler.scrobble(currentTrack->artist,
-                               currentTrack->title,
-                               currentTrack->album,
-                               currentTrack->duration,
-                               currentTrack->beginTimeStamp);
+    if (event == ScrobbleTracker::Event::LOOPED && currentTrack->title == lastTitle) {
+        // The next play began when this one restarted, not when the track was first seen
+        if (currentTrack->scrobbleTracker.restart(
+                static_cast<int64_t>(Clock::getInstance().wallTimeSeconds() - elapsedValue),
+                submitPlay(*currentTrack))) {
             LOG_DEBUG("Looped track scrobbled on restart");
         }
         LOG_INFO("Scrobbled song restarted： " + currentTrack->artist + " - " + currentTrack->title + " [" +
@@ -181,11 +208,16 @@ void TrackManager::handlePlaybackStateChange(double playbackRateValue, double el
                         currentTrack->isMusic,
                         currentTrack->duration,
                         elapsedValue);
-        currentTrack->hasScrobbled = false;
-        currentTrack->hasSubmitted = false;
     }
 }
 
+ScrobbleTracker::Submit TrackManager::submitPlay(const TrackState &track) {
+    return [this, &track](int64_t startedAt) {
+        return scrobbler.scrobble(track.artist, track.title, track.album, track.duration,
+                                  static_cast<int>(startedAt));
+    };
+}
+
 void TrackManager::updateTrackInfo(const std::string &artist, const std::string &title, const std::string &album,
                                    bool isMusic, double duration, double elapsedValue) {
 
@@ -202,7 +234,7 @@ void TrackManager::updateTrackInfo(const std::string &artist, const std::string
             }
             LOG_DEBUG("Generated track ID: " + trackId);
             
-            double currentTime = CFAbsoluteTimeGetCurrent();
+            double currentTime = Clock::getInstance().nowSeconds();
             LOG_DEBUG("Current time: " + std::to_string(currentTime));
 
             // Check if track is already in cache, only update necessary fields
@@ -262,13 +294,10 @@ void TrackManager::updateTrackInfo(const std::string &artist, const std::string
             
             LOG_DEBUG("Initializing track state values");
             state.isMusic = isMusic;
-            state.beginTimeStamp = static_cast<int>(std::time(nullptr));
+            state.scrobbleTracker.start(static_cast<int64_t>(Clock::getInstance().wallTimeSeconds()));
             state.lastFetchTime = currentTime;
-            state.hasScrobbled = false;
-            state.hasSubmitted = false;
             state.lastElapsed = elapsedValue;
             state.duration = duration;
-            state.lastNowPlayingSent = currentTime;
             state.lastPlaybackRate = 1.0; // 默认播放速率为1.0
             state.lastReportedElapsed = elapsedValue;
             LOG_DEBUG("Initialized track state values");
@@ -278,7 +307,6 @@ void TrackManager::updateTrackInfo(const std::string &artist, const std::string
             state.plainLyrics.clear();
             state.syncedLyrics.clear();
             state.hasSyncedLyrics = false;
-            state.parsedSyncedLyrics.clear();
             state.currentLyricIndex = -1;
             LOG_DEBUG("Cleared lyrics data");
 
@@ -296,13 +324,15 @@ void TrackManager::updateTrackInfo(const std::string &artist, const std::string
                 @try {
                     LyricsManager::getInstance().clearLyricsArea();
                     LyricsManager::getInstance().fetchLyrics(
+                            trackId,
                             state.artist,
                             state.title,
                             state.album,
-                            state.duration
+                            state.duration,
+                            trackRequests
                     );
                     LyricsManager::getInstance().forceRefreshLyrics();
-                    LOG_DEBUG("Successfully fetched and processed lyrics");
+                    LOG_DEBUG("Lyrics requested, they attach to this track when they arrive");
                 } @catch (NSException *exception) {
                     LOG_ERROR("Exception while fetching lyrics: " + std::string([[exception description] UTF8String]));
                 }
@@ -0,0 +1,424 @@
+#include "include/UrlUtils.h"
+#include "include/Credentials.h"
+#include "include/ApiRequest.h"
+#include "include/Clock.h"
+#include "include/RateLimiter.h"
+#include "include/CircuitBreaker.h"
+#include <curl/curl.h>
+#include <string>
+#include <map>
+#include <mutex>
+#include <climits>
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <random>
+#include <strings.h>
+
+namespace {
+    std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+
+    void lockShare(CURL *, curl_lock_data data, curl_lock_access, void *) {
+        shareLocks[data].lock();
+    }
+
+    void unlockShare(CURL *, curl_lock_data data, void *) {
+        shareLocks[data].unlock();
+    }
+
+    CURLSH *sharedCache() {
+        static CURLSH *share = [] {
+            CURLSH *created = curl_share_init();
+            if (created) {
+                curl_share_setopt(created, CURLSHOPT_LOCKFUNC, lockShare);
+                curl_share_setopt(created, CURLSHOPT_UNLOCKFUNC, unlockShare);
+                curl_share_setopt(created, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+                curl_share_setopt(created, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+                curl_share_setopt(created, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+            }
+            return created;
+        }();
+        return share;
+    }
+}
+
+CURL *UrlUtils::createHandle() {
+    CURL *curl = curl_easy_init();
+    if (curl && sharedCache()) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, sharedCache());
+    }
+    return curl;
+}
+
+std::string UrlUtils::urlEncode(const std::string &input) {
+    std::string encoded;
+    encoded.reserve(input.size() * 3);
+    ApiRequest::appendFormEncoded(encoded, input);
+    return encoded;
+}
+
+size_t UrlUtils::writeCallback(void *ptr, size_t size, size_t nmemb, std::string *data) {
+    if (!data) return 0;
+    data->append((char *) ptr, size * nmemb);
+    return size * nmemb;
+}
+
+void UrlUtils::setTransport(Transport newTransport) {
+    transport = std::move(newTransport);
+}
+
+int UrlUtils::progressCallback(void *clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    // Non-zero aborts the transfer with CURLE_ABORTED_BY_CALLBACK. curl calls this at least once a second,
+    // even while waiting on a silent peer, which bounds how long a cancel takes to land
+    return static_cast<const CancellationToken *>(clientp)->isCancelled() ? 1 : 0;
+}
+
+CURLcode UrlUtils::perform(CURL *curl, const std::string &url, const std::string *postFields, std::string &response,
+                           const Deadline &deadline, const CancellationToken &cancel, ResponseInfo *info) {
+    if (cancel.isCancelled()) {
+        return CURLE_ABORTED_BY_CALLBACK;
+    }
+    if (deadline.isExpired()) {
+        return CURLE_OPERATION_TIMEDOUT;
+    }
+    if (transport) {
+        return transport(url, postFields, response);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    if (postFields) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postFields->c_str());
+    }
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+
+    // The whole transfer has to fit in what is left of the caller's budget
+    long remaining = static_cast<long>(std::min<int64_t>(deadline.remainingMs(), LONG_MAX));
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, deadline.isSet() ? remaining : 0L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, std::min(remaining, CONNECT_TIMEOUT_MS));
+    // A peer that accepts the connection and then goes silent is dropped even without a deadline
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, STALL_TIMEOUT_S);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &cancel);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+
+    if (info) {
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, info);
+    }
+
+    CURLcode res = curl_easy_perform(curl);
+
+    if (info && res == CURLE_OK) {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &info->status);
+    }
+
+    // The handle outlives this call; do not leave it pointing at the caller's token or info
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, nullptr);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, nullptr);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, nullptr);
+    return res;
+}
+
+std::string UrlUtils::buildApiUrl(const std::string &method,
+                                  const std::map<std::string, std::string> &params) {
+    std::shared_ptr<const Credentials::Secrets> secrets = Credentials::apiSecrets();
+
+    ApiRequest request(method);
+    for (const auto &param: params) {
+        if (!request.set(param.first, param.second)) {
+            LOG_ERROR("Too many parameters for " + method);
+            return "";
+        }
+    }
+    if (!request.set("method", method) || !request.set("api_key", secrets->apiKey)) {
+        LOG_ERROR("Too many parameters for " + method);
+        return "";
+    }
+
+    std::string query;
+    request.encodeSigned(query, secrets->apiSecret);
+
+    std::string url = API_URL;
+    url += '?';
+    url += query;
+    LOG_DEBUG("Generated URL: " + url);
+    return url;
+}
+
+bool UrlUtils::encodeScrobble(const ScrobbleQueue::Entry &entry, const Credentials::Secrets &secrets,
+                              std::string &body) {
+    body.clear();
+    ApiRequest request("track.scrobble");
+    bool complete = request.set("artist", entry.artist) && request.set("track", entry.track) &&
+                    request.set("timestamp", entry.timeStamp) && request.set("sk", secrets.sessionKey) &&
+                    request.set("api_key", secrets.apiKey);
+    if (complete && !entry.album.empty()) {
+        complete = request.set("album", entry.album);
+    }
+    if (complete && entry.duration > 0) {
+        complete = request.set("duration", static_cast<int64_t>(entry.duration));
+    }
+    if (!complete) {
+        LOG_ERROR("Too many parameters for track.scrobble");
+        return false;
+    }
+    request.encodeSigned(body, secrets.apiSecret);
+    return true;
+}
+
+bool UrlUtils::encodeNowPlaying(const std::string &artist, const std::string &track, const std::string &album,
+                                double duration, const Credentials::Secrets &secrets, std::string &body) {
+    body.clear();
+    ApiRequest request("track.updateNowPlaying");
+    bool complete = request.set("artist", artist) && request.set("track", track) &&
+                    request.set("sk", secrets.sessionKey) && request.set("api_key", secrets.apiKey);
+    if (complete && !album.empty()) {
+        complete = request.set("album", album);
+    }
+    if (complete && duration > 0) {
+        complete = request.set("duration", static_cast<int64_t>(duration));
+    }
+    if (!complete) {
+        LOG_ERROR("Too many parameters for track.updateNowPlaying");
+        return false;
+    }
+    request.encodeSigned(body, secrets.apiSecret);
+    return true;
+}
+
+ApiResponse UrlUtils::sendGetRequest(const std::string &url, CURL *curl, int maxRetries,
+                                     const CancellationToken &cancel, RateLimiter::Priority priority,
+                                     const Deadline &deadline) {
+    // A request only joins one of its own class, so an urgent call never waits on a prefetch's place in the queue
+    std::string key = std::to_string(static_cast<int>(priority)) + ' ' + url;
+    bool shared = false;
+    FlightOutcome outcome = getFlights.run(key, [&] {
+        FlightOutcome result;
+        result.response = execute(url, nullptr, curl, maxRetries, cancel, priority, deadline);
+        result.error = lastError;
+        result.transient = transientFailure;
+        result.errorCode = lastErrorCode;
+        return result;
+    }, &shared);
+
+    if (shared) {
+        LOG_DEBUG("Joined in-flight request: " + url);
+        lastError = outcome.error;
+        transientFailure = outcome.transient;
+        lastErrorCode = outcome.errorCode;
+        // The request we joined may have been cancelled by its owner while this caller still wants an answer
+        if (outcome.response.empty() && !cancel.isCancelled() && !deadline.isExpired()) {
+            return execute(url, nullptr, curl, maxRetries, cancel, priority, deadline);
+        }
+    }
+    return std::move(outcome.response);
+}
+
+ApiResponse UrlUtils::sendPostRequest(const std::string &url,
+                                      const std::string &postFields,
+                                      CURL *curl, int maxRetries, const CancellationToken &cancel,
+                                      RateLimiter::Priority priority, const Deadline &deadline) {
+    return execute(url, &postFields, curl, maxRetries, cancel, priority, deadline);
+}
+
+ApiResponse UrlUtils::execute(const std::string &url, const std::string *postFields, CURL *curl, int maxRetries,
+                              const CancellationToken &cancel, RateLimiter::Priority priority,
+                              const Deadline &deadline) {
+    transientFailure = false;
+    lastErrorCode = 0;
+    bool needsCleanup = false;
+    if (!curl) {
+        curl = createHandle();
+        if (!curl) {
+            lastError = "Failed to initialize CURL";
+            LOG_ERROR(lastError);
+            return {};
+        }
+        needsCleanup = true;
+    }
+
+    CircuitBreaker &breaker = CircuitBreaker::forUrl(url);
+    ApiResponse result;
+    int64_t backoffMs = BASE_BACKOFF_MS;
+    try {
+        for (int attempt = 1; attempt <= maxRetries; ++attempt) {
+            if (!breaker.allowRequest()) {
+                lastError = "Circuit open for " + CircuitBreaker::hostOf(url);
+                LOG_DEBUG(lastError + ", not sending: " + url);
+                transientFailure = true;
+                break;
+            }
+            if (!RateLimiter::lastFm().acquire(priority, cancel, deadline)) {
+                breaker.onAbandoned();
+                lastError = cancel.isCancelled() ? "Request cancelled" : "Deadline exceeded";
+                LOG_DEBUG(lastError + ": " + url);
+                break;
+            }
+
+            std::string response;
+            ResponseInfo info;
+            curl_easy_setopt(curl, CURLOPT_USERAGENT, "Scrobbler/1.0");
+
+            CURLcode res = perform(curl, url, postFields, response, deadline, cancel, &info);
+
+            if (res == CURLE_ABORTED_BY_CALLBACK) {
+                breaker.onAbandoned();
+                lastError = "Request cancelled";
+                LOG_DEBUG(lastError + ": " + url);
+                break;
+            }
+
+            ApiResponse parsed(std::move(response));
+            if (res != CURLE_OK) {
+                lastError = "CURL error: " + std::string(curl_easy_strerror(res));
+                LOG_ERROR(lastError);
+                transientFailure = true;
+            } else if (processResponse(parsed, info.status)) {
+                breaker.onSuccess();
+                result = std::move(parsed);
+                break;
+            } else {
+                transientFailure = isTransient(parsed, info.status);
+            }
+
+            if (!transientFailure) {
+                // The host is fine, it just turned this request down; asking again will not change that
+                breaker.onSuccess();
+                break;
+            }
+            breaker.onFailure(info.retryAfterMs);
+
+            if (attempt == maxRetries) {
+                break;
+            }
+            int64_t delayMs = info.retryAfterMs;
+            if (delayMs < 0) {
+                backoffMs = nextBackoff(backoffMs);
+                delayMs = backoffMs;
+            }
+            if (!waitBeforeRetry(delayMs, cancel, deadline)) {
+                break;
+            }
+        }
+    } catch (const std::exception &e) {
+        breaker.onAbandoned();
+        lastError = "Exception: " + std::string(e.what());
+        LOG_ERROR(lastError);
+    }
+
+    if (needsCleanup) {
+        curl_easy_cleanup(curl);
+    }
+    return result;
+}
+
+bool UrlUtils::processResponse(const ApiResponse &response, long status) {
+    if (!response.isJson()) {
+        lastError = status >= 400 ? "HTTP " + std::to_string(status) : "Failed to parse response";
+        LOG_ERROR(lastError);
+        return false;
+    }
+    if (response.hasError()) {
+        lastError = "Last.fm API error " + std::to_string(response.getErrorCode()) +
+                    ": " + response.getErrorMessage();
+        LOG_ERROR(lastError);
+        lastErrorCode = response.getErrorCode();
+        if (lastErrorCode == 29) {
+            RateLimiter::lastFm().onRateLimited();
+        } else if (lastErrorCode == 9) { // Invalid session key
+            Credentials::invalidateSessionKey();
+        }
+        return false;
+    }
+    RateLimiter::lastFm().onSuccess();
+    return true;
+}
+
+bool UrlUtils::isTransient(const ApiResponse &response, long status) {
+    // An HTML error page is only worth retrying if the status says the server is struggling
+    if (status == 429 || status >= 500) {
+        return true;
+    }
+    if (!response.isJson()) {
+        return false;
+    }
+
+    switch (response.getErrorCode()) {
+        case 8:  // Operation failed, backend error
+        case 11: // Service Offline
+        case 16: // Service Temporarily Unavailable
+        case 29: // Rate Limit Exceeded
+            return true;
+        default:
+            return false;
+    }
+}
+
+int64_t UrlUtils::nextBackoff(int64_t previousMs) {
+    // Decorrelated jitter: random between the base and three times the last sleep, so clients that failed
+    // together do not retry together
+    thread_local std::mt19937_64 random{std::random_device{}()};
+    std::uniform_int_distribution<int64_t> pick(BASE_BACKOFF_MS, std::max(BASE_BACKOFF_MS, previousMs * 3));
+    return std::min(pick(random), MAX_BACKOFF_MS);
+}
+
+bool UrlUtils::waitBeforeRetry(int64_t delayMs, const CancellationToken &cancel, const Deadline &deadline) {
+    if (delayMs >= deadline.remainingMs()) {
+        lastError = "Deadline exceeded";
+        LOG_DEBUG("Not retrying, waiting " + std::to_string(delayMs) + " ms would outlast the deadline");
+        return false;
+    }
+
+    // Sleep in slices so a track change does not have to wait out the backoff
+    for (int64_t slept = 0; slept < delayMs; slept += RETRY_SLICE_MS) {
+        if (cancel.isCancelled()) {
+            lastError = "Request cancelled";
+            return false;
+        }
+        Clock::getInstance().sleepMs(std::min<int64_t>(RETRY_SLICE_MS, delayMs - slept));
+    }
+    return !cancel.isCancelled();
+}
+
+int64_t UrlUtils::parseRetryAfter(std::string value) {
+    size_t first = value.find_first_not_of(" \t");
+    size_t last = value.find_last_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return -1;
+    }
+    value = value.substr(first, last - first + 1);
+
+    // A server asking for longer still gets retried within the cap; the circuit breaker covers real outages
+    if (std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return value.size() > 9 ? MAX_BACKOFF_MS : std::min<int64_t>(std::stoll(value) * 1000, MAX_BACKOFF_MS);
+    }
+
+    // Otherwise an HTTP-date, e.g. "Wed, 21 Oct 2015 07:28:00 GMT"
+    std::tm when = {};
+    if (!strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S", &when)) {
+        return -1;
+    }
+    int64_t seconds = static_cast<int64_t>(timegm(&when)) - Clock::getInstance().wallTimeSeconds();
+    return std::min(std::max<int64_t>(seconds, 0) * 1000, MAX_BACKOFF_MS);
+}
+
+size_t UrlUtils::headerCallback(char *buffer, size_t size, size_t nitems, ResponseInfo *info) {
+    size_t length = size * nitems;
+    static constexpr char name[] = "retry-after:";
+    static constexpr size_t nameLength = sizeof(name) - 1;
+    if (info && length > nameLength && strncasecmp(buffer, name, nameLength) == 0) {
+        info->retryAfterMs = parseRetryAfter(std::string(buffer + nameLength, length - nameLength));
+    }
+    return length;
+}
+
+thread_local std::string UrlUtils::lastError;
+thread_local bool UrlUtils::transientFailure = false;
+thread_local int UrlUtils::lastErrorCode = 0;
+SingleFlight<std::string, UrlUtils::FlightOutcome> UrlUtils::getFlights;
+UrlUtils::Transport UrlUtils::transport;
\ No newline at end of file
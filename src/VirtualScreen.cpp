@@ -0,0 +1,259 @@
+#include "include/VirtualScreen.h"
+#include "include/Unicode.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    constexpr uint32_t glyphHash(std::string_view bytes) {
+        uint32_t hash = 2166136261u;
+        for (char c: bytes) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    VirtualScreen::Cell makeCell(std::string_view cluster, int width, Surface::Style style) {
+        VirtualScreen::Cell cell;
+        cell.glyph = glyphHash(cluster);
+        cell.bytes = static_cast<uint8_t>(std::min<size_t>(cluster.size(), 255));
+        cell.width = static_cast<uint8_t>(width);
+        cell.colorPair = style.colorPair;
+        cell.bold = style.bold;
+        return cell;
+    }
+
+    std::string_view glyphText(Surface::Glyph glyph) {
+        switch (glyph) {
+            case Surface::Glyph::UpArrow:
+                return "↑";
+            case Surface::Glyph::DownArrow:
+                return "↓";
+            case Surface::Glyph::VerticalLine:
+                return "│";
+            case Surface::Glyph::HorizontalLine:
+            default:
+                return "─";
+        }
+    }
+
+    class VirtualSurface : public Surface {
+    public:
+        VirtualSurface(VirtualScreen &screen, int rows, int cols, int y, int x, bool isPad)
+                : screen(screen), rows(rows), cols(cols), originY(y), originX(x), isPad(isPad),
+                  cells(static_cast<size_t>(rows) * cols, VirtualScreen::blankCell()),
+                  touched(rows, true) {}
+
+        [[nodiscard]] int getRows() const override { return rows; }
+        [[nodiscard]] int getCols() const override { return cols; }
+        [[nodiscard]] int getOriginY() const override { return originY; }
+        [[nodiscard]] int getOriginX() const override { return originX; }
+
+        void resize(int newRows, int newCols) override {
+            std::vector<VirtualScreen::Cell> resized(static_cast<size_t>(newRows) * newCols,
+                                                     VirtualScreen::blankCell());
+            for (int y = 0; y < std::min(rows, newRows); y++) {
+                std::copy_n(&cells[static_cast<size_t>(y) * cols], std::min(cols, newCols),
+                            &resized[static_cast<size_t>(y) * newCols]);
+            }
+            rows = newRows;
+            cols = newCols;
+            cells.swap(resized);
+            touched.assign(rows, true);
+        }
+
+        void moveTo(int y, int x) override {
+            originY = y;
+            originX = x;
+            touch();
+        }
+
+        void erase() override {
+            std::fill(cells.begin(), cells.end(), VirtualScreen::blankCell());
+            touch();
+        }
+
+        void clearToEol(int y, int x) override {
+            if (y < 0 || y >= rows || x >= cols) return;
+            x = std::max(x, 0);
+            std::fill(at(y, x), at(y, 0) + cols, VirtualScreen::blankCell());
+            touched[y] = true;
+        }
+
+        void drawBox(Style style) override {
+            if (rows < 2 || cols < 2) return;
+            put(0, 0, makeCell("┌", 1, style));
+            put(0, cols - 1, makeCell("┐", 1, style));
+            put(rows - 1, 0, makeCell("└", 1, style));
+            put(rows - 1, cols - 1, makeCell("┘", 1, style));
+            drawGlyph(0, 1, Glyph::HorizontalLine, style, cols - 2);
+            drawGlyph(rows - 1, 1, Glyph::HorizontalLine, style, cols - 2);
+            for (int y = 1; y < rows - 1; y++) {
+                drawGlyph(y, 0, Glyph::VerticalLine, style, 1);
+                drawGlyph(y, cols - 1, Glyph::VerticalLine, style, 1);
+            }
+        }
+
+        int drawText(int y, int x, std::string_view text, Style style) override {
+            if (y < 0 || y >= rows) return x;
+            while (!text.empty() && x < cols) {
+                int width;
+                size_t length = Unicode::clusterLength(text, width);
+                if (width > 0) {
+                    if (x + width > cols) break;
+                    put(y, x, makeCell(text.substr(0, length), width, style));
+                    if (width == 2) {
+                        VirtualScreen::Cell trail = makeCell({}, 0, style);
+                        put(y, x + 1, trail);
+                    }
+                    x += width;
+                }
+                text.remove_prefix(length);
+            }
+            return x;
+        }
+
+        void drawGlyph(int y, int x, Glyph glyph, Style style, int count) override {
+            VirtualScreen::Cell cell = makeCell(glyphText(glyph), 1, style);
+            for (int i = 0; i < count && x + i < cols; i++) {
+                put(y, x + i, cell);
+            }
+        }
+
+        void touch() override {
+            std::fill(touched.begin(), touched.end(), true);
+        }
+
+        void stage() override {
+            if (isPad) return;
+            for (int y = 0; y < rows; y++) {
+                if (!touched[y]) continue;
+                screen.stageCells(at(y, 0), cols, originY + y, originX);
+                touched[y] = false;
+            }
+        }
+
+        void stageRegion(int row, int col, int screenTop, int screenLeft, int screenBottom, int screenRight) override {
+            if (!isPad || col >= cols) return;
+            int width = std::min(screenRight - screenLeft + 1, cols - col);
+            for (int y = 0; y <= screenBottom - screenTop && row + y < rows; y++) {
+                if (!touched[row + y]) continue;
+                screen.stageCells(at(row + y, col), width, screenTop + y, screenLeft);
+                touched[row + y] = false;
+            }
+        }
+
+    private:
+        VirtualScreen::Cell *at(int y, int x) {
+            return &cells[static_cast<size_t>(y) * cols + x];
+        }
+
+        void put(int y, int x, const VirtualScreen::Cell &cell) {
+            if (y < 0 || y >= rows || x < 0 || x >= cols) return;
+            *at(y, x) = cell;
+            touched[y] = true;
+        }
+
+        VirtualScreen &screen;
+        int rows;
+        int cols;
+        int originY;
+        int originX;
+        bool isPad;
+        std::vector<VirtualScreen::Cell> cells;
+        std::vector<bool> touched;
+    };
+
+    size_t cursorMoveBytes(int y, int x) {
+        char buffer[32];
+        return static_cast<size_t>(snprintf(buffer, sizeof(buffer), "\033[%d;%dH", y + 1, x + 1));
+    }
+
+    size_t styleBytes(const VirtualScreen::Cell &cell) {
+        // ESC [ 0 ; 3 n m, plus ;1 for bold
+        return 7 + (cell.bold ? 2 : 0);
+    }
+}
+
+VirtualScreen::VirtualScreen(int rows, int cols) : rows(rows), cols(cols) {
+    resize(rows, cols);
+}
+
+VirtualScreen::Cell VirtualScreen::blankCell() {
+    return makeCell(" ", 1, {});
+}
+
+std::unique_ptr<Surface> VirtualScreen::createWindow(int windowRows, int windowCols, int y, int x) {
+    return std::make_unique<VirtualSurface>(*this, windowRows, windowCols, y, x, false);
+}
+
+std::unique_ptr<Surface> VirtualScreen::createPad(int padRows, int padCols) {
+    return std::make_unique<VirtualSurface>(*this, padRows, padCols, 0, 0, true);
+}
+
+void VirtualScreen::resize(int newRows, int newCols) {
+    rows = newRows;
+    cols = newCols;
+    // An impossible glyph in the front buffer makes the first flush repaint everything
+    Cell unknown;
+    unknown.glyph = 0;
+    front.assign(static_cast<size_t>(rows) * cols, unknown);
+    back.assign(static_cast<size_t>(rows) * cols, blankCell());
+    staged = true;
+}
+
+void VirtualScreen::clear() {
+    std::fill(back.begin(), back.end(), blankCell());
+    staged = true;
+}
+
+void VirtualScreen::stageCells(const Cell *cells, int count, int y, int x) {
+    if (y < 0 || y >= rows) return;
+    int from = std::max(0, -x);
+    int to = std::min(count, cols - x);
+    for (int i = from; i < to; i++) {
+        back[static_cast<size_t>(y) * cols + x + i] = cells[i];
+    }
+    staged = true;
+}
+
+void VirtualScreen::flush() {
+    if (!staged) return;
+    staged = false;
+
+    size_t bytes = 0;
+    int cursorY = -1;
+    int cursorX = -1;
+    Cell style;
+    style.colorPair = -1;
+
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            size_t index = static_cast<size_t>(y) * cols + x;
+            const Cell &cell = back[index];
+            if (cell == front[index] || cell.width == 0) {
+                continue;
+            }
+
+            if (y != cursorY || x != cursorX) {
+                bytes += cursorMoveBytes(y, x);
+            }
+            if (cell.colorPair != style.colorPair || cell.bold != style.bold) {
+                bytes += styleBytes(cell);
+                style = cell;
+            }
+            bytes += cell.bytes;
+            stats.cellsChanged++;
+
+            front[index] = cell;
+            if (cell.width == 2 && x + 1 < cols) {
+                front[index + 1] = back[index + 1];
+            }
+            cursorY = y;
+            cursorX = x + cell.width;
+        }
+    }
+
+    stats.flushes++;
+    stats.bytes += bytes;
+    stats.lastFlushBytes = bytes;
+}
@@ -0,0 +1,58 @@
+#include "include/WorkQueue.h"
+
+WorkQueue::WorkQueue(size_t threads) {
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([this] { run(); });
+    }
+}
+
+WorkQueue::~WorkQueue() {
+    stop();
+}
+
+void WorkQueue::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return;
+        }
+        tasks.push_back(std::move(task));
+    }
+    available.notify_one();
+}
+
+void WorkQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        tasks.clear();
+    }
+    available.notify_all();
+    for (std::thread &worker: workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+size_t WorkQueue::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+}
+
+void WorkQueue::run() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
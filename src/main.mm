@@ -3,44 +3,38 @@
 #import <dispatch/dispatch.h>
 #import <termios.h>
 #import <stdio.h>
-#import <sys/select.h>
 #import <unistd.h>
 #import "include/MediaRemote.h"
 #import "include/Config.h"
 #import "include/Logger.h"
 #import "include/CommandLine.h"
 #import "include/Credentials.h"
+#import "include/KeyboardInput.h"
+#import "include/LyricsManager.h"
+#import "include/EventLoop.h"
+#import "include/LastFmScrobbler.h"
 
-bool kbhit() {
-    struct timeval tv{};
-    fd_set fds;
-    tv.tv_sec = 0;
-    tv.tv_usec = 0;
-    FD_ZERO(&fds);
-    FD_SET(STDIN_FILENO, &fds);
-    select(STDIN_FILENO+1, &fds, nullptr, nullptr, &tv);
-    return FD_ISSET(STDIN_FILENO, &fds);
-}
+void handleKeyboardCommand(const KeyEvent &event) {
+    if (event.type != KeyEvent::Type::CHARACTER) {
+        return;
+    }
 
-void handleKeyboardCommands() {
-    if (kbhit()) {
-        char c = (char) getchar();
-        if (c == 's' || c == 'S') {
-            bool enabled = Config::getInstance().toggleScrobbling();
-            if (enabled) {
-                printf("\rScrobbling: Enabled  \n");
-            } else {
-                printf("\rScrobbling: Disabled \n");
-            }
-        } else if (c == 'h' || c == 'H' || c == '?') {
-            printf("\rAvailable commands:\n");
-            printf("  s - Toggle scrobbling on/off\n");
-            printf("  q - Quit application\n");
-            printf("  h - Show this help\n");
-        } else if (c == 'q' || c == 'Q') {
-            printf("\rQuitting...\n");
-            exit(0);
+    char c = event.character;
+    if (c == 's' || c == 'S') {
+        bool enabled = Config::getInstance().toggleScrobbling();
+        if (enabled) {
+            printf("\rScrobbling: Enabled  \n");
+        } else {
+            printf("\rScrobbling: Disabled \n");
         }
+    } else if (c == 'h' || c == 'H' || c == '?') {
+        printf("\rAvailable commands:\n");
+        printf("  s - Toggle scrobbling on/off\n");
+        printf("  q - Quit application\n");
+        printf("  h - Show this help\n");
+    } else if (c == 'q' || c == 'Q') {
+        printf("\rQuitting...\n");
+        exit(0);
     }
 }
 
@@ -73,26 +67,23 @@ int main(int argc, char *argv[]) {
             return 1;
         }
 
+        // Scrobbles queued while Last.fm was unreachable during an earlier run
+        LastFmScrobbler::getInstance().scheduleQueueFlush(0);
+
         MediaRemote bridge;
         bridge.registerForNowPlayingNotifications();
 
         LOG_INFO("Scrobbler is running...");
         
         if (!Config::getInstance().isDaemonMode()) {
-            // Create a timer to check for keyboard input every 100ms
-            dispatch_source_t keyboardTimer = dispatch_source_create(
-                DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue()
-            );
-            dispatch_source_set_timer(
-                keyboardTimer, dispatch_time(DISPATCH_TIME_NOW, 0), 
-                100 * NSEC_PER_MSEC, 0
-            );
-            dispatch_source_set_event_handler(keyboardTimer, ^{
-                handleKeyboardCommands();
+            // Keys go to the lyrics view while it is on screen, otherwise to the console commands
+            KeyboardInput::getInstance().start([](const KeyEvent &event) {
+                if (!LyricsManager::getInstance().handleKey(event)) {
+                    handleKeyboardCommand(event);
+                }
             });
-            dispatch_resume(keyboardTimer);
         }
-        
-        CFRunLoopRun();
+
+        EventLoop::getInstance().run();
     }
 }
\ No newline at end of file
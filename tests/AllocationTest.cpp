@@ -0,0 +1,103 @@
+// Building and signing a scrobble request from the cached credentials, counted with a global operator new:
+// once the body buffer has grown to fit, a request must not allocate at all.
+
+#include "include/Config.h"
+#include "include/CredentialStore.h"
+#include "include/Credentials.h"
+#include "include/ScrobbleQueue.h"
+#include "include/UrlUtils.h"
+#include "tests/Check.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+
+namespace {
+    std::atomic<uint64_t> allocations{0};
+
+    class MemoryStore : public CredentialStore {
+    public:
+        explicit MemoryStore(std::map<std::string, std::string> values) : values(std::move(values)) {}
+
+        std::string load(const std::string &account) override { return values[account]; }
+
+        bool save(const std::string &account, const std::string &value) override {
+            values[account] = value;
+            return true;
+        }
+
+    private:
+        std::map<std::string, std::string> values;
+    };
+
+    /**
+     * @brief What LastFmScrobbler::drainQueue and submitScrobble do before the request goes out.
+     */
+    bool buildScrobble(const ScrobbleQueue::Entry &entry, std::string &body) {
+        std::shared_ptr<const Credentials::Secrets> secrets = Credentials::snapshot();
+        return UrlUtils::encodeScrobble(entry, *secrets, body);
+    }
+}
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+int main() {
+    Config &config = Config::getInstance();
+    config.setQuietMode(true);
+
+    Credentials::setStore(std::make_unique<MemoryStore>(std::map<std::string, std::string>{
+            {config.getKeychainApiKeyAccount(), "0123456789abcdef0123456789abcdef"},
+            {config.getKeychainSecretAccount(), "fedcba9876543210fedcba9876543210"},
+            {config.getKeychainSessionKeyAccount(), "session-key-0123456789abcdef"},
+    }));
+    CHECK(Credentials::getInstance().checkAndPrompt());
+
+    ScrobbleQueue::Entry entries[] = {
+            {"Ryuichi Sakamoto", "Merry Christmas Mr. Lawrence", "Coda", 290.0, 1700000000},
+            {"宇多田ヒカル", "First Love", "", 0.0, 1700000300},
+            {"Björk", "Jóga", "Homogenic", 305.0, 1700000600},
+    };
+    std::string body;
+
+    // Warm-up grows the body to the longest request it will hold; seeing it allocate shows the counter is live
+    uint64_t warmUp = allocations.load();
+    for (const ScrobbleQueue::Entry &entry: entries) {
+        CHECK(buildScrobble(entry, body));
+    }
+    CHECK(allocations.load() > warmUp);
+
+    const int requests = 1000;
+    uint64_t before = allocations.load();
+    int built = 0;
+    for (int i = 0; i < requests; i++) {
+        if (buildScrobble(entries[i % 3], body)) {
+            built++;
+        }
+    }
+    uint64_t counted = allocations.load() - before;
+
+    std::printf("scrobble request build and sign: %llu allocations over %d requests\n",
+                static_cast<unsigned long long>(counted), requests);
+    CHECK_EQ(counted, 0u);
+    CHECK_EQ(built, requests);
+    CHECK(body.find("sk=session-key-0123456789abcdef") != std::string::npos);
+
+    return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+// ApiResponse on Last.fm responses as recorded from the API: a track.search page, auth.getToken,
+// auth.getSession, a scrobble acknowledgement and an error. Each is read the way the app reads it, through the
+// single pass ApiResponse makes on construction, and the same reads are done on a full DOM the way they were
+// before ApiResponse. Both must agree; prints time per response for each.
+
+#include "include/ApiResponse.h"
+#include "tests/Check.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    using json = nlohmann::json;
+
+    const char *const SEARCH = R"json({"results":{"opensearch:Query":{"#text":"","role":"request","searchTerms":"first love","startPage":"1"},"opensearch:totalResults":"51213","opensearch:startIndex":"0","opensearch:itemsPerPage":"10","trackmatches":{"track":[
+{"name":"First Love","artist":"宇多田ヒカル","url":"https://www.last.fm/music/%E5%AE%87%E5%A4%9A%E7%94%B0%E3%83%92%E3%82%AB%E3%83%AB/_/First+Love","streamable":"FIXME","listeners":"412893","image":[{"#text":"https://lastfm.freetls.fastly.net/i/u/34s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"small"},{"#text":"https://lastfm.freetls.fastly.net/i/u/64s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"medium"},{"#text":"https://lastfm.freetls.fastly.net/i/u/174s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"large"},{"#text":"https://lastfm.freetls.fastly.net/i/u/300x300/2a96cbd8b46e442fc41c2b86b821562f.png","size":"extralarge"}],"mbid":""},
+{"name":"First Love","artist":"Hikaru Utada","url":"https://www.last.fm/music/Hikaru+Utada/_/First+Love","streamable":"FIXME","listeners":"216408","image":[{"#text":"https://lastfm.freetls.fastly.net/i/u/34s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"small"},{"#text":"https://lastfm.freetls.fastly.net/i/u/64s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"medium"},{"#text":"https://lastfm.freetls.fastly.net/i/u/174s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"large"},{"#text":"https://lastfm.freetls.fastly.net/i/u/300x300/2a96cbd8b46e442fc41c2b86b821562f.png","size":"extralarge"}],"mbid":"b7e0b1c4-9d43-4b4e-8a6b-4f1c5bd7e1f0"},
+{"name":"First Love","artist":"Nikka Costa","url":"https://www.last.fm/music/Nikka+Costa/_/First+Love","streamable":"FIXME","listeners":"98211","image":[{"#text":"https://lastfm.freetls.fastly.net/i/u/34s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"small"},{"#text":"https://lastfm.freetls.fastly.net/i/u/64s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"medium"},{"#text":"https://lastfm.freetls.fastly.net/i/u/174s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"large"},{"#text":"https://lastfm.freetls.fastly.net/i/u/300x300/2a96cbd8b46e442fc41c2b86b821562f.png","size":"extralarge"}],"mbid":""},
+{"name":"First Love","artist":"Adele","url":"https://www.last.fm/music/Adele/_/First+Love","streamable":"FIXME","listeners":"331570","image":[{"#text":"https://lastfm.freetls.fastly.net/i/u/34s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"small"},{"#text":"https://lastfm.freetls.fastly.net/i/u/64s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"medium"},{"#text":"https://lastfm.freetls.fastly.net/i/u/174s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"large"},{"#text":"https://lastfm.freetls.fastly.net/i/u/300x300/2a96cbd8b46e442fc41c2b86b821562f.png","size":"extralarge"}],"mbid":"6a5f1d12-2b62-4a4e-b8a5-0e0ff1c8d5b2"},
+{"name":"First Love (Remastered)","artist":"宇多田ヒカル","url":"https://www.last.fm/music/%E5%AE%87%E5%A4%9A%E7%94%B0%E3%83%92%E3%82%AB%E3%83%AB/_/First+Love+(Remastered)","streamable":"FIXME","listeners":"57302","image":[{"#text":"https://lastfm.freetls.fastly.net/i/u/34s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"small"},{"#text":"https://lastfm.freetls.fastly.net/i/u/64s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"medium"},{"#text":"https://lastfm.freetls.fastly.net/i/u/174s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"large"},{"#text":"https://lastfm.freetls.fastly.net/i/u/300x300/2a96cbd8b46e442fc41c2b86b821562f.png","size":"extralarge"}],"mbid":""},
+{"name":"First Love","artist":"Jennifer Lopez","url":"https://www.last.fm/music/Jennifer+Lopez/_/First+Love","streamable":"FIXME","listeners":"61840","image":[{"#text":"https://lastfm.freetls.fastly.net/i/u/34s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"small"},{"#text":"https://lastfm.freetls.fastly.net/i/u/64s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"medium"},{"#text":"https://lastfm.freetls.fastly.net/i/u/174s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"large"},{"#text":"https://lastfm.freetls.fastly.net/i/u/300x300/2a96cbd8b46e442fc41c2b86b821562f.png","size":"extralarge"}],"mbid":""},
+{"name":"First Love / Late Spring","artist":"Mitski","url":"https://www.last.fm/music/Mitski/_/First+Love+%2F+Late+Spring","streamable":"FIXME","listeners":"687095","image":[{"#text":"https://lastfm.freetls.fastly.net/i/u/34s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"small"},{"#text":"https://lastfm.freetls.fastly.net/i/u/64s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"medium"},{"#text":"https://lastfm.freetls.fastly.net/i/u/174s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"large"},{"#text":"https://lastfm.freetls.fastly.net/i/u/300x300/2a96cbd8b46e442fc41c2b86b821562f.png","size":"extralarge"}],"mbid":"0c6b1f4e-7e1a-4d3e-9a6f-2f5c0e6b8d11"},
+{"name":"First Love","artist":"The Kid LAROI","url":"https://www.last.fm/music/The+Kid+LAROI/_/First+Love","streamable":"FIXME","listeners":"12","image":[{"#text":"https://lastfm.freetls.fastly.net/i/u/34s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"small"},{"#text":"https://lastfm.freetls.fastly.net/i/u/64s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"medium"},{"#text":"https://lastfm.freetls.fastly.net/i/u/174s/2a96cbd8b46e442fc41c2b86b821562f.png","size":"large"},{"#text":"https://lastfm.freetls.fastly.net/i/u/300x300/2a96cbd8b46e442fc41c2b86b821562f.png","size":"extralarge"}],"mbid":""}
+]},"@attr":{"for":"first love"}}})json";
+
+    const char *const TOKEN = R"({"token":"cf45fe5a3e3cebe168480a086d7fe481"})";
+
+    const char *const SESSION =
+            R"({"session":{"subscriber":0,"name":"listener","key":"d580d57f32848f5dcf574d1ce18d78b2"}})";
+
+    const char *const SCROBBLE = R"({"scrobbles":{"scrobble":{"artist":{"corrected":"0","#text":"宇多田ヒカル"},)"
+                                 R"("album":{"corrected":"0","#text":"First Love"},"track":{"corrected":"0",)"
+                                 R"("#text":"First Love"},"ignoredMessage":{"code":"0","#text":""},)"
+                                 R"("albumArtist":{"corrected":"0","#text":""},"timestamp":"1760861761"},)"
+                                 R"("@attr":{"ignored":0,"accepted":1}}})";
+
+    const char *const ERROR = R"({"message":"Invalid session key - Please re-authenticate","error":9})";
+
+    /**
+     * @brief What the app reads from a response: the error fields, the token, the session key and the matches.
+     */
+    struct Reading {
+        int errorCode = 0;
+        std::string errorMessage;
+        std::string token;
+        std::string sessionKey;
+        std::vector<ApiResponse::TrackMatch> matches;
+    };
+
+    Reading readOnce(const std::string &body) {
+        ApiResponse response(body);
+        Reading reading;
+        reading.errorCode = response.getErrorCode();
+        reading.errorMessage = response.getErrorMessage();
+        reading.token = response.field("token");
+        reading.sessionKey = response.field("session.key");
+        reading.matches = response.trackMatches();
+        return reading;
+    }
+
+    /**
+     * @brief The same reads on a DOM, as UrlUtils, Credentials and LastFmScrobbler did before ApiResponse.
+     */
+    Reading readDom(const std::string &body) {
+        json document = json::parse(body, nullptr, false);
+        Reading reading;
+        if (document.contains("error")) {
+            reading.errorCode = document["error"].get<int>();
+            reading.errorMessage = document.value("message", "");
+        }
+        reading.token = document.value("token", "");
+        if (document.contains("session")) {
+            reading.sessionKey = document["session"].value("key", "");
+        }
+        if (document.contains("results")) {
+            for (const json &track: document["results"]["trackmatches"]["track"]) {
+                reading.matches.push_back({track["name"].get<std::string>(), track["artist"].get<std::string>(),
+                                           std::stoi(track["listeners"].get<std::string>())});
+            }
+        }
+        return reading;
+    }
+
+    bool same(const Reading &a, const Reading &b) {
+        if (a.errorCode != b.errorCode || a.errorMessage != b.errorMessage || a.token != b.token ||
+            a.sessionKey != b.sessionKey || a.matches.size() != b.matches.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.matches.size(); i++) {
+            if (a.matches[i].name != b.matches[i].name || a.matches[i].artist != b.matches[i].artist ||
+                a.matches[i].listeners != b.matches[i].listeners) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename Read>
+    double microsecondsPerRun(int runs, Read read) {
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; i++) {
+            read();
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - begin;
+        return elapsed.count() / runs;
+    }
+}
+
+int main() {
+    const int runs = 2000;
+    struct Recorded {
+        const char *name;
+        std::string body;
+    } responses[] = {
+            {"track.search", SEARCH},
+            {"auth.getToken", TOKEN},
+            {"auth.getSession", SESSION},
+            {"track.scrobble", SCROBBLE},
+            {"error", ERROR},
+    };
+
+    Reading search = readOnce(SEARCH);
+    CHECK_EQ(search.matches.size(), 8u);
+    CHECK(search.matches[0].artist == "宇多田ヒカル");
+    CHECK_EQ(search.matches[6].listeners, 687095);
+    CHECK(readOnce(TOKEN).token == "cf45fe5a3e3cebe168480a086d7fe481");
+    CHECK(readOnce(SESSION).sessionKey == "d580d57f32848f5dcf574d1ce18d78b2");
+    CHECK_EQ(readOnce(ERROR).errorCode, 9);
+    CHECK(ApiResponse(SCROBBLE).ok());
+    CHECK(ApiResponse(SCROBBLE).field("scrobbles.@attr.accepted") == "1");
+
+    size_t sink = 0;
+    double onceTotal = 0.0;
+    double domTotal = 0.0;
+    for (const Recorded &recorded: responses) {
+        CHECK(same(readOnce(recorded.body), readDom(recorded.body)));
+
+        double onceUs = microsecondsPerRun(runs, [&] { sink += readOnce(recorded.body).matches.size(); });
+        double domUs = microsecondsPerRun(runs, [&] { sink += readDom(recorded.body).matches.size(); });
+        std::printf("%-16s %5zu bytes: one pass %6.2f us, DOM %6.2f us\n", recorded.name, recorded.body.size(),
+                    onceUs, domUs);
+        onceTotal += onceUs;
+        domTotal += domUs;
+    }
+
+    std::printf("all responses: one pass %.2f us, DOM %.2f us, %.1fx faster\n", onceTotal, domTotal,
+                domTotal / onceTotal);
+    CHECK(sink > 0);
+    CHECK(onceTotal < domTotal);
+
+    return checkFailures() == 0 ? 0 : 1;
+}
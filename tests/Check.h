@@ -0,0 +1,37 @@
+#ifndef BETTERSCROBBLER_TESTS_CHECK_H
+#define BETTERSCROBBLER_TESTS_CHECK_H
+
+#include <iostream>
+#include <sstream>
+
+/**
+ * @brief Minimal assertions for the test executables: a failed check is reported and counted,
+ * and the test's main returns checkFailures() so ctest sees the result.
+ */
+inline int &checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                              \
+    do {                                                                                              \
+        if (!(condition)) {                                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+            checkFailures()++;                                                                        \
+        }                                                                                             \
+    } while (false)
+
+#define CHECK_EQ(actual, expected)                                                                    \
+    do {                                                                                              \
+        const auto &checkActual = (actual);                                                           \
+        const auto &checkExpected = (expected);                                                       \
+        if (!(checkActual == checkExpected)) {                                                        \
+            std::ostringstream checkMessage;                                                          \
+            checkMessage << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", " #expected ") "  \
+                         << "got " << checkActual << ", expected " << checkExpected;                  \
+            std::cerr << checkMessage.str() << std::endl;                                             \
+            checkFailures()++;                                                                        \
+        }                                                                                             \
+    } while (false)
+
+#endif //BETTERSCROBBLER_TESTS_CHECK_H
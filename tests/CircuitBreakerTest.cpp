@@ -0,0 +1,141 @@
+// CircuitBreaker's state machine on a FakeClock: opening after FAILURE_THRESHOLD failures or on a Retry-After,
+// the single half-open probe, the open period doubling up to MAX_OPEN_MS, and a probe given back by onAbandoned().
+
+#include "include/CircuitBreaker.h"
+#include "include/Clock.h"
+#include "include/Config.h"
+#include "tests/Check.h"
+#include <algorithm>
+
+namespace {
+    using State = CircuitBreaker::State;
+
+    void failUntilOpen(CircuitBreaker &breaker) {
+        for (int i = 0; i < CircuitBreaker::FAILURE_THRESHOLD; i++) {
+            CHECK(breaker.allowRequest());
+            breaker.onFailure();
+        }
+    }
+
+    void testOpensAfterThreshold() {
+        FakeClock clock;
+        CircuitBreaker breaker("ws.audioscrobbler.com", clock);
+
+        for (int i = 0; i < CircuitBreaker::FAILURE_THRESHOLD - 1; i++) {
+            breaker.onFailure();
+        }
+        CHECK(breaker.getState() == State::CLOSED);
+        // A success in between starts the count over
+        breaker.onSuccess();
+        breaker.onFailure();
+        CHECK(breaker.getState() == State::CLOSED);
+        breaker.onSuccess();
+
+        failUntilOpen(breaker);
+        CHECK(breaker.getState() == State::OPEN);
+        CHECK(breaker.isOpen());
+        CHECK(!breaker.allowRequest());
+        CHECK_EQ(breaker.getRejectedCount(), 1u);
+        CHECK_EQ(breaker.msUntilRetry(), CircuitBreaker::BASE_OPEN_MS);
+
+        clock.advance(CircuitBreaker::BASE_OPEN_MS - 1);
+        CHECK(!breaker.allowRequest());
+        CHECK_EQ(breaker.msUntilRetry(), 1);
+    }
+
+    void testHalfOpenProbe() {
+        FakeClock clock;
+        CircuitBreaker breaker("ws.audioscrobbler.com", clock);
+        failUntilOpen(breaker);
+        clock.advance(CircuitBreaker::BASE_OPEN_MS);
+        CHECK(!breaker.isOpen());
+
+        // Exactly one probe goes through
+        CHECK(breaker.allowRequest());
+        CHECK(breaker.getState() == State::HALF_OPEN);
+        CHECK(breaker.isOpen());
+        CHECK(!breaker.allowRequest());
+
+        breaker.onSuccess();
+        CHECK(breaker.getState() == State::CLOSED);
+        CHECK(breaker.allowRequest());
+        CHECK(breaker.allowRequest());
+    }
+
+    void testFailedProbeDoubles() {
+        FakeClock clock;
+        CircuitBreaker breaker("ws.audioscrobbler.com", clock);
+        failUntilOpen(breaker);
+
+        int64_t expected = CircuitBreaker::BASE_OPEN_MS;
+        for (int i = 0; i < 8; i++) {
+            clock.advance(expected);
+            CHECK(breaker.allowRequest());
+            breaker.onFailure();
+            expected = std::min(expected * 2, CircuitBreaker::MAX_OPEN_MS);
+            CHECK(breaker.getState() == State::OPEN);
+            CHECK_EQ(breaker.msUntilRetry(), expected);
+        }
+        CHECK_EQ(expected, CircuitBreaker::MAX_OPEN_MS);
+
+        // Recovery resets the ladder
+        clock.advance(expected);
+        CHECK(breaker.allowRequest());
+        breaker.onSuccess();
+        failUntilOpen(breaker);
+        CHECK_EQ(breaker.msUntilRetry(), CircuitBreaker::BASE_OPEN_MS);
+    }
+
+    void testRetryAfter() {
+        FakeClock clock;
+        CircuitBreaker breaker("ws.audioscrobbler.com", clock);
+
+        // One answer with a pause is enough, and it sets the length
+        CHECK(breaker.allowRequest());
+        breaker.onFailure(12000);
+        CHECK(breaker.getState() == State::OPEN);
+        CHECK_EQ(breaker.msUntilRetry(), 12000);
+
+        clock.advance(12000);
+        CHECK(breaker.allowRequest());
+        breaker.onFailure(24 * 60 * 60 * 1000);
+        CHECK_EQ(breaker.msUntilRetry(), CircuitBreaker::MAX_OPEN_MS);
+    }
+
+    void testAbandonedProbe() {
+        FakeClock clock;
+        CircuitBreaker breaker("ws.audioscrobbler.com", clock);
+        failUntilOpen(breaker);
+        clock.advance(CircuitBreaker::BASE_OPEN_MS);
+
+        // A cancelled probe says nothing about the host, so the next caller gets to probe instead
+        CHECK(breaker.allowRequest());
+        CHECK(!breaker.allowRequest());
+        breaker.onAbandoned();
+        CHECK(breaker.getState() == State::HALF_OPEN);
+        CHECK(!breaker.isOpen());
+        CHECK(breaker.allowRequest());
+        breaker.onFailure();
+        CHECK_EQ(breaker.msUntilRetry(), CircuitBreaker::BASE_OPEN_MS * 2);
+    }
+
+    void testHostOf() {
+        CHECK(CircuitBreaker::hostOf("https://ws.audioscrobbler.com/2.0/?method=x") == "ws.audioscrobbler.com");
+        CHECK(CircuitBreaker::hostOf("http://127.0.0.1:8080?x") == "127.0.0.1:8080");
+        CHECK(CircuitBreaker::hostOf("lrclib.net") == "lrclib.net");
+        CHECK(&CircuitBreaker::forUrl("https://lrclib.net/api/get") == &CircuitBreaker::forUrl("https://lrclib.net/"));
+    }
+}
+
+int main() {
+    Config::getInstance().setQuietMode(true);
+
+    testOpensAfterThreshold();
+    testHalfOpenProbe();
+    testFailedProbeDoubles();
+    testRetryAfter();
+    testAbandonedProbe();
+    testHostOf();
+
+    return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// Credentials after Last.fm rejects the session key: no further store reads, and nothing handed out, until a new key.
+// Once loaded, the secrets a request needs are a pointer copy, and a held snapshot stays intact when replaced.
+
+#include "include/Config.h"
+#include "include/CredentialStore.h"
+#include "include/Credentials.h"
+#include "tests/Check.h"
+#include <map>
+#include <memory>
+#include <string>
+
+namespace {
+    class MemoryStore : public CredentialStore {
+    public:
+        explicit MemoryStore(std::map<std::string, std::string> &values, int &loads) : values(values), loads(loads) {}
+
+        std::string load(const std::string &account) override {
+            loads++;
+            return values[account];
+        }
+
+        bool save(const std::string &account, const std::string &value) override {
+            values[account] = value;
+            return true;
+        }
+
+    private:
+        std::map<std::string, std::string> &values;
+        int &loads;
+    };
+}
+
+int main() {
+    Config &config = Config::getInstance();
+    config.setQuietMode(true);
+    const std::string &account = config.getKeychainSessionKeyAccount();
+
+    std::map<std::string, std::string> values{{account, "rejected-key"},
+                                              {config.getKeychainApiKeyAccount(), "api-key"},
+                                              {config.getKeychainSecretAccount(), "api-secret"}};
+    int loads = 0;
+    Credentials::setStore(std::make_unique<MemoryStore>(values, loads));
+
+    std::shared_ptr<const Credentials::Secrets> secrets = Credentials::apiSecrets();
+    CHECK(secrets->apiKey == "api-key");
+    CHECK(secrets->apiSecret == "api-secret");
+    CHECK_EQ(loads, 2);
+    for (int i = 0; i < 5; i++) {
+        CHECK(Credentials::apiSecrets() == Credentials::snapshot());
+    }
+    CHECK_EQ(loads, 2);
+
+    CHECK(Credentials::hasSessionKey());
+    CHECK_EQ(loads, 3);
+    CHECK(Credentials::hasSessionKey());
+    CHECK_EQ(loads, 3);
+
+    // A request still holding the old snapshot keeps reading the values it started with
+    std::shared_ptr<const Credentials::Secrets> held = Credentials::snapshot();
+    Credentials::invalidateSessionKey();
+    CHECK(Credentials::isSessionRejected());
+    CHECK_EQ(values[account], std::string(""));
+    CHECK(held->sessionKey == "rejected-key");
+    CHECK(Credentials::snapshot()->sessionKey.empty());
+    CHECK(Credentials::snapshot()->apiKey == "api-key");
+    CHECK(!Credentials::hasSessionKey());
+    held.reset();
+
+    // The store is not asked again, so the rejected key cannot come back from it
+    values[account] = "rejected-key";
+    for (int i = 0; i < 5; i++) {
+        CHECK_EQ(Credentials::loadSessionKey(), std::string(""));
+    }
+    CHECK_EQ(loads, 3);
+
+    Credentials::saveSessionKey("new-key");
+    CHECK(!Credentials::isSessionRejected());
+    CHECK_EQ(Credentials::loadSessionKey(), std::string("new-key"));
+    CHECK_EQ(values[account], std::string("new-key"));
+
+    return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+// Frame time of the lyrics UI on a VirtualScreen, driven the way LyricsManager::displayFrame drives it:
+// header every tick, lyrics body when the current line moves, one flush. Reports p50/p99 frame time and the
+// bytes a terminal would receive per frame, for Latin and CJK lyrics at several terminal sizes.
+
+#include "include/HeaderView.h"
+#include "include/LrcParser.h"
+#include "include/LyricCursor.h"
+#include "include/LyricTimeline.h"
+#include "include/LyricsView.h"
+#include "include/VirtualScreen.h"
+#include "tests/Check.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Size {
+        int rows;
+        int cols;
+    };
+
+    struct FrameStats {
+        double p50Us = 0.0;
+        double p99Us = 0.0;
+        double bytesPerFrame = 0.0;
+        size_t p99Bytes = 0;
+        size_t firstFrameBytes = 0;
+    };
+
+    /**
+     * @brief A line every three seconds for the length of the track, some wider than an 80-column terminal.
+     */
+    std::string makeLyrics(const char *const *phrases, size_t phraseCount, int durationSeconds) {
+        std::string lrc;
+        char tag[32];
+        for (int second = 3, i = 0; second < durationSeconds; second += 3, i++) {
+            std::snprintf(tag, sizeof(tag), "[%02d:%02d.00]", second / 60, second % 60);
+            lrc += tag;
+            lrc += phrases[i % phraseCount];
+            if (i % 4 == 3) {
+                lrc += " / ";
+                lrc += phrases[(i + 1) % phraseCount];
+            }
+            lrc += "\n";
+        }
+        return lrc;
+    }
+
+    template<typename T>
+    T percentile(std::vector<T> values, double p) {
+        std::sort(values.begin(), values.end());
+        return values[static_cast<size_t>(p * static_cast<double>(values.size() - 1))];
+    }
+
+    FrameStats playTrack(const LyricTimeline &lyrics, Size size, int durationSeconds) {
+        const int headerHeight = 5;
+        const int tickMs = 50;
+
+        VirtualScreen screen(size.rows, size.cols);
+        std::unique_ptr<Surface> headerSurface = screen.createWindow(headerHeight, size.cols, 0, 0);
+        std::unique_ptr<Surface> contentSurface =
+                screen.createWindow(size.rows - headerHeight - 1, size.cols, headerHeight, 0);
+        HeaderView header;
+        LyricsView view;
+        LyricCursor cursor;
+        view.attach(screen, *contentSurface);
+        view.setHint("[Auto] 'a':manual | [Scrobbling On] 's':toggle");
+        int visibleRows = view.getVisibleRows();
+        int current = -2;
+
+        std::vector<double> frameUs;
+        std::vector<size_t> frameBytes;
+        FrameStats stats;
+
+        for (int ms = 0; ms < durationSeconds * 1000; ms += tickMs) {
+            uint64_t flushesBefore = screen.getStats().flushes;
+            auto begin = std::chrono::steady_clock::now();
+
+            double elapsed = ms / 1000.0;
+            header.draw(*headerSurface, header.compute("Now Playing", "Artist", "Title", elapsed, durationSeconds,
+                                                       headerSurface->getCols()));
+            int index = cursor.update(lyrics, ms, 1.0);
+            if (index != current) {
+                current = index;
+                view.load(lyrics, LyricsView::Mode::Synced);
+                view.setCurrent(index);
+                view.present(std::max(0, index - visibleRows / 2));
+            }
+            screen.flush();
+
+            std::chrono::duration<double, std::micro> took = std::chrono::steady_clock::now() - begin;
+            frameUs.push_back(took.count());
+            size_t bytes = screen.getStats().flushes > flushesBefore ? screen.getStats().lastFlushBytes : 0;
+            if (ms == 0) {
+                stats.firstFrameBytes = bytes;
+            } else {
+                frameBytes.push_back(bytes);
+            }
+        }
+
+        stats.p50Us = percentile(frameUs, 0.50);
+        stats.p99Us = percentile(frameUs, 0.99);
+        size_t totalBytes = 0;
+        for (size_t bytes: frameBytes) {
+            totalBytes += bytes;
+        }
+        stats.bytesPerFrame = static_cast<double>(totalBytes) / static_cast<double>(frameBytes.size());
+        stats.p99Bytes = percentile(frameBytes, 0.99);
+        return stats;
+    }
+}
+
+int main() {
+    const char *const latin[] = {
+            "Walking down the avenue with nothing on my mind",
+            "And the city lights are singing every song I left behind",
+            "Hold on, hold on",
+            "Every night the river carries all the words we never said to anyone at all",
+    };
+    const char *const cjk[] = {
+            "君の名前を呼んでいた 夜が明けるまで",
+            "遠い街の灯りが 静かに揺れている",
+            "もう一度だけ",
+            "言えなかった言葉を 川がすべて運んでいく 誰にも届かないまま",
+    };
+    const int durationSeconds = 180;
+    const Size sizes[] = {{24, 80}, {40, 120}, {60, 200}};
+
+    struct Script {
+        const char *name;
+        LyricTimeline lyrics;
+    } scripts[] = {
+            {"latin", LyricTimeline::fromSynced(LrcDocument::parse(makeLyrics(latin, 4, durationSeconds)))},
+            {"cjk", LyricTimeline::fromSynced(LrcDocument::parse(makeLyrics(cjk, 4, durationSeconds)))},
+    };
+
+    for (const Script &script: scripts) {
+        for (Size size: sizes) {
+            FrameStats stats = playTrack(script.lyrics, size, durationSeconds);
+            std::printf("%-5s %3dx%-3d: frame p50 %6.1f us, p99 %6.1f us; %6.1f bytes/frame, p99 %zu, first %zu\n",
+                        script.name, size.cols, size.rows, stats.p50Us, stats.p99Us, stats.bytesPerFrame,
+                        stats.p99Bytes, stats.firstFrameBytes);
+
+            // After the first paint a frame only carries the clock, the bar and the lines that changed style
+            CHECK(stats.firstFrameBytes > 0);
+            CHECK(stats.p99Bytes * 2 < stats.firstFrameBytes);
+        }
+    }
+
+    return checkFailures() == 0 ? 0 : 1;
+}
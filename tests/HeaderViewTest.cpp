@@ -0,0 +1,125 @@
+// The Now Playing header over one simulated minute at the UI's 50 ms tick, drawn headless on a VirtualScreen.
+// Every Surface call stands for one curses call (mvwaddstr, wclrtoeol, wnoutrefresh, ...) and every flush for a
+// doupdate, so the counts show how much terminal work the header costs when only the clock and bar move.
+
+#include "include/HeaderView.h"
+#include "include/VirtualScreen.h"
+#include "tests/Check.h"
+#include <cstdio>
+#include <memory>
+
+namespace {
+    /**
+     * @brief Forwards to a real surface and counts the calls that would each be a curses call.
+     */
+    class CountingSurface : public Surface {
+    public:
+        explicit CountingSurface(std::unique_ptr<Surface> inner) : inner(std::move(inner)) {}
+
+        [[nodiscard]] int getRows() const override { return inner->getRows(); }
+        [[nodiscard]] int getCols() const override { return inner->getCols(); }
+        [[nodiscard]] int getOriginY() const override { return inner->getOriginY(); }
+        [[nodiscard]] int getOriginX() const override { return inner->getOriginX(); }
+
+        void resize(int rows, int cols) override {
+            calls++;
+            inner->resize(rows, cols);
+        }
+        void moveTo(int y, int x) override {
+            calls++;
+            inner->moveTo(y, x);
+        }
+        void erase() override {
+            calls++;
+            inner->erase();
+        }
+        void clearToEol(int y, int x) override {
+            calls++;
+            inner->clearToEol(y, x);
+        }
+        void drawBox(Style style) override {
+            calls++;
+            inner->drawBox(style);
+        }
+        int drawText(int y, int x, std::string_view text, Style style) override {
+            calls++;
+            return inner->drawText(y, x, text, style);
+        }
+        void drawGlyph(int y, int x, Glyph glyph, Style style, int count) override {
+            calls++;
+            inner->drawGlyph(y, x, glyph, style, count);
+        }
+        void touch() override {
+            calls++;
+            inner->touch();
+        }
+        void stage() override {
+            calls++;
+            inner->stage();
+        }
+        void stageRegion(int row, int col, int screenTop, int screenLeft, int screenBottom, int screenRight) override {
+            calls++;
+            inner->stageRegion(row, col, screenTop, screenLeft, screenBottom, screenRight);
+        }
+
+        uint64_t calls = 0;
+
+    private:
+        std::unique_ptr<Surface> inner;
+    };
+
+    struct MinuteCost {
+        uint64_t calls = 0;
+        uint64_t flushes = 0;
+        uint64_t bytes = 0;
+    };
+
+    /**
+     * @brief One minute from 1:00 into a 3:20 track. With repaintEveryTick the header is invalidated before each
+     * frame, which is what drawing it from scratch every tick used to cost.
+     */
+    MinuteCost playMinute(bool repaintEveryTick) {
+        const int cols = 120;
+        const int tickMs = 50;
+        const double duration = 200.0;
+
+        VirtualScreen screen(40, cols);
+        CountingSurface surface(screen.createWindow(5, cols, 0, 0));
+        HeaderView header;
+
+        for (int ms = 0; ms < 60 * 1000; ms += tickMs) {
+            double elapsed = 60.0 + ms / 1000.0;
+            if (repaintEveryTick) {
+                header.invalidate();
+            }
+            if (header.draw(surface, header.compute("Now Playing", "宇多田ヒカル", "First Love", elapsed, duration,
+                                                    surface.getCols()))) {
+                screen.flush();
+            }
+        }
+        return {surface.calls, screen.getStats().flushes, screen.getStats().bytes};
+    }
+}
+
+int main() {
+    MinuteCost incremental = playMinute(false);
+    MinuteCost repaint = playMinute(true);
+
+    std::printf("header per simulated minute: %llu surface calls, %llu flushes, %llu bytes "
+                "(full repaint: %llu calls, %llu flushes, %llu bytes)\n",
+                static_cast<unsigned long long>(incremental.calls),
+                static_cast<unsigned long long>(incremental.flushes),
+                static_cast<unsigned long long>(incremental.bytes),
+                static_cast<unsigned long long>(repaint.calls),
+                static_cast<unsigned long long>(repaint.flushes),
+                static_cast<unsigned long long>(repaint.bytes));
+
+    // 60 clock changes plus the bar head moving 112 * 60 / 200 = 33 cells, many on the same frame, and the first paint
+    CHECK(incremental.flushes <= 60 + 34 + 1);
+    CHECK_EQ(repaint.flushes, 1200u);
+    CHECK(incremental.calls * 10 < repaint.calls);
+    // The screen diff already kept a full repaint's output down to the changed cells; the saving is the calls
+    CHECK(incremental.bytes <= repaint.bytes);
+
+    return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+// Wakeups per idle hour: playback paused, so only the playback poll and the lyrics frame timer are armed.
+// A hand-driven EventLoop on a FakeClock runs the hour in milliseconds, and getWakeups() and getTimersFired()
+// say how often the process would have left its sleep. The timers are armed through PlaybackSchedule, the same
+// calls MediaRemote makes.
+
+#include "include/Clock.h"
+#include "include/Config.h"
+#include "include/EventLoop.h"
+#include "include/PlaybackSchedule.h"
+#include "tests/Check.h"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+namespace {
+    constexpr int64_t HOUR_MS = 60 * 60 * 1000;
+
+    struct IdleHour {
+        uint64_t wakeups = 0;
+        uint64_t timersFired = 0;
+    };
+
+    /**
+     * @param shareGrid true for PlaybackSchedule's idle frames, on the poll's whole-period grid;
+     * false for re-arming a frame a full interval after the last, the way it was done before the grid.
+     */
+    IdleHour runIdleHour(bool shareGrid) {
+        FakeClock clock;
+        EventLoop loop(clock, false);
+
+        EventLoop::TimerId poll = loop.createTimer([] {});
+        PlaybackSchedule::armPoll(loop, poll);
+
+        EventLoop::TimerId frame = 0;
+        // Paused, so LyricsManager::nextFrameDelay answers its cap on every frame
+        std::function<void()> scheduleIdleFrame = [&] {
+            if (shareGrid) {
+                PlaybackSchedule::armFrame(loop, frame, PlaybackSchedule::MAX_FRAME_INTERVAL);
+            } else {
+                loop.schedule(frame, static_cast<int64_t>(PlaybackSchedule::MAX_FRAME_INTERVAL * 1000));
+            }
+        };
+        frame = loop.createTimer([&] { scheduleIdleFrame(); });
+        // The lyrics UI opens partway through a poll period, as it does once the first track is resolved
+        loop.runAfter(437, [&] { loop.schedule(frame, 0); });
+
+        uint64_t wakeupsBefore = loop.getWakeups();
+        uint64_t firedBefore = loop.getTimersFired();
+        int64_t end = clock.nowMs() + HOUR_MS;
+        while (clock.nowMs() < end) {
+            int64_t next = loop.nextDeadline();
+            int64_t target = (next < 0 || next > end) ? end : std::max(next, clock.nowMs() + 1);
+            clock.advance(target - clock.nowMs());
+            loop.runDue();
+        }
+        return {loop.getWakeups() - wakeupsBefore, loop.getTimersFired() - firedBefore};
+    }
+}
+
+int main() {
+    Config::getInstance().setQuietMode(true);
+
+    IdleHour shared = runIdleHour(true);
+    IdleHour separate = runIdleHour(false);
+
+    std::printf("idle hour: %llu wakeups, %llu timers fired (own phase per timer: %llu wakeups, %llu timers fired)\n",
+                static_cast<unsigned long long>(shared.wakeups),
+                static_cast<unsigned long long>(shared.timersFired),
+                static_cast<unsigned long long>(separate.wakeups),
+                static_cast<unsigned long long>(separate.timersFired));
+
+    // Both timers still fire once a second, but in the same wakeup
+    CHECK(shared.timersFired >= 2 * 3600);
+    CHECK(shared.wakeups <= 3600 + 5);
+    CHECK(separate.wakeups >= 2 * 3600);
+
+    return checkFailures() == 0 ? 0 : 1;
+}
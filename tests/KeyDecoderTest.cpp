@@ -0,0 +1,141 @@
+// KeyDecoder on the byte sequences terminals send: CSI and SS3 keys, sequences split across reads, a bare
+// Escape resolved by flush(), Alt+key as ESC followed by the key, ESC ESC, and malformed input that must not
+// stall the keys after it.
+
+#include "include/KeyDecoder.h"
+#include "tests/Check.h"
+#include <string>
+#include <vector>
+
+namespace {
+    using Type = KeyEvent::Type;
+
+    /**
+     * @brief Events written out as "UP", "ESC" or "'x'", joined by spaces, so a whole run compares at once.
+     */
+    std::string describe(const std::vector<KeyEvent> &events) {
+        std::string text;
+        for (const KeyEvent &event: events) {
+            if (!text.empty()) text += ' ';
+            switch (event.type) {
+                case Type::CHARACTER: text += std::string("'") + event.character + "'"; break;
+                case Type::UP: text += "UP"; break;
+                case Type::DOWN: text += "DOWN"; break;
+                case Type::LEFT: text += "LEFT"; break;
+                case Type::RIGHT: text += "RIGHT"; break;
+                case Type::PAGE_UP: text += "PGUP"; break;
+                case Type::PAGE_DOWN: text += "PGDN"; break;
+                case Type::HOME: text += "HOME"; break;
+                case Type::END: text += "END"; break;
+                case Type::ESCAPE: text += "ESC"; break;
+                case Type::RESIZE: text += "RESIZE"; break;
+            }
+        }
+        return text;
+    }
+
+    /**
+     * @brief Feed each read in turn, as separate read() results would arrive.
+     */
+    std::string feed(KeyDecoder &decoder, const std::vector<std::string> &reads) {
+        std::vector<KeyEvent> events;
+        auto record = [&events](const KeyEvent &event) { events.push_back(event); };
+        for (const std::string &read: reads) {
+            decoder.feed(read.data(), read.size(), record);
+        }
+        return describe(events);
+    }
+
+    std::string flush(KeyDecoder &decoder) {
+        std::vector<KeyEvent> events;
+        decoder.flush([&events](const KeyEvent &event) { events.push_back(event); });
+        return describe(events);
+    }
+
+    void testSequences() {
+        KeyDecoder decoder;
+        CHECK_EQ(feed(decoder, {"ab"}), std::string("'a' 'b'"));
+        CHECK_EQ(feed(decoder, {"\x1b[A\x1b[B\x1b[C\x1b[D"}), std::string("UP DOWN RIGHT LEFT"));
+        CHECK_EQ(feed(decoder, {"\x1bOA\x1bOB\x1bOH\x1bOF"}), std::string("UP DOWN HOME END"));
+        CHECK_EQ(feed(decoder, {"\x1b[H\x1b[F"}), std::string("HOME END"));
+        CHECK_EQ(feed(decoder, {"\x1b[5~\x1b[6~"}), std::string("PGUP PGDN"));
+        CHECK_EQ(feed(decoder, {"\x1b[1~\x1b[7~\x1b[4~\x1b[8~"}), std::string("HOME HOME END END"));
+        // Modifiers ride in a second parameter and do not change the key
+        CHECK_EQ(feed(decoder, {"\x1b[1;5A\x1b[5;2~"}), std::string("UP PGUP"));
+        // Keys this decoder has no event for are swallowed whole
+        CHECK_EQ(feed(decoder, {"\x1b[Z\x1b[15~\x1bOPq"}), std::string("'q'"));
+        CHECK(!decoder.hasPending());
+    }
+
+    void testSplitAcrossReads() {
+        KeyDecoder decoder;
+        CHECK_EQ(feed(decoder, {"\x1b"}), std::string(""));
+        CHECK(decoder.hasPending());
+        CHECK_EQ(feed(decoder, {"["}), std::string(""));
+        CHECK_EQ(feed(decoder, {"A"}), std::string("UP"));
+        CHECK(!decoder.hasPending());
+
+        CHECK_EQ(feed(decoder, {"x\x1b[", "5", "~y"}), std::string("'x' PGUP 'y'"));
+        CHECK_EQ(feed(decoder, {"\x1bO", "B"}), std::string("DOWN"));
+        CHECK_EQ(feed(decoder, {"\x1b[1;", "5", "C"}), std::string("RIGHT"));
+        CHECK(!decoder.hasPending());
+    }
+
+    void testBareEscape() {
+        KeyDecoder decoder;
+        CHECK_EQ(flush(decoder), std::string(""));
+
+        CHECK_EQ(feed(decoder, {"\x1b"}), std::string(""));
+        CHECK_EQ(flush(decoder), std::string("ESC"));
+        CHECK(!decoder.hasPending());
+        CHECK_EQ(flush(decoder), std::string(""));
+
+        // Escape then '[' typed by hand: nothing more comes, so both are keys after all
+        CHECK_EQ(feed(decoder, {"\x1b["}), std::string(""));
+        CHECK_EQ(flush(decoder), std::string("ESC '['"));
+        CHECK_EQ(feed(decoder, {"\x1bO"}), std::string(""));
+        CHECK_EQ(flush(decoder), std::string("ESC 'O'"));
+
+        // After a flush the next bytes start fresh
+        CHECK_EQ(feed(decoder, {"[A"}), std::string("'[' 'A'"));
+    }
+
+    void testAltAndDoubleEscape() {
+        KeyDecoder decoder;
+        // Alt+key arrives as ESC followed by the key
+        CHECK_EQ(feed(decoder, {"\x1bj\x1bk"}), std::string("'j' 'k'"));
+        CHECK_EQ(feed(decoder, {"\x1b", "q"}), std::string("'q'"));
+
+        // ESC ESC is one Escape key, and the second ESC may still start a sequence
+        CHECK_EQ(feed(decoder, {"\x1b\x1b"}), std::string("ESC"));
+        CHECK(decoder.hasPending());
+        CHECK_EQ(feed(decoder, {"[A"}), std::string("UP"));
+        CHECK_EQ(feed(decoder, {"\x1b\x1b"}), std::string("ESC"));
+        CHECK_EQ(flush(decoder), std::string("ESC"));
+        CHECK_EQ(feed(decoder, {"\x1b\x1b\x1b"}), std::string("ESC ESC"));
+        CHECK_EQ(flush(decoder), std::string("ESC"));
+    }
+
+    void testMalformed() {
+        KeyDecoder decoder;
+        // A control byte inside CSI ends it; the byte itself is still delivered
+        CHECK_EQ(feed(decoder, {"\x1b[\x01z"}), std::string("'\x01' 'z'"));
+        CHECK(!decoder.hasPending());
+
+        // A parameter run longer than any real sequence is dropped rather than stalling input
+        CHECK_EQ(feed(decoder, {"\x1b[" + std::string(40, '1')}).find("UP"), std::string::npos);
+        feed(decoder, {"~"});
+        CHECK_EQ(feed(decoder, {"\x1b[Ax"}), std::string("UP 'x'"));
+        CHECK(!decoder.hasPending());
+    }
+}
+
+int main() {
+    testSequences();
+    testSplitAcrossReads();
+    testBareEscape();
+    testAltAndDoubleEscape();
+    testMalformed();
+
+    return checkFailures() == 0 ? 0 : 1;
+}
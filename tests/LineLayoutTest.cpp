@@ -0,0 +1,63 @@
+// The per-width layout cache must notice new lyrics even when they land in the same timeline object with the
+// same line count, which is how a track change replaces them, and must reuse a recent width after a resize.
+
+#include "include/LineLayout.h"
+#include "include/LyricTimeline.h"
+#include "tests/Check.h"
+#include <string>
+
+int main() {
+    LyricTimeline lyrics = LyricTimeline::fromPlain("a short line\na line that is far too long for ten columns");
+    LineLayout layout;
+    layout.build(lyrics, 10);
+    CHECK(layout.matches(lyrics, 10));
+    CHECK(!layout.matches(lyrics, 20));
+    CHECK(layout.isTruncated(1));
+
+    // Same address, same line count, different text
+    lyrics = LyricTimeline::fromPlain("short\nalso short");
+    CHECK(!layout.matches(lyrics, 10));
+    layout.build(lyrics, 10);
+    CHECK(!layout.isTruncated(1));
+    CHECK(std::string(layout.textAt(1)) == "also short");
+
+    lyrics.clear();
+    lyrics.append(0, "also short");
+    lyrics.append(0, "short");
+    CHECK(!layout.matches(lyrics, 10));
+
+    layout.clear();
+    CHECK(!layout.matches(lyrics, 10));
+
+    // Resizing back and forth lays out each width once
+    LyricTimeline song = LyricTimeline::fromPlain("one two three four five six seven eight nine ten\nshort");
+    LineLayout widths;
+    uint64_t before = widths.getComputedCount();
+    for (int pass = 0; pass < 3; pass++) {
+        for (int columns: {20, 30, 80}) {
+            widths.build(song, columns);
+            CHECK(widths.matches(song, columns));
+            CHECK_EQ(widths.isTruncated(0), columns < 48);
+        }
+    }
+    CHECK_EQ(widths.getComputedCount() - before, 3u);
+    CHECK(std::string(widths.textAt(0)) == "one two three four five six seven eight nine ten");
+    widths.build(song, 20);
+    CHECK(std::string(widths.textAt(0)) == "one two three fou");
+
+    // Only the most recent MAX_WIDTHS are kept
+    for (int columns = 40; columns < 40 + static_cast<int>(LineLayout::MAX_WIDTHS); columns++) {
+        widths.build(song, columns);
+    }
+    uint64_t full = widths.getComputedCount();
+    widths.build(song, 20);
+    CHECK_EQ(widths.getComputedCount(), full + 1);
+
+    // New lyrics drop every cached width
+    song = LyricTimeline::fromPlain("different\nlyrics");
+    widths.build(song, 30);
+    CHECK_EQ(widths.getComputedCount(), full + 2);
+    CHECK(!widths.isTruncated(0));
+
+    return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+// LrcDocument::parse against the std::regex parser it replaced, on the same synced lyrics.
+// Prints time per document for both; the linear parser has to agree with the old one and beat it.
+
+#include "include/LrcParser.h"
+#include "tests/Check.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    /**
+     * @brief The parser LyricsManager used before LrcDocument, minus its per-line debug log.
+     */
+    std::vector<std::pair<int, std::string>> parseWithRegex(const std::string &lyrics) {
+        std::vector<std::pair<int, std::string>> parsed;
+        std::regex timeTagRegex(R"(\[(\d+):(\d+)\.(\d+)\](.*))");
+        std::istringstream stream(lyrics);
+        std::string line;
+
+        parsed.emplace_back(0, " ");
+
+        while (std::getline(stream, line)) {
+            std::smatch matches;
+            if (std::regex_search(line, matches, timeTagRegex) && matches.size() > 4) {
+                int minutes = std::stoi(matches[1].str());
+                int seconds = std::stoi(matches[2].str());
+                int milliseconds = std::stoi(matches[3].str());
+                int totalMs = (minutes * 60 + seconds) * 1000 + milliseconds;
+                parsed.emplace_back(totalMs, matches[4].str());
+            }
+        }
+
+        std::sort(parsed.begin(), parsed.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        return parsed;
+    }
+
+    /**
+     * @brief A long song's worth of lines from 1s on, so the regex version's unstable sort keeps its lead-in first.
+     * Millisecond fractions, since it misread shorter ones.
+     */
+    std::string makeLyrics(int lineCount) {
+        std::string lyrics = "[ar:Artist]\n[ti:Title]\n";
+        char tag[32];
+        for (int i = 0; i < lineCount; i++) {
+            int ms = 1000 + i * 2750;
+            std::snprintf(tag, sizeof(tag), "[%02d:%02d.%03d]", ms / 60000, ms / 1000 % 60, ms % 1000);
+            lyrics += tag;
+            lyrics += i % 3 == 0 ? "君の名前を呼んでいた 夜が明けるまで" : "Line of a song that goes on for a while";
+            lyrics += " #" + std::to_string(i) + "\n";
+        }
+        return lyrics;
+    }
+
+    template<typename Parse>
+    double microsecondsPerRun(int runs, Parse parse) {
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; i++) {
+            parse();
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - begin;
+        return elapsed.count() / runs;
+    }
+}
+
+int main() {
+    const int lineCount = 400;
+    const int runs = 50;
+    std::string lyrics = makeLyrics(lineCount);
+
+    std::vector<std::pair<int, std::string>> expected = parseWithRegex(lyrics);
+    LrcDocument document = LrcDocument::parse(lyrics);
+    CHECK_EQ(document.getLines().size() + 1, expected.size());
+    for (size_t i = 0; i < document.getLines().size() && i + 1 < expected.size(); i++) {
+        CHECK_EQ(document.getLines()[i].timeMs, expected[i + 1].first);
+        CHECK(document.getLines()[i].text == expected[i + 1].second);
+    }
+
+    size_t sink = 0;
+    double regexUs = microsecondsPerRun(runs, [&] { sink += parseWithRegex(lyrics).size(); });
+    double linearUs = microsecondsPerRun(runs, [&] { sink += LrcDocument::parse(lyrics).getLines().size(); });
+
+    std::printf("lrc parse, %d lines (%zu bytes): regex %.1f us, linear %.1f us, %.1fx faster\n",
+                lineCount, lyrics.size(), regexUs, linearUs, regexUs / linearUs);
+    CHECK(sink > 0);
+    CHECK(linearUs < regexUs);
+
+    return checkFailures() == 0 ? 0 : 1;
+}
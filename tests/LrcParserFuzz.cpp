@@ -0,0 +1,124 @@
+// LrcDocument::parse on arbitrary bytes: every view must stay inside its line, lines must come out sorted,
+// and the timeline built from the document must carry the same lines and word timings.
+// Built with SCROBBLER_LIBFUZZER this is a libFuzzer target; otherwise main() feeds it seeded random tag soup.
+
+#include "include/LrcParser.h"
+#include "include/LyricTimeline.h"
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+    /**
+     * @brief Empty when the document and its timeline agree, otherwise what broke.
+     */
+    const char *checkDocument(const LrcDocument &document) {
+        const auto &lines = document.getLines();
+        const auto &words = document.getWords();
+        for (size_t i = 0; i < lines.size(); i++) {
+            const LrcDocument::Line &line = lines[i];
+            if (line.timeMs < 0) return "negative line time";
+            if (i > 0 && lines[i - 1].timeMs > line.timeMs) return "lines out of order";
+            if (static_cast<size_t>(line.firstWord) + line.wordCount > words.size()) return "word range out of bounds";
+            for (const auto *word = document.wordsBegin(line); word != document.wordsEnd(line); ++word) {
+                if (word->text.data() < line.text.data() ||
+                    word->text.data() + word->text.size() > line.text.data() + line.text.size()) {
+                    return "word outside its line";
+                }
+            }
+        }
+
+        LyricTimeline timeline = LyricTimeline::fromSynced(document);
+        if (timeline.size() != lines.size() + 1) return "timeline line count";
+        for (size_t i = 0; i < lines.size(); i++) {
+            const LrcDocument::Line &line = lines[i];
+            if (timeline.timeAt(i + 1) != line.timeMs || timeline.textAt(i + 1) != line.text) return "timeline line";
+            if (timeline.wordCountAt(i + 1) != line.wordCount) return "timeline word count";
+            for (size_t w = 0; w < line.wordCount; w++) {
+                const LrcDocument::Word &word = document.wordsBegin(line)[w];
+                if (timeline.wordTextAt(i + 1, w) != word.text ||
+                    timeline.wordTimeAt(i + 1, w) != line.timeMs + word.offsetMs) {
+                    return "timeline word";
+                }
+            }
+        }
+        return nullptr;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    LrcDocument document = LrcDocument::parse(std::string_view(reinterpret_cast<const char *>(data), size));
+    if (checkDocument(document) != nullptr) {
+        std::abort();
+    }
+    return 0;
+}
+
+#ifndef SCROBBLER_LIBFUZZER
+
+#include "tests/Check.h"
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+    /**
+     * @brief Fragments weighted towards what the parser branches on, glued together at random.
+     */
+    std::string tagSoup(std::mt19937 &random) {
+        static const char *const fragments[] = {
+                "[", "]", "<", ">", ":", ".", "\n", "\r\n", " ", "-", "+",
+                "[00:12.34]", "[1:02.5]", "[99:59.999]", "[00:00]", "[12:3", "[offset:+500]", "[offset:-250]",
+                "[offset:9999999]", "[ar:Artist]", "<00:12.50>", "<00:13.1>", "<1:00>", "<00:1", "word", "ことば",
+                "\xF0\x9F\x8E\xB5", "\xE3\x81", "[00:01.00][00:02.00]", "0", "59", "123456789",
+        };
+        std::uniform_int_distribution<size_t> pick(0, sizeof(fragments) / sizeof(fragments[0]) - 1);
+        std::uniform_int_distribution<int> length(0, 64);
+        std::uniform_int_distribution<int> byte(0, 255);
+
+        std::string soup;
+        for (int i = length(random); i > 0; i--) {
+            if (byte(random) < 16) {
+                soup.push_back(static_cast<char>(byte(random)));
+            } else {
+                soup += fragments[pick(random)];
+            }
+        }
+        return soup;
+    }
+
+    void fuzz(std::string_view input) {
+        const char *failure = checkDocument(LrcDocument::parse(input));
+        if (failure != nullptr) {
+            std::fprintf(stderr, "%s on input: %.*s\n", failure, static_cast<int>(input.size()), input.data());
+        }
+        CHECK(failure == nullptr);
+    }
+}
+
+int main() {
+    const char *const seeds[] = {
+            "",
+            "[",
+            "[00:01.00]<00:01.00>",
+            "[00:01.00]<00:01.00>one <00:01.50>two<00:02.00>",
+            "[00:05.00][00:01.00]<00:01.00>repeated <00:01.20>chorus",
+            "[offset:-1000]\n[00:00.50]before zero",
+            "[00:01.00]<00:01.00",
+            "[00:01.00]a<>b<:>c<00:01.x>d",
+    };
+    for (const char *seed: seeds) {
+        fuzz(seed);
+    }
+
+    std::mt19937 random(20260729);
+    const int inputs = 20000;
+    for (int i = 0; i < inputs && checkFailures() == 0; i++) {
+        fuzz(tagSoup(random));
+    }
+    std::printf("lrc parser: %d random inputs checked\n", inputs);
+
+    return checkFailures() == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,96 @@
+// LyricCursor steps through a synced timeline during normal playback and falls back to a binary search only on a
+// seek, a rate change or new lyrics, including new lyrics swapped into the same timeline with the same line count.
+// Line 0 of a synced timeline is the blank lead-in at 0 ms.
+
+#include "include/LrcParser.h"
+#include "include/LyricCursor.h"
+#include "include/LyricTimeline.h"
+#include "tests/Check.h"
+
+namespace {
+    LyricTimeline parse(const char *lrc) {
+        return LyricTimeline::fromSynced(LrcDocument::parse(lrc));
+    }
+
+    void testPlayback() {
+        LyricTimeline lyrics = parse("[00:01.00]one\n[00:03.00]two\n[00:05.00]three\n[00:20.00]four\n");
+        LyricCursor cursor;
+
+        CHECK_EQ(cursor.update(lyrics, 0, 1.0), 0);
+        CHECK_EQ(cursor.getRepositionCount(), 1u);
+        CHECK_EQ(cursor.msUntilNextLine(lyrics, 0), 1000);
+
+        // Ordinary ticks step forward without searching
+        for (int32_t ms = 50; ms <= 5000; ms += 50) {
+            cursor.update(lyrics, ms, 1.0);
+        }
+        CHECK_EQ(cursor.getIndex(), 3);
+        CHECK_EQ(cursor.getRepositionCount(), 1u);
+
+        // Interpolated time a little ahead of the player is pulled back without a search
+        CHECK_EQ(cursor.update(lyrics, 4900, 1.0), 2);
+        CHECK_EQ(cursor.getRepositionCount(), 1u);
+
+        // A jump further than SEEK_THRESHOLD_MS searches
+        CHECK_EQ(cursor.update(lyrics, 21000, 1.0), 4);
+        CHECK_EQ(cursor.getRepositionCount(), 2u);
+        CHECK_EQ(cursor.msUntilNextLine(lyrics, 21000), -1);
+
+        // So does seeking back
+        CHECK_EQ(cursor.update(lyrics, 2000, 1.0), 1);
+        CHECK_EQ(cursor.getRepositionCount(), 3u);
+
+        // And a rate change
+        CHECK_EQ(cursor.update(lyrics, 2050, 2.0), 1);
+        CHECK_EQ(cursor.getRepositionCount(), 4u);
+    }
+
+    void testReplacedInPlace() {
+        LyricTimeline lyrics = parse("[00:01.00]one\n[00:02.00]two\n[00:03.00]three\n");
+        LyricCursor cursor;
+        CHECK_EQ(cursor.update(lyrics, 2500, 1.0), 2);
+
+        // Same object, same number of lines, different times: the old index must not be trusted
+        lyrics = parse("[00:10.00]uno\n[00:20.00]dos\n[00:30.00]tres\n");
+        CHECK_EQ(cursor.update(lyrics, 2550, 1.0), 0);
+        CHECK_EQ(cursor.getRepositionCount(), 2u);
+
+        // Appending to the same timeline counts as new lyrics too
+        lyrics.append(40000, "cuatro");
+        CHECK_EQ(cursor.update(lyrics, 2600, 1.0), 0);
+        CHECK_EQ(cursor.getRepositionCount(), 3u);
+
+        // A copy is the same lyrics, so it keeps stepping
+        LyricTimeline copy = lyrics;
+        cursor.update(copy, 2650, 1.0);
+        CHECK_EQ(cursor.getRepositionCount(), 3u);
+    }
+
+    void testReset() {
+        LyricTimeline lyrics = parse("[00:01.00]one\n[00:02.00]two\n");
+        LyricCursor cursor;
+        cursor.update(lyrics, 1500, 1.0);
+        cursor.update(lyrics, 100, 1.0);
+        CHECK_EQ(cursor.getRepositionCount(), 2u);
+
+        cursor.reset();
+        CHECK_EQ(cursor.getIndex(), -1);
+        CHECK_EQ(cursor.getRepositionCount(), 0u);
+
+        // Nothing carried over, so the same timeline is searched again
+        CHECK_EQ(cursor.update(lyrics, 1600, 1.0), 1);
+        CHECK_EQ(cursor.getRepositionCount(), 1u);
+
+        LyricTimeline empty;
+        CHECK_EQ(cursor.update(empty, 1650, 1.0), -1);
+        CHECK_EQ(cursor.msUntilNextLine(empty, 1650), -1);
+    }
+}
+
+int main() {
+    testPlayback();
+    testReplacedInPlace();
+    testReset();
+
+    return checkFailures() == 0 ? 0 : 1;
+}
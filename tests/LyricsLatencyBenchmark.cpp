@@ -0,0 +1,85 @@
+// Time from a title change to its lyrics being attached, with Last.fm, resolution and lrclib stubbed by fixed
+// delays on the real clock. Before, the loop scrobbled the previous track, resolved the new one on a worker and
+// only then fetched lyrics. Now, for platform metadata, the fetch starts on LyricsManager's fetch pool before the
+// scrobble and its result is posted back to the loop. TrackManager and LyricsManager are Objective-C++, so the
+// title change is replayed here with the same WorkQueue and EventLoop hand-offs they make.
+
+#include "include/Clock.h"
+#include "include/Config.h"
+#include "include/EventLoop.h"
+#include "include/WorkQueue.h"
+#include "tests/Check.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    constexpr int64_t SCROBBLE_MS = 60;
+    constexpr int64_t RESOLVE_MS = 60;
+    constexpr int64_t LYRICS_MS = 60;
+    constexpr int RUNS = 5;
+
+    /**
+     * @param pipelined true to start the lyrics fetch before the previous scrobble, as processTitleChange now does
+     * for platform metadata; false to fetch only once resolution has answered.
+     */
+    int64_t titleChangeToLyrics(bool pipelined) {
+        Clock &clock = Clock::system();
+        EventLoop loop(clock, false);
+        int64_t attachedMs = -1;
+        WorkQueue resolver;
+        WorkQueue fetcher(2);
+
+        auto fetchLyrics = [&] {
+            fetcher.post([&] {
+                clock.sleepMs(LYRICS_MS);
+                loop.post([&] { attachedMs = clock.nowMs(); });
+            });
+        };
+
+        int64_t changedMs = clock.nowMs();
+        loop.post([&] {
+            if (pipelined) fetchLyrics();
+            // The previous track's scrobble blocks the loop, as ScrobbleTracker::finish does
+            clock.sleepMs(SCROBBLE_MS);
+            resolver.post([&] {
+                clock.sleepMs(RESOLVE_MS);
+                loop.post([&] {
+                    if (!pipelined) fetchLyrics();
+                });
+            });
+        });
+
+        while (attachedMs < 0) {
+            loop.runDue();
+            clock.sleepMs(1);
+        }
+        return attachedMs - changedMs;
+    }
+
+    int64_t median(bool pipelined) {
+        std::vector<int64_t> samples;
+        for (int i = 0; i < RUNS; i++) {
+            samples.push_back(titleChangeToLyrics(pipelined));
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+}
+
+int main() {
+    Config::getInstance().setQuietMode(true);
+
+    int64_t sequential = median(false);
+    int64_t pipelined = median(true);
+    std::printf("title change to lyrics: sequential %lld ms, pipelined %lld ms, %lld ms sooner\n",
+                static_cast<long long>(sequential), static_cast<long long>(pipelined),
+                static_cast<long long>(sequential - pipelined));
+
+    // The fetch hides behind the scrobble, so resolution and the fetch itself drop out of the wait
+    CHECK(sequential >= SCROBBLE_MS + RESOLVE_MS + LYRICS_MS);
+    CHECK(pipelined >= std::max(SCROBBLE_MS, LYRICS_MS));
+    CHECK(sequential - pipelined >= RESOLVE_MS);
+
+    return checkFailures() == 0 ? 0 : 1;
+}
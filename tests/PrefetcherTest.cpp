@@ -0,0 +1,165 @@
+// Prefetcher fed by a scripted Up Next source, the way MediaRemote hints it after each title change: no more than
+// MAX_IN_FLIGHT tracks warm at once, a track still listed keeps its job, one that drops off is cancelled, and a
+// freed slot goes to the next track once the loop hears the job finished.
+
+#include "include/CancellationToken.h"
+#include "include/Clock.h"
+#include "include/Config.h"
+#include "include/EventLoop.h"
+#include "include/Prefetcher.h"
+#include "tests/Check.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Hint = Prefetcher::Hint;
+
+    const std::vector<Hint> PLAYLIST{
+            {"Artist A", "Song A", "Album"},
+            {"Artist B", "Song B", "Album"},
+            {"Artist C", "Song C", "Album"},
+            {"Artist D", "Song D", "Album"},
+            {"Artist E", "Song E", "Album"},
+    };
+
+    /**
+     * @brief Up Next as a player reports it: the tracks after currentTitle in the playlist.
+     */
+    std::vector<Hint> upNext(const std::vector<Hint> &playlist, const std::string &currentTitle, int count) {
+        auto it = std::find_if(playlist.begin(), playlist.end(),
+                               [&](const Hint &hint) { return hint.title == currentTitle; });
+        std::vector<Hint> upcoming;
+        if (it == playlist.end()) return upcoming;
+        for (++it; it != playlist.end() && static_cast<int>(upcoming.size()) < count; ++it) {
+            upcoming.push_back(*it);
+        }
+        return upcoming;
+    }
+
+    /**
+     * @brief Stands in for lyrics and resolution: each warm holds its slot until released or cancelled.
+     */
+    class Warmer {
+    public:
+        void warm(const Hint &hint, const CancellationToken &cancel) {
+            int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+            while (!released && !cancel.isCancelled()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                (cancel.isCancelled() ? cancelledTitles : warmedTitles).push_back(hint.title);
+            }
+            --running;
+        }
+
+        std::vector<std::string> warmed() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return warmedTitles;
+        }
+
+        std::vector<std::string> cancelled() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return cancelledTitles;
+        }
+
+        std::atomic<bool> released{false};
+        std::atomic<int> running{0};
+        std::atomic<int> peak{0};
+
+    private:
+        std::mutex mutex;
+        std::vector<std::string> warmedTitles;
+        std::vector<std::string> cancelledTitles;
+    };
+
+    /**
+     * @brief Run the loop until done() holds, as posted finishes arrive from the pool.
+     */
+    void runUntil(EventLoop &loop, const std::function<bool()> &done) {
+        for (int i = 0; i < 2000 && !done(); i++) {
+            loop.runDue();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        loop.runDue();
+    }
+
+    void testScriptedUpNext() {
+        FakeClock clock;
+        EventLoop loop(clock, false);
+        Warmer warmer;
+        // Song B has played before, so it is cached and needs no warming
+        Prefetcher prefetcher(loop, [](const Hint &hint) { return hint.title == "Song B" ? "" : hint.title; },
+                              [&warmer](const Hint &hint, const CancellationToken &cancel) {
+                                  warmer.warm(hint, cancel);
+                              });
+        int ahead = Config::getInstance().getPrefetchAhead();
+
+        // Song A starts: B is skipped, C and D take both slots
+        prefetcher.hintUpcoming(upNext(PLAYLIST, "Song A", ahead));
+        runUntil(loop, [&] { return warmer.running == 2; });
+        CHECK_EQ(prefetcher.getStartedCount(), 2u);
+        CHECK_EQ(prefetcher.getCancelledCount(), 0u);
+
+        // The listener jumps to Song C: D stays listed and keeps its job, C itself is cancelled, E gets the slot
+        prefetcher.hintUpcoming(upNext(PLAYLIST, "Song C", ahead));
+        runUntil(loop, [&] { return prefetcher.getStartedCount() == 3 && warmer.running == 2; });
+        CHECK_EQ(prefetcher.getStartedCount(), 3u);
+        CHECK_EQ(prefetcher.getCancelledCount(), 1u);
+        CHECK(warmer.cancelled() == std::vector<std::string>{"Song C"});
+
+        // Hinting the same list again starts nothing new
+        prefetcher.hintUpcoming(upNext(PLAYLIST, "Song C", ahead));
+        CHECK_EQ(prefetcher.getStartedCount(), 3u);
+
+        warmer.released = true;
+        runUntil(loop, [&] { return warmer.warmed().size() == 2; });
+        std::vector<std::string> warmed = warmer.warmed();
+        std::sort(warmed.begin(), warmed.end());
+        CHECK(warmed == (std::vector<std::string>{"Song D", "Song E"}));
+        CHECK_EQ(warmer.peak.load(), static_cast<int>(Prefetcher::MAX_IN_FLIGHT));
+
+        // Finished jobs are not warmed again, and the end of the playlist hints nothing
+        prefetcher.hintUpcoming(upNext(PLAYLIST, "Song C", ahead));
+        prefetcher.hintUpcoming(upNext(PLAYLIST, "Song E", ahead));
+        loop.runDue();
+        CHECK_EQ(prefetcher.getStartedCount(), 3u);
+        CHECK_EQ(prefetcher.getCancelledCount(), 1u);
+    }
+
+    void testShutdownCancels() {
+        FakeClock clock;
+        EventLoop loop(clock, false);
+        Warmer warmer;
+        {
+            Prefetcher prefetcher(loop, [](const Hint &hint) { return hint.title; },
+                                  [&warmer](const Hint &hint, const CancellationToken &cancel) {
+                                      warmer.warm(hint, cancel);
+                                  });
+            prefetcher.hintUpcoming(upNext(PLAYLIST, "Song A", 3));
+            runUntil(loop, [&] { return warmer.running == 2; });
+        }
+        // The destructor cancelled both running warms and waited for them; the queued one never started
+        CHECK_EQ(warmer.running.load(), 0);
+        CHECK_EQ(warmer.cancelled().size(), 2u);
+        CHECK(warmer.warmed().empty());
+    }
+}
+
+int main() {
+    Config::getInstance().setQuietMode(true);
+    Config::getInstance().setPrefetchAhead(3);
+
+    testScriptedUpNext();
+    testShutdownCancels();
+
+    return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+// RateLimiter against a stub service that enforces its own rate limit, on a fake clock so waits cost no real time.
+
+#include "include/CancellationToken.h"
+#include "include/Clock.h"
+#include "include/Config.h"
+#include "include/Deadline.h"
+#include "include/RateLimiter.h"
+#include "tests/Check.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    /**
+     * @brief Answers like Last.fm: error 29 for any call beyond limit in the trailing second.
+     */
+    class StubService {
+    public:
+        StubService(Clock &clock, size_t limit) : clock(clock), limit(limit) {}
+
+        bool call() {
+            int64_t now = clock.nowMs();
+            while (!window.empty() && window.front() <= now - 1000) {
+                window.pop_front();
+            }
+            calls++;
+            if (window.size() >= limit) {
+                limited++;
+                return false;
+            }
+            window.push_back(now);
+            return true;
+        }
+
+        uint64_t calls = 0;
+        uint64_t limited = 0;
+
+    private:
+        Clock &clock;
+        size_t limit;
+        std::deque<int64_t> window;
+    };
+
+    /**
+     * @brief Only moves when the test advances it; waiters really block, so several can queue at once.
+     */
+    class SteppedClock : public FakeClock {
+    public:
+        void waitFor(std::condition_variable &condition, std::unique_lock<std::mutex> &lock,
+                     int64_t) const override {
+            condition.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    };
+
+    /**
+     * @brief Only moves when the test advances it, and a waiter only wakes early on a notify, so one that
+     * misses its notify sits out the whole real-time timeout.
+     */
+    class NotifiedClock : public FakeClock {
+    public:
+        static constexpr int64_t TIMEOUT_MS = 5000;
+
+        void waitFor(std::condition_variable &condition, std::unique_lock<std::mutex> &lock,
+                     int64_t) const override {
+            condition.wait_for(lock, std::chrono::milliseconds(TIMEOUT_MS));
+        }
+    };
+
+    void testBacksOffFromStubbedLimit() {
+        FakeClock clock;
+        Clock::install(&clock);
+        RateLimiter limiter(5.0, 5.0, clock);
+        StubService service(clock, 3);
+
+        int64_t start = clock.nowMs();
+        for (int i = 0; i < 300; i++) {
+            CHECK(limiter.acquire(RateLimiter::Priority::RESOLUTION));
+            if (service.call()) {
+                limiter.onSuccess();
+            } else {
+                limiter.onRateLimited();
+            }
+        }
+        double seconds = static_cast<double>(clock.nowMs() - start) / 1000.0;
+
+        std::printf("stubbed limit 3/s: %llu calls, %llu limited, %.0f s simulated, final rate %.2f/s\n",
+                    static_cast<unsigned long long>(service.calls), static_cast<unsigned long long>(service.limited),
+                    seconds, limiter.getRate());
+        CHECK_EQ(limiter.getRateLimitedCount(), service.limited);
+        // AIMD keeps rejections rare while still using most of what the service allows
+        CHECK(service.limited * 10 < service.calls);
+        CHECK(300.0 / seconds > 1.5);
+        CHECK(300.0 / seconds <= 3.0 + 0.1);
+        Clock::install(nullptr);
+    }
+
+    void testDeadlineAndCancelOnFakeClock() {
+        FakeClock clock;
+        Clock::install(&clock);
+        RateLimiter limiter(1.0, 1.0, clock);
+        CHECK(limiter.acquire(RateLimiter::Priority::SCROBBLE));
+
+        // Waiting advances the fake clock rather than stalling on real time
+        int64_t start = clock.nowMs();
+        CHECK(!limiter.acquire(RateLimiter::Priority::RESOLUTION, {}, Deadline::after(300)));
+        CHECK(clock.nowMs() - start >= 300);
+        CHECK(clock.nowMs() - start < 1000);
+
+        CancellationToken cancel = CancellationToken::create();
+        cancel.cancel();
+        CHECK(!limiter.acquire(RateLimiter::Priority::RESOLUTION, cancel));
+
+        CHECK(limiter.acquire(RateLimiter::Priority::RESOLUTION));
+        CHECK(clock.nowMs() - start >= 1000);
+        Clock::install(nullptr);
+    }
+
+    void testServesHigherPriorityFirst() {
+        SteppedClock clock;
+        RateLimiter limiter(1.0, 1.0, clock);
+        CHECK(limiter.acquire(RateLimiter::Priority::SCROBBLE));
+
+        std::mutex orderMutex;
+        std::vector<RateLimiter::Priority> order;
+        std::vector<std::thread> waiters;
+        const RateLimiter::Priority arrivals[] = {RateLimiter::Priority::LYRICS_PREFETCH,
+                                                  RateLimiter::Priority::RESOLUTION,
+                                                  RateLimiter::Priority::SCROBBLE};
+        for (RateLimiter::Priority priority: arrivals) {
+            uint64_t queued = limiter.getQueuedCount();
+            waiters.emplace_back([&, priority] {
+                limiter.acquire(priority);
+                std::lock_guard<std::mutex> lock(orderMutex);
+                order.push_back(priority);
+            });
+            while (limiter.getQueuedCount() == queued) {
+                std::this_thread::yield();
+            }
+        }
+
+        for (size_t granted = 1; granted <= 3; granted++) {
+            clock.advance(1000);
+            while (true) {
+                std::lock_guard<std::mutex> lock(orderMutex);
+                if (order.size() >= granted) break;
+            }
+        }
+        for (std::thread &waiter: waiters) {
+            waiter.join();
+        }
+
+        CHECK_EQ(order.size(), 3u);
+        if (order.size() == 3) {
+            CHECK(order[0] == RateLimiter::Priority::SCROBBLE);
+            CHECK(order[1] == RateLimiter::Priority::RESOLUTION);
+            CHECK(order[2] == RateLimiter::Priority::LYRICS_PREFETCH);
+        }
+}
+
+    void testGrantWakesOtherWaiter() {
+        NotifiedClock clock;
+        RateLimiter limiter(1.0, 1.0, clock);
+        CHECK(limiter.acquire(RateLimiter::Priority::SCROBBLE));
+
+        std::atomic<bool> scrobbleGranted{false};
+        std::thread scrobble([&] {
+            scrobbleGranted = limiter.acquire(RateLimiter::Priority::SCROBBLE);
+        });
+        while (limiter.getQueuedCount() == 0) {
+            std::this_thread::yield();
+        }
+
+        // The token comes due while the scrobble sleeps; a prefetch arriving now hands it over but keeps waiting
+        clock.advance(1000);
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<bool> prefetchGranted{false};
+        std::thread prefetch([&] {
+            prefetchGranted = limiter.acquire(RateLimiter::Priority::LYRICS_PREFETCH);
+        });
+        scrobble.join();
+        auto waitedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        CHECK(scrobbleGranted);
+        CHECK(waitedMs < NotifiedClock::TIMEOUT_MS / 2);
+
+        // Same again the other way round: a cancelled caller's grant reaches the sleeping prefetch
+        while (limiter.getQueuedCount() == 1) {
+            std::this_thread::yield();
+        }
+        clock.advance(1000);
+        CancellationToken cancel = CancellationToken::create();
+        cancel.cancel();
+        CHECK(!limiter.acquire(RateLimiter::Priority::LYRICS_PREFETCH, cancel));
+        prefetch.join();
+        CHECK(prefetchGranted);
+    }
+}
+
+int main() {
+    Config::getInstance().setQuietMode(true);
+
+    testBacksOffFromStubbedLimit();
+    testDeadlineAndCancelOnFakeClock();
+    testServesHigherPriorityFirst();
+    testGrantWakesOtherWaiter();
+
+    return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,418 @@
+// Plays scripted listening sessions through the portable components of the playback pipeline on a fake clock:
+// metadata debouncing, scrobble bookkeeping, Now Playing decisions, the lyric cursor, and the
+// durable queue behind a circuit breaker when Last.fm goes away. Hours of playback run in milliseconds.
+
+#include "include/CircuitBreaker.h"
+#include "include/Clock.h"
+#include "include/Config.h"
+#include "include/EventLoop.h"
+#include "include/LrcParser.h"
+#include "include/LyricCursor.h"
+#include "include/LyricTimeline.h"
+#include "include/MetadataDebouncer.h"
+#include "include/NowPlayingPolicy.h"
+#include "include/ScrobbleQueue.h"
+#include "include/ScrobbleTracker.h"
+#include "tests/Check.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Track {
+        std::string artist;
+        std::string title;
+        std::string album;
+        double duration = 0.0;
+    };
+
+    const Track SONG_A{"Artist A", "Song A", "Album A", 200.0};
+    const Track SONG_B{"Artist B", "Song B", "Album B", 180.0};
+    const Track SONG_C{"Artist C", "Song C", "Album C", 300.0};
+
+    /**
+     * @brief Synced lyrics with a line every five seconds of the track.
+     */
+    std::string makeLrc(double duration) {
+        std::string lrc;
+        char tag[32];
+        for (int second = 5; second < static_cast<int>(duration); second += 5) {
+            std::snprintf(tag, sizeof(tag), "[%02d:%02d.00]", second / 60, second % 60);
+            lrc += tag;
+            lrc += "line " + std::to_string(second) + "\n";
+        }
+        return lrc;
+    }
+
+    /**
+     * @brief The now-playing source: what a player would report if asked right now.
+     */
+    struct Player {
+        MetadataDebouncer::Metadata metadata;
+        double duration = 0.0;
+        double elapsed = 0.0;
+        double rate = 0.0;
+        bool repeat = false;
+
+        void advance(int64_t ms) {
+            elapsed += rate * static_cast<double>(ms) / 1000.0;
+            if (duration <= 0.0 || elapsed < duration) return;
+            if (repeat) {
+                elapsed -= duration;
+            } else {
+                elapsed = duration;
+                rate = 0.0;
+            }
+        }
+    };
+
+    /**
+     * @brief Stands in for Last.fm: records what arrives, or refuses everything while down.
+     */
+    struct LastFmStub {
+        bool up = true;
+        uint64_t attempts = 0;
+        std::vector<ScrobbleQueue::Entry> scrobbles;
+        std::vector<std::string> nowPlaying;
+
+        bool scrobble(const ScrobbleQueue::Entry &entry) {
+            attempts++;
+            if (!up) return false;
+            scrobbles.push_back(entry);
+            return true;
+        }
+    };
+
+    /**
+     * @brief The components MediaRemote and TrackManager are built from, wired to a hand-driven loop the way they
+     * wire them. MediaRemote, TrackManager and LastFmScrobbler themselves are Objective-C++ and do not run here;
+     * the scrobble bookkeeping goes through the same ScrobbleTracker::finish() and restart() they call.
+     */
+    class Simulation {
+    public:
+        explicit Simulation(FakeClock &clock)
+                : debouncer(750, clock), policy(clock), breaker("ws.audioscrobbler.com", clock),
+                  loop(clock, false), clock(clock) {
+            pollTimer = loop.createTimer([this] { poll(); });
+            loop.schedule(pollTimer, 1000, 1000);
+            settleTimer = loop.createTimer([this] { notify(); });
+            flushTimer = loop.createTimer([this] { flushQueue(); });
+        }
+
+        void play(const Track &track, bool repeat = false) {
+            player.metadata = {track.artist, track.title, track.album};
+            player.duration = track.duration;
+            player.elapsed = 0.0;
+            player.rate = 1.0;
+            player.repeat = repeat;
+            notify();
+        }
+
+        /**
+         * @brief Like a Now Playing notification: the player's metadata changed.
+         */
+        void notify() {
+            MetadataDebouncer::Verdict verdict = debouncer.observe(player.metadata);
+            if (verdict == MetadataDebouncer::Verdict::SETTLING) {
+                loop.schedule(settleTimer, debouncer.msUntilSettled());
+            } else if (verdict == MetadataDebouncer::Verdict::CHANGED) {
+                changeTrack();
+            }
+        }
+
+        /**
+         * @brief Advance ms of simulated time, waking only for the loop's own deadlines.
+         */
+        void run(int64_t ms) {
+            int64_t end = clock.nowMs() + ms;
+            while (clock.nowMs() < end) {
+                int64_t next = loop.nextDeadline();
+                int64_t target = (next < 0 || next > end) ? end : std::max(next, clock.nowMs() + 1);
+                player.advance(target - clock.nowMs());
+                clock.advance(target - clock.nowMs());
+                loop.runDue();
+            }
+        }
+
+        Player player;
+        LastFmStub lastFm;
+        MetadataDebouncer debouncer;
+        NowPlayingPolicy policy;
+        CircuitBreaker breaker;
+        ScrobbleTracker tracker;
+        EventLoop loop;
+        uint64_t cursorMismatches = 0;
+        uint64_t loops = 0;
+
+    private:
+        void changeTrack() {
+            tracker.finish([this](int64_t startedAt) { return submit(startedAt); });
+            current = debouncer.getCommitted();
+            tracker.start(clock.wallTimeSeconds());
+            timeline = LyricTimeline::fromSynced(LrcDocument::parse(makeLrc(player.duration)));
+            cursor.reset();
+        }
+
+        void poll() {
+            notify();
+            if (current.title.empty()) return;
+
+            NowPlayingPolicy::Observation observation;
+            observation.artist = current.artist;
+            observation.title = current.title;
+            observation.album = current.album;
+            observation.isMusic = true;
+            observation.playbackRate = player.rate;
+            observation.elapsed = player.elapsed;
+            observation.duration = player.duration;
+            observation.scrobbleSettled = tracker.isSubmitted();
+            if (policy.observe(observation) != NowPlayingPolicy::Decision::SKIP) {
+                lastFm.nowPlaying.push_back(current.title);
+            }
+
+            ScrobbleTracker::Event event = tracker.observe(player.elapsed, player.duration, player.rate, true);
+            if (event == ScrobbleTracker::Event::LOOPED) {
+                loops++;
+                tracker.restart(clock.wallTimeSeconds() - static_cast<int64_t>(player.elapsed),
+                                [this](int64_t startedAt) { return submit(startedAt); });
+            }
+
+            auto timeMs = static_cast<int32_t>(player.elapsed * 1000.0);
+            if (cursor.update(timeline, timeMs, player.rate) != expectedLine(timeMs)) {
+                cursorMismatches++;
+            }
+        }
+
+        int expectedLine(int32_t timeMs) const {
+            const std::vector<int32_t> &times = timeline.getTimes();
+            return static_cast<int>(std::upper_bound(times.begin(), times.end(), timeMs) - times.begin()) - 1;
+        }
+
+        /**
+         * @brief New scrobbles join the back of the queue so they reach Last.fm in the order they were played.
+         * Like LastFmScrobbler::scrobble, a queued play counts as taken even while Last.fm is down.
+         */
+        bool submit(int64_t startedAt) {
+            ScrobbleQueue::Entry entry;
+            entry.artist = current.artist;
+            entry.track = current.title;
+            entry.album = current.album;
+            entry.duration = player.duration;
+            entry.timeStamp = startedAt;
+            ScrobbleQueue::getInstance().push(std::move(entry));
+            flushQueue();
+            return true;
+        }
+
+        void flushQueue() {
+            ScrobbleQueue &queue = ScrobbleQueue::getInstance();
+            queue.flush([this](const ScrobbleQueue::Entry &entry) {
+                if (!breaker.allowRequest()) {
+                    return ScrobbleQueue::Result::FAILED;
+                }
+                if (!lastFm.scrobble(entry)) {
+                    breaker.onFailure();
+                    return ScrobbleQueue::Result::FAILED;
+                }
+                breaker.onSuccess();
+                return ScrobbleQueue::Result::SUBMITTED;
+            });
+            if (queue.size() > 0) {
+                loop.schedule(flushTimer, std::max<int64_t>(breaker.msUntilRetry(), 1000));
+            }
+        }
+
+        FakeClock &clock;
+        EventLoop::TimerId pollTimer = 0;
+        EventLoop::TimerId settleTimer = 0;
+        EventLoop::TimerId flushTimer = 0;
+        MetadataDebouncer::Metadata current;
+        LyricTimeline timeline;
+        LyricCursor cursor;
+    };
+
+    int64_t countTitle(const std::vector<std::string> &titles, const std::string &title) {
+        return std::count(titles.begin(), titles.end(), title);
+    }
+
+    void testSkipAfterThreshold(FakeClock &clock) {
+        Simulation sim(clock);
+        int64_t startedAt = clock.wallTimeSeconds();
+        sim.play(SONG_A);
+        sim.run(120 * 1000);
+        sim.play(SONG_B);
+        sim.run(10 * 1000);
+
+        CHECK_EQ(sim.lastFm.scrobbles.size(), 1u);
+        if (!sim.lastFm.scrobbles.empty()) {
+            CHECK_EQ(sim.lastFm.scrobbles[0].track, SONG_A.title);
+            CHECK_EQ(sim.lastFm.scrobbles[0].timeStamp, startedAt);
+        }
+        CHECK_EQ(countTitle(sim.lastFm.nowPlaying, SONG_A.title), 1);
+        CHECK_EQ(countTitle(sim.lastFm.nowPlaying, SONG_B.title), 1);
+        CHECK_EQ(sim.cursorMismatches, 0u);
+    }
+
+    void testShortSkip(FakeClock &clock) {
+        Simulation sim(clock);
+        sim.play(SONG_A);
+        sim.run(30 * 1000);
+        sim.play(SONG_B);
+        sim.run(10 * 1000);
+
+        CHECK(sim.lastFm.scrobbles.empty());
+    }
+
+    void testPauseAndResume(FakeClock &clock) {
+        Simulation sim(clock);
+        sim.play(SONG_C);
+        sim.run(100 * 1000);
+        sim.player.rate = 0.0;
+        sim.run(600 * 1000);
+        CHECK(!sim.tracker.hasCounted());
+        sim.player.rate = 1.0;
+        sim.run(100 * 1000);
+        CHECK(sim.tracker.hasCounted());
+        sim.play(SONG_A);
+        sim.run(10 * 1000);
+
+        CHECK_EQ(sim.lastFm.scrobbles.size(), 1u);
+        // The start, then the resume after a pause that outlasted the status
+        CHECK_EQ(countTitle(sim.lastFm.nowPlaying, SONG_C.title), 2);
+        CHECK_EQ(sim.cursorMismatches, 0u);
+    }
+
+    void testSeekToStart(FakeClock &clock) {
+        Simulation sim(clock);
+        sim.play(SONG_A);
+        sim.run(60 * 1000);
+        sim.player.elapsed = 0.0;
+        sim.run(60 * 1000);
+        CHECK_EQ(sim.loops, 0u);
+        sim.play(SONG_B);
+        sim.run(10 * 1000);
+
+        CHECK(sim.lastFm.scrobbles.empty());
+        CHECK_EQ(sim.cursorMismatches, 0u);
+    }
+
+    void testRepeatOne(FakeClock &clock) {
+        Simulation sim(clock);
+        sim.play(SONG_B, true);
+        sim.run(static_cast<int64_t>(SONG_B.duration * 3 + 30) * 1000);
+
+        CHECK_EQ(sim.loops, 3u);
+        CHECK_EQ(sim.lastFm.scrobbles.size(), 3u);
+        for (size_t i = 1; i < sim.lastFm.scrobbles.size(); i++) {
+            int64_t gap = sim.lastFm.scrobbles[i].timeStamp - sim.lastFm.scrobbles[i - 1].timeStamp;
+            CHECK(gap >= static_cast<int64_t>(SONG_B.duration) - 2 && gap <= static_cast<int64_t>(SONG_B.duration) + 2);
+        }
+        // Each restart is announced again
+        CHECK_EQ(countTitle(sim.lastFm.nowPlaying, SONG_B.title), 4);
+        CHECK_EQ(sim.cursorMismatches, 0u);
+    }
+
+    void testFlappingMetadata(FakeClock &clock) {
+        Simulation sim(clock);
+        sim.play(SONG_A);
+        sim.run(20 * 1000);
+        uint64_t commits = sim.debouncer.getCommitCount();
+
+        sim.player.metadata = {SONG_B.artist, SONG_B.title, SONG_B.album};
+        sim.notify();
+        sim.run(300);
+        sim.player.metadata = {SONG_A.artist, SONG_A.title, SONG_A.album};
+        sim.notify();
+        sim.player.metadata.title.clear();
+        sim.notify();
+        sim.player.metadata.title = SONG_A.title;
+        sim.run(130 * 1000);
+
+        CHECK_EQ(sim.debouncer.getCommitCount(), commits);
+        CHECK_EQ(sim.debouncer.getSuppressedCount(), 1u);
+        CHECK_EQ(sim.debouncer.getFlushedCount(), 1u);
+        CHECK(sim.tracker.hasCounted());
+        CHECK_EQ(countTitle(sim.lastFm.nowPlaying, SONG_B.title), 0);
+        CHECK_EQ(countTitle(sim.lastFm.nowPlaying, SONG_A.title), 1);
+    }
+
+    void testPlaybackRate(FakeClock &clock) {
+        Simulation sim(clock);
+        sim.play(SONG_C);
+        sim.player.rate = 2.0;
+        sim.run(80 * 1000);
+        CHECK(sim.tracker.hasCounted());
+        sim.play(SONG_A);
+        sim.run(10 * 1000);
+
+        CHECK_EQ(sim.lastFm.scrobbles.size(), 1u);
+        CHECK_EQ(sim.cursorMismatches, 0u);
+    }
+
+    void testOutage(FakeClock &clock) {
+        Simulation sim(clock);
+        sim.lastFm.up = false;
+        const Track *playlist[] = {&SONG_A, &SONG_B, &SONG_C, &SONG_A, &SONG_B, &SONG_C};
+        for (const Track *track: playlist) {
+            sim.play(*track);
+            sim.run(static_cast<int64_t>(track->duration * 0.6) * 1000);
+        }
+        // Five played past the threshold; the sixth is still playing
+        CHECK_EQ(ScrobbleQueue::getInstance().size(), 5u);
+        CHECK(sim.breaker.isOpen());
+        uint64_t attemptsWhileDown = sim.lastFm.attempts;
+
+        sim.lastFm.up = true;
+        sim.run(CircuitBreaker::MAX_OPEN_MS + 60 * 1000);
+
+        CHECK_EQ(ScrobbleQueue::getInstance().size(), 0u);
+        CHECK_EQ(sim.lastFm.scrobbles.size(), 5u);
+        for (size_t i = 0; i < sim.lastFm.scrobbles.size(); i++) {
+            CHECK_EQ(sim.lastFm.scrobbles[i].track, playlist[i]->title);
+        }
+        // Fail fast once open rather than one attempt per scrobble per retry
+        CHECK(attemptsWhileDown <= static_cast<uint64_t>(CircuitBreaker::FAILURE_THRESHOLD) + 4);
+    }
+
+    void reportCpuPerHour(FakeClock &clock) {
+        Simulation sim(clock);
+        sim.play(SONG_B, true);
+        std::clock_t begin = std::clock();
+        sim.run(60 * 60 * 1000);
+        double cpuMs = 1000.0 * static_cast<double>(std::clock() - begin) / CLOCKS_PER_SEC;
+
+        std::printf("simulated hour on repeat: %.1f ms CPU, %llu wakeups, %llu timers fired, %zu scrobbles\n",
+                    cpuMs, static_cast<unsigned long long>(sim.loop.getWakeups()),
+                    static_cast<unsigned long long>(sim.loop.getTimersFired()), sim.lastFm.scrobbles.size());
+        CHECK_EQ(sim.lastFm.scrobbles.size(), static_cast<size_t>(3600 / SONG_B.duration));
+        // One poll a second and nothing else
+        CHECK(sim.loop.getWakeups() <= 3600 + 10);
+    }
+}
+
+int main() {
+    Config &config = Config::getInstance();
+    config.setQuietMode(true);
+    std::string queuePath = "simulation_queue.json";
+    std::remove(queuePath.c_str());
+    config.setScrobbleQueuePath(queuePath);
+
+    FakeClock clock(0, 1700000000);
+    Clock::install(&clock);
+
+    testSkipAfterThreshold(clock);
+    testShortSkip(clock);
+    testPauseAndResume(clock);
+    testSeekToStart(clock);
+    testRepeatOne(clock);
+    testFlappingMetadata(clock);
+    testPlaybackRate(clock);
+    testOutage(clock);
+    reportCpuPerHour(clock);
+
+    Clock::install(nullptr);
+    std::remove(queuePath.c_str());
+    return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+// SpeculativeResolver with stub gates and producers on a small pool: a lower-priority candidate that is ready
+// first must wait for the ones above it, and the answer is decided as soon as those have failed, without waiting
+// for anything below it. Jobs still queued when the answer is known never run.
+
+#include "include/CancellationToken.h"
+#include "include/SpeculativeResolver.h"
+#include "include/WorkQueue.h"
+#include "tests/Check.h"
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace {
+    using Resolver = SpeculativeResolver<std::string>;
+
+    /**
+     * @brief Opened by the test; a stub waiting on it gives up if its candidate is cancelled first.
+     */
+    class Latch {
+    public:
+        void open() { opened = true; }
+
+        bool wait(const CancellationToken &cancel) const {
+            while (!opened) {
+                if (cancel.isCancelled()) return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return true;
+        }
+
+    private:
+        std::atomic<bool> opened{false};
+    };
+
+    Resolver::Gate pass() {
+        return [](const CancellationToken &) { return true; };
+    }
+
+    Resolver::Gate fail() {
+        return [](const CancellationToken &) { return false; };
+    }
+
+    Resolver::Gate passWhen(Latch &latch, bool result = true) {
+        return [&latch, result](const CancellationToken &cancel) { return latch.wait(cancel) && result; };
+    }
+
+    Resolver::Producer produce(const std::string &value) {
+        return [value](const CancellationToken &) { return std::optional<std::string>(value); };
+    }
+
+    Resolver::Producer produceNothing() {
+        return [](const CancellationToken &) { return std::optional<std::string>(); };
+    }
+
+    /**
+     * @brief Never succeeds; returns once its candidate is cancelled and records that it was.
+     */
+    Resolver::Producer blockUntilCancelled(std::atomic<bool> &sawCancel) {
+        return [&sawCancel](const CancellationToken &cancel) {
+            Latch never;
+            never.wait(cancel);
+            sawCancel = true;
+            return std::optional<std::string>();
+        };
+    }
+
+    void waitFor(const std::atomic<bool> &flag) {
+        for (int i = 0; i < 2000 && !flag; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void testHigherPriorityWinsTie(WorkQueue &pool) {
+        // The second candidate is good at once, but the first still gets to finish and is preferred
+        Latch firstGate;
+        Resolver resolver(pool);
+        resolver.add({passWhen(firstGate)}, produce("first"));
+        resolver.add({pass()}, produce("second"));
+
+        std::thread opener([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            firstGate.open();
+        });
+        std::optional<std::string> answer = resolver.resolve();
+        opener.join();
+
+        CHECK(answer && *answer == "first");
+    }
+
+    void testDecidedOnceHigherFail(WorkQueue &pool) {
+        // The first fails late, the second is good, the third never finishes: the answer must not wait for it
+        Latch firstGate;
+        std::atomic<bool> thirdCancelled{false};
+        Resolver resolver(pool);
+        resolver.add({passWhen(firstGate, false)}, produce("first"));
+        resolver.add({pass()}, produce("second"));
+        resolver.add({}, blockUntilCancelled(thirdCancelled));
+
+        std::thread opener([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            firstGate.open();
+        });
+        std::optional<std::string> answer = resolver.resolve();
+        opener.join();
+
+        CHECK(answer && *answer == "second");
+        waitFor(thirdCancelled);
+        CHECK(thirdCancelled);
+    }
+
+    void testGateFailureRejectsCandidate(WorkQueue &pool) {
+        // A value alone is not enough; every gate of the candidate has to pass
+        Resolver resolver(pool);
+        resolver.add({pass(), fail()}, produce("first"));
+        resolver.add({pass()}, produceNothing());
+        resolver.add({}, produce("third"));
+
+        std::optional<std::string> answer = resolver.resolve();
+        CHECK(answer && *answer == "third");
+    }
+
+    void testNothingHoldsUp(WorkQueue &pool) {
+        Resolver empty(pool);
+        CHECK(!empty.resolve());
+
+        Resolver resolver(pool);
+        resolver.add({fail()}, produce("first"));
+        resolver.add({}, produceNothing());
+        CHECK(!resolver.resolve());
+    }
+
+    void testCancel(WorkQueue &pool) {
+        std::atomic<bool> sawCancel{false};
+        CancellationToken cancel = CancellationToken::create();
+        Resolver resolver(pool);
+        resolver.add({}, blockUntilCancelled(sawCancel));
+
+        std::thread canceller([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            cancel.cancel();
+        });
+        std::optional<std::string> answer = resolver.resolve(cancel);
+        canceller.join();
+
+        CHECK(!answer);
+        CHECK(sawCancel);
+    }
+
+    void testQueuedJobsSkipped() {
+        // One thread: the first candidate decides the answer before anything below it is picked up
+        WorkQueue pool(1);
+        std::atomic<int> calls{0};
+        auto counted = [&calls](const CancellationToken &) {
+            calls++;
+            return std::optional<std::string>("lower");
+        };
+
+        Resolver resolver(pool);
+        resolver.add({}, produce("first"));
+        resolver.add({pass()}, counted);
+        resolver.add({}, counted);
+
+        std::optional<std::string> answer = resolver.resolve();
+        std::atomic<bool> drained{false};
+        pool.post([&drained] { drained = true; });
+        waitFor(drained);
+
+        CHECK(answer && *answer == "first");
+        CHECK_EQ(calls.load(), 0);
+    }
+}
+
+int main() {
+    // Fewer threads than the jobs of one resolution, so some always queue
+    WorkQueue pool(3);
+
+    testHigherPriorityWinsTie(pool);
+    testDecidedOnceHigherFail(pool);
+    testGateFailureRejectsCandidate(pool);
+    testNothingHoldsUp(pool);
+    testCancel(pool);
+    testQueuedJobsSkipped();
+
+    return checkFailures() == 0 ? 0 : 1;
+}
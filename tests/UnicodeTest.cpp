@@ -0,0 +1,69 @@
+// Unicode::normalize over a corpus of CJK track metadata, checked line by line against golden files, and
+// Unicode::caseFold, which Helper::toLower now goes through.
+//
+// data/cjk_corpus.narrow.golden is what normalizeString's Foundation path produced: NFD, the ICU
+// Fullwidth-Halfwidth transform, NFC, ASCII controls stripped. data/cjk_corpus.nfc.golden is plain NFC with
+// controls stripped. Both were generated from the Unicode 14 character database the tables are built from.
+
+#include "include/Unicode.h"
+#include "tests/Check.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<std::string> readLines(const std::string &name) {
+        std::ifstream file(std::string(SCROBBLER_TEST_DATA) + "/" + name);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    void testGolden(Unicode::Form form, const char *goldenName) {
+        std::vector<std::string> corpus = readLines("cjk_corpus.txt");
+        std::vector<std::string> golden = readLines(goldenName);
+        CHECK(!corpus.empty());
+        CHECK_EQ(corpus.size(), golden.size());
+
+        std::string scratch;
+        for (size_t i = 0; i < corpus.size() && i < golden.size(); i++) {
+            std::string_view normalized = Unicode::normalize(corpus[i], scratch, form);
+            if (normalized != golden[i]) {
+                std::printf("%s line %zu: got \"%.*s\", want \"%s\"\n", goldenName, i + 1,
+                            static_cast<int>(normalized.size()), normalized.data(), golden[i].c_str());
+            }
+            CHECK(normalized == golden[i]);
+        }
+    }
+
+    void testCaseFold() {
+        // ASCII folds exactly as the ::tolower loop it replaced
+        CHECK(Unicode::caseFold("Hikaru UTADA - First Love 1999!") == "hikaru utada - first love 1999!");
+
+        // What ::tolower left alone
+        CHECK(Unicode::caseFold("BJÖRK") == "björk");
+        CHECK(Unicode::caseFold("Ólafur Arnalds") == "ólafur arnalds");
+        CHECK(Unicode::caseFold("ΣΙΓΗ") == "σιγη");
+        CHECK(Unicode::caseFold("КИНО - Группа крови") == "кино - группа крови");
+        CHECK(Unicode::caseFold("ＬｉＳＡ") == "ｌｉｓａ");
+
+        // Scripts without case pass through
+        CHECK(Unicode::caseFold("宇多田ヒカル") == "宇多田ヒカル");
+        CHECK(Unicode::caseFold("방탄소년단") == "방탄소년단");
+
+        // Invalid UTF-8 still lowers its ASCII and keeps the other bytes
+        CHECK(Unicode::caseFold("AB\xff\xfe") == "ab\xff\xfe");
+    }
+}
+
+int main() {
+    testGolden(Unicode::Form::NarrowNFC, "cjk_corpus.narrow.golden");
+    testGolden(Unicode::Form::NFC, "cjk_corpus.nfc.golden");
+    testCaseFold();
+
+    return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+// UrlUtils against a blackhole server: a local listener that completes the TCP handshake and then never answers,
+// the way a wedged Last.fm looks to a client. A request must end at its deadline, or within about a second of
+// being cancelled, however long the peer stays silent. Also Retry-After parsing and the backoff bounds.
+
+#include "include/CancellationToken.h"
+#include "include/Clock.h"
+#include "include/Config.h"
+#include "include/Deadline.h"
+#include "include/UrlUtils.h"
+#include "tests/Check.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace {
+    /**
+     * @brief Listens without ever calling accept(); the kernel still completes connections into the backlog.
+     */
+    class Blackhole {
+    public:
+        Blackhole() {
+            fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&address), length) != 0 || listen(fd, 16) != 0 ||
+                getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+                return;
+            }
+            url = "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port)) + "/2.0/";
+        }
+
+        ~Blackhole() {
+            if (fd >= 0) close(fd);
+        }
+
+        int fd = -1;
+        std::string url;
+    };
+
+    void testDeadline(const Blackhole &server) {
+        Clock &clock = Clock::getInstance();
+        int64_t start = clock.nowMs();
+        ApiResponse response = UrlUtils::sendGetRequest(server.url + "?deadline", nullptr, 3, {},
+                                                        RateLimiter::Priority::RESOLUTION, Deadline::after(1500));
+        int64_t elapsed = clock.nowMs() - start;
+
+        std::printf("blackhole deadline 1500 ms: returned after %lld ms\n", static_cast<long long>(elapsed));
+        CHECK(!response.ok());
+        CHECK(UrlUtils::lastFailureWasTransient());
+        CHECK(elapsed >= 1400);
+        CHECK(elapsed < 2500);
+    }
+
+    void testCancel(const Blackhole &server) {
+        Clock &clock = Clock::getInstance();
+        CancellationToken cancel = CancellationToken::create();
+        int64_t returnedMs = 0;
+        std::thread request([&] {
+            UrlUtils::sendGetRequest(server.url + "?cancel", nullptr, 3, cancel);
+            returnedMs = clock.nowMs();
+        });
+
+        clock.sleepMs(500);
+        int64_t cancelledMs = clock.nowMs();
+        cancel.cancel();
+        request.join();
+        int64_t latency = returnedMs - cancelledMs;
+
+        std::printf("blackhole cancel: returned %lld ms after cancel\n", static_cast<long long>(latency));
+        // curl checks the progress callback at least once a second even on a silent connection
+        CHECK(latency < 1500);
+    }
+
+    /**
+     * @brief A caller that joins a flight must see the failure the flight's owner saw, not its own thread's leftovers.
+     */
+    void testJoinerSeesFailure() {
+        UrlUtils::setTransport([](const std::string &, const std::string *, std::string &response) {
+            Clock::getInstance().sleepMs(300);
+            response = R"({"error":29,"message":"Rate Limit Exceeded"})";
+            return CURLE_OK;
+        });
+        uint64_t coalesced = UrlUtils::getCoalescedRequests();
+
+        const std::string url = "http://127.0.0.1:1/2.0/?flight";
+        int ownerCode = 0;
+        std::thread owner([&] {
+            UrlUtils::sendGetRequest(url, nullptr, 1);
+            ownerCode = UrlUtils::getLastErrorCode();
+        });
+        Clock::getInstance().sleepMs(100);
+        ApiResponse joined = UrlUtils::sendGetRequest(url, nullptr, 1);
+        owner.join();
+
+        CHECK_EQ(UrlUtils::getCoalescedRequests(), coalesced + 1);
+        CHECK(!joined.ok());
+        CHECK_EQ(ownerCode, 29);
+        CHECK_EQ(UrlUtils::getLastErrorCode(), 29);
+        CHECK(UrlUtils::lastFailureWasTransient());
+
+        // Another priority class runs its own request instead of joining
+        std::thread prefetch([&] {
+            UrlUtils::sendGetRequest(url, nullptr, 1, {}, RateLimiter::Priority::LYRICS_PREFETCH);
+        });
+        Clock::getInstance().sleepMs(100);
+        UrlUtils::sendGetRequest(url, nullptr, 1);
+        prefetch.join();
+        CHECK_EQ(UrlUtils::getCoalescedRequests(), coalesced + 1);
+
+        UrlUtils::setTransport(nullptr);
+    }
+
+    void testRetryAfter() {
+        FakeClock clock(0, 1445412480); // Wed, 21 Oct 2015 07:28:00 GMT
+        Clock::install(&clock);
+
+        CHECK_EQ(UrlUtils::parseRetryAfter(" 5\r\n"), 5000);
+        CHECK_EQ(UrlUtils::parseRetryAfter("0"), 0);
+        CHECK_EQ(UrlUtils::parseRetryAfter("Wed, 21 Oct 2015 07:28:20 GMT"), 20000);
+        CHECK_EQ(UrlUtils::parseRetryAfter("Wed, 21 Oct 2015 07:27:00 GMT"), 0);
+        CHECK_EQ(UrlUtils::parseRetryAfter("soon"), -1);
+        CHECK_EQ(UrlUtils::parseRetryAfter("  "), -1);
+
+        // However long the server asks for, a retry waits at most MAX_BACKOFF_MS
+        CHECK_EQ(UrlUtils::parseRetryAfter("3600"), UrlUtils::MAX_BACKOFF_MS);
+        CHECK_EQ(UrlUtils::parseRetryAfter("99999999999"), UrlUtils::MAX_BACKOFF_MS);
+        CHECK_EQ(UrlUtils::parseRetryAfter("Wed, 21 Oct 2015 09:28:00 GMT"), UrlUtils::MAX_BACKOFF_MS);
+
+        Clock::install(nullptr);
+    }
+
+    void testBackoffJitter() {
+        int64_t delay = UrlUtils::BASE_BACKOFF_MS;
+        bool varied = false;
+        for (int i = 0; i < 1000; i++) {
+            int64_t next = UrlUtils::nextBackoff(delay);
+            CHECK(next >= UrlUtils::BASE_BACKOFF_MS);
+            CHECK(next <= std::min(delay * 3, UrlUtils::MAX_BACKOFF_MS));
+            varied = varied || next != UrlUtils::nextBackoff(delay);
+            // Start over now and then so the low end of the ladder is sampled as often as the cap
+            delay = i % 10 == 9 ? UrlUtils::BASE_BACKOFF_MS : next;
+        }
+        CHECK(varied);
+        CHECK(UrlUtils::nextBackoff(UrlUtils::MAX_BACKOFF_MS) <= UrlUtils::MAX_BACKOFF_MS);
+    }
+}
+
+int main() {
+    Config::getInstance().setQuietMode(true);
+
+    Blackhole server;
+    CHECK(!server.url.empty());
+    if (server.url.empty()) {
+        return 1;
+    }
+
+    testDeadline(server);
+    testCancel(server);
+    testJoinerSeesFailure();
+    testRetryAfter();
+    testBackoffJitter();
+
+    return checkFailures() == 0 ? 0 : 1;
+}